@@ -0,0 +1,219 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////
+// Microbenchmark for NumberParser against the C library calls
+// the OBJ loader used to make (atof / atoi). Every number in
+// the bundled models is parsed both ways, the results are
+// checked for bit-exact equality, and the timings are printed.
+// Numbers too long for the parser's stack buffer are checked
+// against strtod as well.
+//
+// Build and run from the build directory:
+//     make bench && ./bench.exe
+//////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////
+// Headers
+//////////////////////////////////////////////////////////////
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "NumberParser.hpp"
+
+#define BENCH_REPEAT_COUNT 50
+
+struct NumberList
+{
+    std::string      text;
+    std::vector<int> floats;
+    std::vector<int> ints;
+};
+
+//////////////////////////////////////////////////////////////
+static bool loadNumbers(const std::string & filename, NumberList & numbers)
+{
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!file)
+        return false;
+
+    std::stringstream contents;
+    contents << file.rdbuf();
+    numbers.text = contents.str();
+
+    // Record where every number starts, split into the scalars of
+    // v/vt/vn/Ns/Kd/Ks records and the indices of f records.
+    const char * text = numbers.text.c_str();
+    size_t lineStart = 0;
+
+    while (lineStart < numbers.text.size())
+    {
+        size_t lineEnd = numbers.text.find('\n', lineStart);
+        if (lineEnd == std::string::npos)
+            lineEnd = numbers.text.size();
+
+        const char * line = text + lineStart;
+        bool isFace   = strncmp(line, "f ", 2) == 0;
+        bool isScalar = strncmp(line, "v ", 2) == 0 || strncmp(line, "vt ", 3) == 0 ||
+                        strncmp(line, "vn ", 3) == 0 || strncmp(line, "Ns ", 3) == 0 ||
+                        strncmp(line, "Kd ", 3) == 0 || strncmp(line, "Ks ", 3) == 0;
+
+        if (isFace || isScalar)
+        {
+            size_t position = numbers.text.find(' ', lineStart);
+
+            while (position < lineEnd)
+            {
+                char c = text[position];
+                bool startsNumber = (c >= '0' && c <= '9') || c == '-' || c == '.';
+
+                if (startsNumber && (text[position - 1] == ' ' || text[position - 1] == '/'))
+                    (isFace ? numbers.ints : numbers.floats).push_back((int)position);
+
+                ++position;
+            }
+        }
+
+        lineStart = lineEnd + 1;
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////
+template <typename Function>
+static double measure(const Function & function)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (int count = 0; count < BENCH_REPEAT_COUNT; ++count)
+        function();
+
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+//////////////////////////////////////////////////////////////
+static void benchmark(const std::string & filename)
+{
+    NumberList numbers;
+    if (!loadNumbers(filename, numbers))
+    {
+        printf("Could not open %s\n", filename.c_str());
+        return;
+    }
+
+    const char * text = numbers.text.c_str();
+    const char * end  = text + numbers.text.size();
+
+    std::vector<float> libraryFloats(numbers.floats.size()), parserFloats(numbers.floats.size());
+    std::vector<long>  libraryInts(numbers.ints.size()),     parserInts(numbers.ints.size());
+
+    double libraryTime = measure([&]()
+    {
+        for (size_t index = 0; index < numbers.floats.size(); ++index)
+            libraryFloats[index] = (float) atof(text + numbers.floats[index]);
+
+        for (size_t index = 0; index < numbers.ints.size(); ++index)
+            libraryInts[index] = atoi(text + numbers.ints[index]);
+    });
+
+    double parserTime = measure([&]()
+    {
+        for (size_t index = 0; index < numbers.floats.size(); ++index)
+            ce::NumberParser::parseFloat(text + numbers.floats[index], end, parserFloats[index]);
+
+        for (size_t index = 0; index < numbers.ints.size(); ++index)
+            ce::NumberParser::parseInt(text + numbers.ints[index], end, parserInts[index]);
+    });
+
+    bool identical = memcmp(&libraryFloats[0], &parserFloats[0], libraryFloats.size() * sizeof(float)) == 0 &&
+                     libraryInts == parserInts;
+
+    size_t numberCount = (numbers.floats.size() + numbers.ints.size()) * BENCH_REPEAT_COUNT;
+
+    printf("%s\n", filename.c_str());
+    printf("    %zu scalars, %zu indices, results %s\n", numbers.floats.size(), numbers.ints.size(),
+           identical ? "identical" : "DIFFERENT");
+    printf("    atof/atoi:    %8.2f ms (%6.2f ns per number)\n", libraryTime, libraryTime * 1e6 / numberCount);
+    printf("    NumberParser: %8.2f ms (%6.2f ns per number)\n", parserTime,  parserTime  * 1e6 / numberCount);
+    printf("    speedup:      %8.2fx\n", libraryTime / parserTime);
+}
+
+//////////////////////////////////////////////////////////////
+static void checkLongNumbers()
+{
+    // Long mantissas and zero padded exponents, as some exporters
+    // write them, on both sides of CE_NUMBER_PARSER_MAX_LENGTH.
+    std::vector<std::string> numbers;
+
+    for (size_t length = CE_NUMBER_PARSER_MAX_LENGTH - 8; length <= 2 * CE_NUMBER_PARSER_MAX_LENGTH + 8; ++length)
+    {
+        numbers.push_back("0." + std::string(length, '3'));
+        numbers.push_back("-1" + std::string(length, '0') + "e-" + std::to_string(length));
+        numbers.push_back("1.25e-" + std::string(length, '0') + "3");
+        numbers.push_back("7." + std::string(length, '9') + "E+" + std::string(length, '0') + "12");
+    }
+
+    size_t mismatches = 0;
+
+    for (const std::string & number : numbers)
+    {
+        // Something after the number, so that the end has to be found.
+        std::string text = number + " 1.0\n";
+        const char * begin = text.c_str();
+
+        char * libraryEnd;
+        double libraryValue = strtod(begin, &libraryEnd);
+        double parserValue;
+        const char * parserEnd = ce::NumberParser::parseDouble(begin, begin + text.size(), parserValue);
+
+        if (memcmp(&libraryValue, &parserValue, sizeof(double)) != 0 || parserEnd != libraryEnd)
+            ++mismatches;
+    }
+
+    printf("long numbers\n");
+    printf("    %zu numbers, %zu different from strtod\n", numbers.size(), mismatches);
+}
+
+//////////////////////////////////////////////////////////////
+int main()
+{
+    checkLongNumbers();
+
+    benchmark("../resources/models/nanosuit/nanosuit.obj");
+    benchmark("../resources/models/nanosuit/nanosuit.mtl");
+    benchmark("../resources/models/blacksmith/blacksmith.obj");
+    benchmark("../resources/models/blacksmith/blacksmith.mtl");
+
+    return 0;
+}
@@ -0,0 +1,147 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_ASSET_CACHE_HPP
+#define CE_ASSET_CACHE_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <cstdint>
+#include <cstdlib>
+#include <climits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "Hash.hpp"
+#include "MappedFile.hpp"
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief Returns the absolute path of a file with . and .. (and
+// on POSIX, symbolic links) resolved, so that every way of naming
+// a file gives the same string. Files that can't be resolved are
+// returned as they are.
+//
+////////////////////////////////////////////////////////////////
+inline std::string getCanonicalPath(const std::string & filename)
+{
+#ifdef _WIN32
+    char path[_MAX_PATH];
+
+    if (_fullpath(path, filename.c_str(), _MAX_PATH) != nullptr)
+        return std::string(path);
+#else
+    char path[PATH_MAX];
+
+    if (realpath(filename.c_str(), path) != nullptr)
+        return std::string(path);
+#endif
+
+    return filename;
+}
+
+////////////////////////////////////////////////////////////////
+// \brief Hashes the contents of a file, returns false when it
+// can't be read.
+//
+////////////////////////////////////////////////////////////////
+inline bool hashFile(const std::string & filename, uint64_t & hash)
+{
+    MappedFile file(filename);
+
+    if (!file.isOpen())
+        return false;
+
+    hash = hashBytes(file.getData(), file.getSize());
+    return true;
+}
+
+////////////////////////////////////////////////////////////////
+// \brief Finds assets that are still in use by key. Along with
+// every asset the hash of the content it was made from is kept,
+// and an asset is only found again if that content is unchanged.
+//
+// The cache doesn't keep assets alive: it holds weak references,
+// and reference counting is left to the shared pointers handed
+// out, whose deleters should call release().
+//
+////////////////////////////////////////////////////////////////
+template <typename Asset>
+class AssetCache
+{
+    public:
+        ////////////////////////////////////////////////////////////
+        std::shared_ptr<Asset> find(const std::string & key, const uint64_t hash) const
+        {
+            auto entry = m_entries.find(key);
+
+            if (entry == m_entries.end() || entry->second.hash != hash)
+                return std::shared_ptr<Asset>();
+
+            return entry->second.asset.lock();
+        }
+
+        ////////////////////////////////////////////////////////////
+        void insert(const std::string & key, const uint64_t hash, const std::shared_ptr<Asset> & asset)
+        {
+            Entry & entry = m_entries[key];
+            entry.hash  = hash;
+            entry.asset = asset;
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Forgets the asset under key once its last reference is
+        // gone. An asset that replaced it under the same key after
+        // its content changed is kept.
+        ////////////////////////////////////////////////////////////
+        void release(const std::string & key)
+        {
+            auto entry = m_entries.find(key);
+
+            if (entry != m_entries.end() && entry->second.asset.expired())
+                m_entries.erase(entry);
+        }
+
+        size_t getSize() const { return m_entries.size(); }
+
+    private:
+        struct Entry
+        {
+            uint64_t             hash;
+            std::weak_ptr<Asset> asset;
+        };
+
+        std::unordered_map<std::string, Entry> m_entries;
+};
+
+} // namespace ce
+
+#endif
@@ -0,0 +1,151 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_HASH_HPP
+#define CE_HASH_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+namespace ce
+{
+
+#define CE_HASH_PRIME1 0x9E3779B185EBCA87ULL
+#define CE_HASH_PRIME2 0xC2B2AE3D27D4EB4FULL
+#define CE_HASH_PRIME3 0x165667B19E3779F9ULL
+#define CE_HASH_PRIME4 0x85EBCA77C2B2AE63ULL
+#define CE_HASH_PRIME5 0x27D4EB2F165667C5ULL
+
+////////////////////////////////////////////////////////////////
+inline uint64_t rotateLeft(const uint64_t value, const int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+////////////////////////////////////////////////////////////////
+// \brief Mixes one 64 bit word into an accumulator, so that every
+// bit of the word reaches every bit of the accumulator.
+////////////////////////////////////////////////////////////////
+inline uint64_t hashRound(uint64_t accumulator, const uint64_t word)
+{
+    accumulator += word * CE_HASH_PRIME2;
+    accumulator  = rotateLeft(accumulator, 31);
+
+    return accumulator * CE_HASH_PRIME1;
+}
+
+////////////////////////////////////////////////////////////////
+inline uint64_t hashMergeRound(uint64_t hash, const uint64_t accumulator)
+{
+    hash ^= hashRound(0, accumulator);
+
+    return hash * CE_HASH_PRIME1 + CE_HASH_PRIME4;
+}
+
+////////////////////////////////////////////////////////////////
+// \brief Hashes a block of memory into 64 bits.
+//
+// This is xxHash64, which reads four independent 64 bit lanes at
+// a time and runs close to memory speed. Chained hashes pass the
+// previous one as the seed. It is meant for detecting changed or
+// duplicate content, not for security.
+//
+////////////////////////////////////////////////////////////////
+inline uint64_t hashBytes(const void * data, const size_t size, const uint64_t seed = 0)
+{
+    const unsigned char * p   = (const unsigned char *) data;
+    const unsigned char * end = p + size;
+    uint64_t hash;
+
+    if (size >= 32)
+    {
+        uint64_t lanes[4] = { seed + CE_HASH_PRIME1 + CE_HASH_PRIME2, seed + CE_HASH_PRIME2, seed, seed - CE_HASH_PRIME1 };
+
+        for (; end - p >= 32; p += 32)
+        {
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                uint64_t word;
+                memcpy(&word, p + 8 * lane, 8);
+                lanes[lane] = hashRound(lanes[lane], word);
+            }
+        }
+
+        hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18);
+
+        for (int lane = 0; lane < 4; ++lane)
+            hash = hashMergeRound(hash, lanes[lane]);
+    }
+    else
+    {
+        hash = seed + CE_HASH_PRIME5;
+    }
+
+    hash += (uint64_t) size;
+
+    for (; end - p >= 8; p += 8)
+    {
+        uint64_t word;
+        memcpy(&word, p, 8);
+
+        hash ^= hashRound(0, word);
+        hash  = rotateLeft(hash, 27) * CE_HASH_PRIME1 + CE_HASH_PRIME4;
+    }
+
+    if (end - p >= 4)
+    {
+        uint32_t word;
+        memcpy(&word, p, 4);
+
+        hash ^= (uint64_t) word * CE_HASH_PRIME1;
+        hash  = rotateLeft(hash, 23) * CE_HASH_PRIME2 + CE_HASH_PRIME3;
+        p += 4;
+    }
+
+    for (; p < end; ++p)
+    {
+        hash ^= *p * CE_HASH_PRIME5;
+        hash  = rotateLeft(hash, 11) * CE_HASH_PRIME1;
+    }
+
+    // Final avalanche.
+    hash ^= hash >> 33;
+    hash *= CE_HASH_PRIME2;
+    hash ^= hash >> 29;
+    hash *= CE_HASH_PRIME3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+} // namespace ce
+
+#endif
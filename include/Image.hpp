@@ -32,17 +32,20 @@
 // Headers
 ////////////////////////////////////////////////////////////////
 #include <vector>
-#include <fstream>
 
 #include "picoPNG.hpp"
+#include "Qoi.hpp"
+#include "LinearArena.hpp"
 #include "Logger.hpp"
+#include "MappedFile.hpp"
 
 namespace ce
 {
 
 ////////////////////////////////////////////////////////////////
-// \brief Loads a PNG image into a vector that can be used
-// for texture mapping.
+// \brief Loads a PNG or QOI image into a vector that can be used
+// for texture mapping. The format is told apart by the first
+// bytes of the data, not by the file's extension.
 //
 ////////////////////////////////////////////////////////////////
 class Image
@@ -50,47 +53,56 @@ class Image
     public:
         ////////////////////////////////////////////////////////////////
         Image()
+            : m_width(0), m_height(0)
         { }
 
         ////////////////////////////////////////////////////////////////
         Image(const std::string & filename)
+            : m_width(0), m_height(0)
         {
             loadFromFile(filename);
         }
 
         ////////////////////////////////////////////////////////////////
-        void loadFromFile(const std::string & filename)
+        // \brief Decodes the file straight from a mapping of it, so no
+        // read buffer is allocated. The decoder's temporaries come from
+        // the scratch arena when one is given.
+        ////////////////////////////////////////////////////////////////
+        void loadFromFile(const std::string & filename, LinearArena * scratch=nullptr)
         {
             LOG("Reading image: " + filename);
-            std::vector<unsigned char> buffer;
-
-            std::ifstream file(filename.c_str(), 
-                std::ios::in|std::ios::binary|std::ios::ate);
-
-            ///////////////////////////////
-            // Get the filesize
-            ///////////////////////////////
-            std::streamsize size = 0;
-            if(file.seekg(0, std::ios::end).good()) 
-                size = file.tellg();
-            if (file.seekg(0, std::ios::beg).good())
-                size -= file.tellg();
-
-            //////////////////////////////////
-            // Read the contents of the file
-            //////////////////////////////////
-            if (size > 0)
+            MappedFile file(filename);
+
+            loadFromMemory((const unsigned char *) file.getData(), file.getSize(), scratch);
+        }
+
+        ////////////////////////////////////////////////////////////////
+        void loadFromMemory(const unsigned char * data, const size_t & size, LinearArena * scratch=nullptr)
+        {
+            if (isQoi(data, size))
             {
-                buffer.resize((size_t)size);
-                file.read((char*)(&buffer[0]), size);
+                if (!decodeQoi(data, size, m_image, m_width, m_height))
+                {
+                    LOG("Error occurred while decoding the QOI image.");
+                    m_image.clear();
+                }
+                else
+                {
+                    LOG("Image size: " + std::to_string(m_width) + ", "
+                                       + std::to_string(m_height));
+                }
+
+                return;
             }
-            else
-                buffer.clear();
 
-            int error = decodePNG(m_image, m_width, m_height, buffer.empty() ? 0 : &buffer[0], (unsigned long)buffer.size());
+            int error = decodePNG(m_image, m_width, m_height, data, (unsigned long)size, true, scratch);
 
+            // A failed decode can leave part of an image behind.
             if (error != 0)
+            {
                 LOG("Error occurred while decoding the PNG. (error: " + std::to_string(error) + ")");
+                m_image.clear();
+            }
             else
             {
                 LOG("Image size: " + std::to_string(m_width) + ", "
@@ -98,6 +110,17 @@ class Image
             }
         }
 
+        ////////////////////////////////////////////////////////////////
+        // \brief Takes over RGBA pixels that were made rather than
+        // decoded, row by row from the first in memory.
+        ////////////////////////////////////////////////////////////////
+        void create(const unsigned long & width, const unsigned long & height, std::vector<unsigned char> && pixels)
+        {
+            m_image  = std::move(pixels);
+            m_width  = width;
+            m_height = height;
+        }
+
         ////////////////////////////////////////////////////////////////
         std::vector<unsigned char> & getImageBuffer()
         {
@@ -0,0 +1,331 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_JSON_HPP
+#define CE_JSON_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <string>
+#include <vector>
+#include <cstring>
+
+#include "NumberParser.hpp"
+
+// Deeper documents are rejected rather than overflowing the stack.
+#define CE_JSON_MAX_DEPTH 64
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief A parsed JSON document, for reading the few JSON based
+// asset formats.
+//
+// Looking up a missing member or an element out of range gives a
+// null value instead of failing, so optional properties can be
+// read with a fallback in one expression:
+//
+//     int material = primitive["material"].getInt(-1);
+//
+////////////////////////////////////////////////////////////////
+class JsonValue
+{
+    public:
+        enum Type
+        {
+            JSON_NULL,
+            JSON_BOOL,
+            JSON_NUMBER,
+            JSON_STRING,
+            JSON_ARRAY,
+            JSON_OBJECT
+        };
+
+        JsonValue()
+            : m_type(JSON_NULL), m_number(0.0)
+        { }
+
+        static bool parse(const char * begin, const char * end, JsonValue & value);
+
+        Type getType() const { return m_type; }
+        bool isNull() const { return m_type == JSON_NULL; }
+
+        double getNumber(const double & fallback=0.0) const { return m_type == JSON_NUMBER ? m_number : fallback; }
+        int getInt(const int & fallback=0) const { return m_type == JSON_NUMBER ? (int) m_number : fallback; }
+        bool getBool(const bool & fallback=false) const { return m_type == JSON_BOOL ? m_number != 0.0 : fallback; }
+        const std::string & getString() const { return m_string; }
+
+        // Elements of an array, or members of an object.
+        size_t getSize() const { return m_elements.size(); }
+        const JsonValue & operator[] (const size_t & index) const;
+        const JsonValue & operator[] (const char * key) const;
+
+    private:
+        static const char * skipWhitespace(const char * p, const char * end);
+        static const char * parseValue(const char * p, const char * end, JsonValue & value, const int depth);
+        static const char * parseString(const char * p, const char * end, std::string & value);
+
+        ////////////////////////////////////////////////////////////////
+        // Member data
+        ////////////////////////////////////////////////////////////////
+        Type                     m_type;
+        double                   m_number; // Also holds booleans
+        std::string              m_string;
+        std::vector<std::string> m_keys;     // Object member names
+        std::vector<JsonValue>   m_elements; // Array elements or object member values
+};
+
+////////////////////////////////////////////////////////////////
+inline const JsonValue & JsonValue::operator[] (const size_t & index) const
+{
+    static const JsonValue null;
+    return (m_type == JSON_ARRAY && index < m_elements.size()) ? m_elements[index] : null;
+}
+
+////////////////////////////////////////////////////////////////
+inline const JsonValue & JsonValue::operator[] (const char * key) const
+{
+    static const JsonValue null;
+
+    for (size_t count = 0; m_type == JSON_OBJECT && count < m_keys.size(); ++count)
+    {
+        if (m_keys[count] == key)
+            return m_elements[count];
+    }
+
+    return null;
+}
+
+////////////////////////////////////////////////////////////////
+inline bool JsonValue::parse(const char * begin, const char * end, JsonValue & value)
+{
+    value = JsonValue();
+
+    const char * p = parseValue(skipWhitespace(begin, end), end, value, 0);
+
+    if (p == nullptr || skipWhitespace(p, end) != end)
+    {
+        value = JsonValue();
+        return false;
+    }
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////
+inline const char * JsonValue::skipWhitespace(const char * p, const char * end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+        ++p;
+
+    return p;
+}
+
+////////////////////////////////////////////////////////////////
+inline const char * JsonValue::parseString(const char * p, const char * end, std::string & value)
+{
+    if (p == end || *p != '"')
+        return nullptr;
+
+    value.clear();
+    ++p;
+
+    while (p < end && *p != '"')
+    {
+        if (*p != '\\')
+        {
+            value += *p++;
+            continue;
+        }
+
+        if (++p == end)
+            return nullptr;
+
+        switch (*p++)
+        {
+            case '"':  value += '"';  break;
+            case '\\': value += '\\'; break;
+            case '/':  value += '/';  break;
+            case 'b':  value += '\b'; break;
+            case 'f':  value += '\f'; break;
+            case 'n':  value += '\n'; break;
+            case 'r':  value += '\r'; break;
+            case 't':  value += '\t'; break;
+            case 'u':
+            {
+                if (end - p < 4)
+                    return nullptr;
+
+                unsigned int code = 0;
+
+                for (int digit = 0; digit < 4; ++digit, ++p)
+                {
+                    char c = *p;
+                    code <<= 4;
+
+                    if (c >= '0' && c <= '9')      code |= c - '0';
+                    else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+                    else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+                    else return nullptr;
+                }
+
+                // Encode as UTF-8. Surrogate pairs are kept as two
+                // separate code points, which asset names never need.
+                if (code < 0x80)
+                {
+                    value += (char) code;
+                }
+                else if (code < 0x800)
+                {
+                    value += (char)(0xC0 | (code >> 6));
+                    value += (char)(0x80 | (code & 0x3F));
+                }
+                else
+                {
+                    value += (char)(0xE0 | (code >> 12));
+                    value += (char)(0x80 | ((code >> 6) & 0x3F));
+                    value += (char)(0x80 | (code & 0x3F));
+                }
+
+                break;
+            }
+            default:
+                return nullptr;
+        }
+    }
+
+    return p < end ? p + 1 : nullptr;
+}
+
+////////////////////////////////////////////////////////////////
+inline const char * JsonValue::parseValue(const char * p, const char * end, JsonValue & value, const int depth)
+{
+    if (p == end || depth > CE_JSON_MAX_DEPTH)
+        return nullptr;
+
+    switch (*p)
+    {
+        case '{':
+        {
+            value.m_type = JSON_OBJECT;
+            p = skipWhitespace(p + 1, end);
+
+            if (p < end && *p == '}')
+                return p + 1;
+
+            for (;;)
+            {
+                value.m_keys.push_back(std::string());
+                value.m_elements.push_back(JsonValue());
+
+                p = parseString(p, end, value.m_keys.back());
+                if (p == nullptr)
+                    return nullptr;
+
+                p = skipWhitespace(p, end);
+                if (p == end || *p != ':')
+                    return nullptr;
+
+                p = parseValue(skipWhitespace(p + 1, end), end, value.m_elements.back(), depth + 1);
+                if (p == nullptr)
+                    return nullptr;
+
+                p = skipWhitespace(p, end);
+                if (p < end && *p == ',')
+                    p = skipWhitespace(p + 1, end);
+                else if (p < end && *p == '}')
+                    return p + 1;
+                else
+                    return nullptr;
+            }
+        }
+        case '[':
+        {
+            value.m_type = JSON_ARRAY;
+            p = skipWhitespace(p + 1, end);
+
+            if (p < end && *p == ']')
+                return p + 1;
+
+            for (;;)
+            {
+                value.m_elements.push_back(JsonValue());
+
+                p = parseValue(p, end, value.m_elements.back(), depth + 1);
+                if (p == nullptr)
+                    return nullptr;
+
+                p = skipWhitespace(p, end);
+                if (p < end && *p == ',')
+                    p = skipWhitespace(p + 1, end);
+                else if (p < end && *p == ']')
+                    return p + 1;
+                else
+                    return nullptr;
+            }
+        }
+        case '"':
+            value.m_type = JSON_STRING;
+            return parseString(p, end, value.m_string);
+        case 't':
+        case 'f':
+        case 'n':
+        {
+            static const char * const keywords[] = { "true", "false", "null" };
+
+            for (int keyword = 0; keyword < 3; ++keyword)
+            {
+                size_t length = strlen(keywords[keyword]);
+
+                if ((size_t)(end - p) >= length && memcmp(p, keywords[keyword], length) == 0)
+                {
+                    value.m_type   = keyword < 2 ? JSON_BOOL : JSON_NULL;
+                    value.m_number = keyword == 0 ? 1.0 : 0.0;
+                    return p + length;
+                }
+            }
+
+            return nullptr;
+        }
+        default:
+        {
+            const char * numberEnd = NumberParser::parseDouble(p, end, value.m_number);
+
+            if (numberEnd == p)
+                return nullptr;
+
+            value.m_type = JSON_NUMBER;
+            return numberEnd;
+        }
+    }
+}
+
+} // namespace ce
+
+#endif
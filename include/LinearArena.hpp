@@ -0,0 +1,233 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_LINEAR_ARENA_HPP
+#define CE_LINEAR_ARENA_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+////////////////////////////////////////////////////////////////
+// Size of the first block an arena allocates.
+////////////////////////////////////////////////////////////////
+#define CE_LINEAR_ARENA_BLOCK_SIZE (1 << 20)
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief Scratch memory for loaders. Allocations bump a pointer
+// through large blocks and are never freed one at a time; all of
+// them are released at once by reset().
+//
+// reset() keeps the memory, merging the blocks into one that is
+// big enough for everything the last use needed. After the first
+// few loads a loader stops calling malloc for its temporaries and
+// keeps touching the same, already faulted in, pages.
+//
+// An arena is not thread safe. Every thread that loads gets its
+// own.
+//
+////////////////////////////////////////////////////////////////
+class LinearArena
+{
+    public:
+        ////////////////////////////////////////////////////////////////
+        explicit LinearArena(const size_t blockSize = CE_LINEAR_ARENA_BLOCK_SIZE)
+            : m_blockSize(blockSize), m_block(0), m_offset(0)
+        { }
+
+        ////////////////////////////////////////////////////////////////
+        void * allocate(const size_t size, const size_t alignment = alignof(std::max_align_t))
+        {
+            while (m_block < m_blocks.size())
+            {
+                Block & block = m_blocks[m_block];
+                uintptr_t start = (uintptr_t) block.data.get();
+                size_t offset = (size_t)(((start + m_offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - start);
+
+                if (offset + size <= block.size)
+                {
+                    m_offset = offset + size;
+                    return block.data.get() + offset;
+                }
+
+                ++m_block;
+                m_offset = 0;
+            }
+
+            Block block;
+            block.size = std::max(m_blockSize, size + alignment);
+            block.data.reset(new unsigned char[block.size]);
+
+            m_blocks.push_back(std::move(block));
+            m_block = m_blocks.size() - 1;
+            m_offset = 0;
+
+            return allocate(size, alignment);
+        }
+
+        ////////////////////////////////////////////////////////////////
+        // \brief Releases every allocation. Anything still pointing
+        // into the arena is left dangling.
+        ////////////////////////////////////////////////////////////////
+        void reset()
+        {
+            if (m_blocks.size() > 1)
+            {
+                size_t size = getCapacity();
+
+                m_blocks.clear();
+                m_blocks.resize(1);
+                m_blocks[0].size = size;
+                m_blocks[0].data.reset(new unsigned char[size]);
+            }
+
+            m_block = 0;
+            m_offset = 0;
+        }
+
+        ////////////////////////////////////////////////////////////////
+        size_t getCapacity() const
+        {
+            size_t capacity = 0;
+
+            for (const Block & block : m_blocks)
+                capacity += block.size;
+
+            return capacity;
+        }
+
+    private:
+        LinearArena(const LinearArena &);
+        LinearArena & operator= (const LinearArena &);
+
+        struct Block
+        {
+            std::unique_ptr<unsigned char[]> data;
+            size_t                           size;
+        };
+
+        ////////////////////////////////////////////////////////////////
+        // Member data
+        ////////////////////////////////////////////////////////////////
+        std::vector<Block> m_blocks;
+        size_t             m_blockSize;
+        size_t             m_block;
+        size_t             m_offset;
+};
+
+////////////////////////////////////////////////////////////////
+// \brief Standard allocator that takes its memory from a
+// LinearArena, or from the heap when it has none, so that code
+// written against it works the same without an arena.
+//
+// Deallocating into an arena does nothing. Containers using one
+// must be destroyed before the arena is reset.
+//
+////////////////////////////////////////////////////////////////
+template <typename T>
+class ArenaAllocator
+{
+    public:
+        typedef T value_type;
+
+        typedef std::true_type propagate_on_container_copy_assignment;
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type propagate_on_container_swap;
+
+        ////////////////////////////////////////////////////////////////
+        ArenaAllocator(LinearArena * arena = nullptr) noexcept
+            : m_arena(arena)
+        { }
+
+        ////////////////////////////////////////////////////////////////
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U> & other) noexcept
+            : m_arena(other.getArena())
+        { }
+
+        ////////////////////////////////////////////////////////////////
+        T * allocate(const size_t count)
+        {
+            if (m_arena != nullptr)
+                return (T *) m_arena->allocate(count * sizeof(T), alignof(T));
+
+            return (T *) ::operator new(count * sizeof(T));
+        }
+
+        ////////////////////////////////////////////////////////////////
+        void deallocate(T * pointer, const size_t)
+        {
+            if (m_arena == nullptr)
+                ::operator delete(pointer);
+        }
+
+        ////////////////////////////////////////////////////////////////
+        LinearArena * getArena() const
+        {
+            return m_arena;
+        }
+
+    private:
+        ////////////////////////////////////////////////////////////////
+        // Member data
+        ////////////////////////////////////////////////////////////////
+        LinearArena * m_arena;
+};
+
+////////////////////////////////////////////////////////////////
+template <typename T, typename U>
+bool operator== (const ArenaAllocator<T> & left, const ArenaAllocator<U> & right)
+{
+    return left.getArena() == right.getArena();
+}
+
+////////////////////////////////////////////////////////////////
+template <typename T, typename U>
+bool operator!= (const ArenaAllocator<T> & left, const ArenaAllocator<U> & right)
+{
+    return left.getArena() != right.getArena();
+}
+
+////////////////////////////////////////////////////////////////
+// \brief A vector whose storage comes from an arena.
+////////////////////////////////////////////////////////////////
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+} // namespace ce
+
+#endif
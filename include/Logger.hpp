@@ -32,6 +32,7 @@
 #include <iomanip>
 #include <vector>
 #include <string>
+#include <mutex>
 
 #define LOGGER_CONTEXT_WIDTH 48
 #define LOGGER_MESSAGE_BREAK_WIDTH 64
@@ -44,6 +45,8 @@ class Logger
 
         void log(std::string logMessage, std::string contextFile="", std::string contextMethod="", int contextLine=-1)
         {
+            // Meshes are loaded on worker threads, which log too.
+            std::lock_guard<std::recursive_mutex> lock(m_mutex);
             std::string logContext = "";
 
             if (contextLine > -1)
@@ -104,6 +107,7 @@ class Logger
         std::vector<std::string> m_logContexts;
         bool                     m_outputLive;
         std::string              m_lastContextFile;
+        std::recursive_mutex     m_mutex;
 };
 
 // Create global logger
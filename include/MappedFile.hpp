@@ -0,0 +1,232 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_MAPPED_FILE_HPP
+#define CE_MAPPED_FILE_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <string>
+#include <cstddef>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "Logger.hpp"
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief How a mapped file will be read, which tells the OS
+// which pages to read ahead and which to drop first.
+//
+////////////////////////////////////////////////////////////////
+enum MappedFileAccess
+{
+    MAPPED_FILE_SEQUENTIAL = 0, // Walked front to back, like loaders do
+    MAPPED_FILE_RANDOM     = 1  // Looked up by index, read ahead would be wasted
+};
+
+////////////////////////////////////////////////////////////////
+// \brief Maps a file read-only into memory so that loaders can
+// walk its contents in place instead of copying it into a
+// heap buffer first.
+//
+// The mapping is released when the object is destroyed. The
+// mapped bytes are not null terminated, so callers must always
+// bound their reads by getSize().
+//
+////////////////////////////////////////////////////////////////
+class MappedFile
+{
+    public:
+        MappedFile();
+        MappedFile(const std::string & filename, const MappedFileAccess access=MAPPED_FILE_SEQUENTIAL);
+        ~MappedFile();
+
+        bool open(const std::string & filename, const MappedFileAccess access=MAPPED_FILE_SEQUENTIAL);
+        void close();
+
+        bool isOpen() const { return m_open; }
+        const char * getData() const { return m_data; }
+        size_t getSize() const { return m_size; }
+
+    private:
+        MappedFile(const MappedFile &);
+        MappedFile & operator= (const MappedFile &);
+
+        ////////////////////////////////////////////////////////////////
+        // Member data
+        ////////////////////////////////////////////////////////////////
+        const char * m_data;
+        size_t       m_size;
+        bool         m_open;
+
+#ifdef _WIN32
+        HANDLE       m_file;
+        HANDLE       m_mapping;
+#endif
+};
+
+////////////////////////////////////////////////////////////////
+inline MappedFile::MappedFile()
+    : m_data(nullptr), m_size(0), m_open(false)
+#ifdef _WIN32
+    , m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr)
+#endif
+{ }
+
+////////////////////////////////////////////////////////////////
+inline MappedFile::MappedFile(const std::string & filename, const MappedFileAccess access)
+    : MappedFile()
+{
+    open(filename, access);
+}
+
+////////////////////////////////////////////////////////////////
+inline MappedFile::~MappedFile()
+{
+    close();
+}
+
+////////////////////////////////////////////////////////////////
+inline bool MappedFile::open(const std::string & filename, const MappedFileAccess access)
+{
+    close();
+
+#ifdef _WIN32
+    m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                         OPEN_EXISTING, access == MAPPED_FILE_RANDOM ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if (m_file == INVALID_HANDLE_VALUE)
+    {
+        LOG("Could not open the file: " + filename);
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(m_file, &fileSize);
+    m_size = (size_t)fileSize.QuadPart;
+
+    // Empty files can't be mapped, but they are still valid files.
+    if (m_size > 0)
+    {
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+        if (m_mapping != nullptr)
+            m_data = (const char *) MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+
+        if (m_data == nullptr)
+        {
+            LOG("Could not map the file: " + filename);
+            close();
+            return false;
+        }
+    }
+#else
+    int file = ::open(filename.c_str(), O_RDONLY);
+
+    if (file < 0)
+    {
+        LOG("Could not open the file: " + filename);
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(file, &fileStat) != 0)
+    {
+        LOG("Could not read the size of the file: " + filename);
+        ::close(file);
+        return false;
+    }
+
+    m_size = (size_t)fileStat.st_size;
+
+    // Empty files can't be mapped, but they are still valid files.
+    if (m_size > 0)
+    {
+        void * data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+        if (data == MAP_FAILED)
+        {
+            LOG("Could not map the file: " + filename);
+            ::close(file);
+            m_size = 0;
+            return false;
+        }
+
+        madvise(data, m_size, access == MAPPED_FILE_RANDOM ? MADV_RANDOM : MADV_SEQUENTIAL);
+        m_data = (const char *) data;
+    }
+
+    // The mapping keeps its own reference to the file.
+    ::close(file);
+#endif
+
+    m_open = true;
+    return true;
+}
+
+////////////////////////////////////////////////////////////////
+inline void MappedFile::close()
+{
+#ifdef _WIN32
+    if (m_data != nullptr)
+        UnmapViewOfFile(m_data);
+
+    if (m_mapping != nullptr)
+        CloseHandle(m_mapping);
+
+    if (m_file != INVALID_HANDLE_VALUE)
+        CloseHandle(m_file);
+
+    m_mapping = nullptr;
+    m_file    = INVALID_HANDLE_VALUE;
+#else
+    if (m_data != nullptr)
+        munmap((void *) m_data, m_size);
+#endif
+
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+}
+
+} // namespace ce
+
+#endif
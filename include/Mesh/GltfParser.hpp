@@ -0,0 +1,142 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_GLTF_PARSER_HPP
+#define CE_GLTF_PARSER_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <string>
+#include <vector>
+#include "OpenGL.hpp"
+#include <glm/glm.hpp>
+
+#include "Logger.hpp"
+#include "Mesh/ObjParser.hpp"
+
+#define CE_GLTF_MAGIC      0x46546C67 // "glTF"
+#define CE_GLTF_CHUNK_JSON 0x4E4F534A // "JSON"
+#define CE_GLTF_CHUNK_BIN  0x004E4942 // "BIN\0"
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief A slice of the binary chunk.
+//
+////////////////////////////////////////////////////////////////
+struct GltfBufferView
+{
+    size_t byteOffset; // From the start of the binary chunk
+    size_t byteLength;
+    size_t byteStride; // 0 for tightly packed
+};
+
+////////////////////////////////////////////////////////////////
+// \brief A typed array of elements inside of a buffer view, laid
+// out the way glVertexAttribPointer and glDrawElements expect.
+//
+////////////////////////////////////////////////////////////////
+struct GltfAccessor
+{
+    int       bufferView;
+    size_t    byteOffset;    // From the start of the buffer view
+    GLenum    componentType; // GL_FLOAT, GL_UNSIGNED_SHORT, ...
+    int       componentCount;
+    size_t    count;
+    bool      normalized;
+    glm::vec3 min;           // Bounds, only read for positions
+    glm::vec3 max;
+};
+
+////////////////////////////////////////////////////////////////
+// \brief An indexed triangle list with one material. The
+// attributes and indices are accessor indices, -1 if missing.
+//
+////////////////////////////////////////////////////////////////
+struct GltfPrimitive
+{
+    int position;
+    int texCoord;
+    int normal;
+    int indices;
+    int material;
+};
+
+////////////////////////////////////////////////////////////////
+// \brief An image that is either embedded in a buffer view or
+// stored in a file next to the asset.
+//
+////////////////////////////////////////////////////////////////
+struct GltfImage
+{
+    int         bufferView; // -1 when the image is a file
+    std::string uri;
+    std::string mimeType;
+};
+
+////////////////////////////////////////////////////////////////
+// \brief The parts of a binary glTF file that the renderer uses.
+// The binary chunk isn't copied, it points into the parsed file.
+//
+////////////////////////////////////////////////////////////////
+struct GltfData
+{
+    std::vector<GltfBufferView> bufferViews;
+    std::vector<GltfAccessor>   accessors;
+    std::vector<GltfPrimitive>  primitives;
+    std::vector<GltfImage>      images;
+    std::vector<ObjMaterial>    materials;
+    std::vector<int>            materialImages; // Base color image of every material, or -1
+
+    const unsigned char *       binary;
+    size_t                      binarySize;
+};
+
+////////////////////////////////////////////////////////////////
+// \brief Reads binary glTF 2.0 (.glb) files.
+//
+// Every accessor that a primitive uses is checked to lie inside
+// of the binary chunk, so its data can be handed to OpenGL as is.
+// Primitives that aren't indexed triangle lists, and the scene's
+// node transforms, are not supported.
+//
+////////////////////////////////////////////////////////////////
+class GltfParser
+{
+    public:
+        bool parse(const char * begin, const char * end, GltfData & data);
+
+        static size_t getComponentSize(const GLenum & componentType);
+        static size_t getElementSize(const GltfAccessor & accessor);
+        static size_t getStride(const GltfData & data, const GltfAccessor & accessor);
+};
+
+} // namespace ce
+
+#endif
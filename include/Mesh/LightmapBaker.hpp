@@ -0,0 +1,133 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_LIGHTMAP_BAKER_HPP
+#define CE_LIGHTMAP_BAKER_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Mesh/MeshBvh.hpp"
+#include "Mesh/StaticBatch.hpp"
+
+// Light is stored divided by this, so that surfaces lit by more
+// than one light (or brighter ones) don't saturate.
+#define CE_LIGHTMAP_RANGE 2.0f
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief A point light, lighting like the one of the
+// entity_textured shader: no falloff with distance.
+//
+////////////////////////////////////////////////////////////////
+struct LightmapLight
+{
+    glm::vec3 position;
+    glm::vec3 color;
+};
+
+////////////////////////////////////////////////////////////////
+// \brief How finely and how long lightmaps are baked.
+//
+////////////////////////////////////////////////////////////////
+struct LightmapSettings
+{
+    float     texelsPerUnit;    // Lightmap resolution in world space
+    float     minTexelsPerUnit; // Lowest resolution, batches are split instead
+    int       maxSize;          // Texels along either side of a lightmap
+    int       padding;          // Texels around every triangle, against bleeding
+    int       samples;          // Paths traced from every texel
+    int       bounces;          // Rays in every path, 0 for direct light only
+    glm::vec3 skyColor;         // Light from paths that hit nothing
+
+    LightmapSettings()
+        : texelsPerUnit(1.0f), minTexelsPerUnit(0.25f), maxSize(1024), padding(2), samples(32), bounces(2), skyColor(0.35f)
+    { }
+};
+
+////////////////////////////////////////////////////////////////
+// \brief Bakes the static lighting of a StaticBatchBuilder's
+// batches into one lightmap per batch, so that they can be drawn
+// with a lightmap fetch (see the lightmapped shaders) instead of
+// lighting every fragment.
+//
+// Every triangle gets a chart of its own, laid flat at the set
+// resolution and shelf packed into the lightmap. The resolution
+// of a batch is lowered until its charts fit, but not below the
+// lowest one set: batches that don't fit by then are split into
+// more batches first. The texels that
+// charts cover are path traced against all of the batches at
+// once, through a MeshBvh: direct light with shadow rays, plus
+// cosine weighted bounces off surfaces with the average color of
+// their vertices or texture. Triangles are baked on all cores.
+//
+// Baking doesn't touch OpenGL, so it can run on a background
+// thread before the batches are created. The batch vertices are
+// unwelded on the way, as triangles no longer share lightmap
+// coordinates.
+//
+////////////////////////////////////////////////////////////////
+class LightmapBaker
+{
+    public:
+        LightmapBaker(const LightmapSettings & settings=LightmapSettings());
+
+        void addLight(const glm::vec3 & position, const glm::vec3 & color);
+        void bake(StaticBatchBuilder & builder);
+
+    private:
+        struct Texel
+        {
+            glm::vec3 position;
+            glm::vec3 normal;      // Interpolated, for shading
+            glm::vec3 facing;      // Of the triangle, on the side of normal
+        };
+
+        glm::vec3 getDirectLight(const glm::vec3 & position, const glm::vec3 & normal) const;
+        glm::vec3 getLight(const Texel & texel, uint32_t & random) const;
+
+        ////////////////////////////////////////////////////////////////
+        // Member data
+        ////////////////////////////////////////////////////////////////
+        LightmapSettings           m_settings;
+        std::vector<LightmapLight> m_lights;
+
+        // The scene while baking.
+        MeshBvh                    m_scene;
+        std::vector<glm::vec3>     m_albedos; // Of every triangle in the scene
+        float                      m_bias;    // Offset of rays from surfaces
+};
+
+} // namespace ce
+
+#endif
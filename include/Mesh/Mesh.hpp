@@ -0,0 +1,200 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_MESH_HPP
+#define CE_MESH_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <vector>
+#include <memory>
+#include "OpenGL.hpp"
+#include <glm/glm.hpp>
+
+#include "Mesh/MeshBuilder.hpp"
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief Options for loading a mesh, combined with |.
+//
+// glTF meshes are drawn from the file as they are, so they only
+// support MESH_LOAD_BVH. The other flags are logged and ignored.
+//
+////////////////////////////////////////////////////////////////
+enum MeshLoadFlags
+{
+    MESH_LOAD_DEFAULT   = 0,
+    MESH_LOAD_OPTIMIZE  = 1 << 0, // Reorder for vertex cache, overdraw and fetch
+    MESH_LOAD_LODS      = 1 << 1, // Build simplified levels of detail
+    MESH_LOAD_QUANTIZE  = 1 << 2, // Store vertices in 16 instead of 32 bytes
+    MESH_LOAD_MESHLETS  = 1 << 3, // Split into meshlets that can be culled
+    MESH_LOAD_POSITIONS = 1 << 4, // Keep a position-only stream for depth passes
+    MESH_LOAD_BVH       = 1 << 5  // Build a MeshBvh for ray picking
+};
+
+class MeshBvh;
+
+////////////////////////////////////////////////////////////////
+// \brief A range of a mesh's element buffer that is drawn with
+// one material.
+//
+////////////////////////////////////////////////////////////////
+struct Submesh
+{
+    GLuint firstIndex;
+    GLuint indexCount;
+    GLuint texture;  // Diffuse map, or 0 when the material has none
+    int    material; // Index into Mesh::materials, or -1 for none
+
+    GLuint vao;       // Mesh::vao, unless the submesh has its own
+    GLenum indexType; // vertex layout (as glTF primitives can)
+
+    GLuint firstMeshlet; // The meshlets that make up the submesh,
+    GLuint meshletCount; // none without MESH_LOAD_MESHLETS
+
+    size_t getIndexSize() const
+    {
+        return indexType == GL_UNSIGNED_INT ? sizeof(GLuint) : (indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLubyte));
+    }
+};
+
+////////////////////////////////////////////////////////////////
+// \brief The submeshes of a simplified level of detail, and its
+// error relative to the size of the mesh.
+//
+////////////////////////////////////////////////////////////////
+struct MeshLod
+{
+    float                error;
+    std::vector<Submesh> submeshes;
+};
+
+////////////////////////////////////////////////////////////////
+// \brief A mesh uploaded to the GPU. All of its submeshes (and
+// those of its levels of detail) share one vertex array, vertex
+// buffer and element buffer, and are sorted by texture so that
+// drawing them in order binds every texture only once.
+//
+// Level 0 is the full mesh, level N uses lods[N - 1].
+//
+// Meshes loaded with MESH_LOAD_POSITIONS also have a tightly
+// packed copy of their positions in positionVbo, which depthVao
+// reads along with the same element buffer.
+//
+// Meshes loaded with MESH_LOAD_BVH keep their triangles on the
+// CPU, in a BVH that is shared by all copies of the mesh.
+//
+////////////////////////////////////////////////////////////////
+struct Mesh
+{
+    GLuint                   vao;
+    GLuint                   vbo;
+    GLuint                   ebo;
+    GLuint                   depthVao;
+    GLuint                   positionVbo;
+    GLenum                   indexType;
+    size_t                   indexCount;
+    MeshVertexFormat         format;
+
+    std::vector<Submesh>     submeshes;
+    std::vector<MeshLod>     lods;
+    std::vector<Meshlet>     meshlets; // Sorted by first index
+    std::vector<ObjMaterial> materials;
+
+    // The shared textures of the submeshes, which are freed once
+    // no mesh refers to them anymore.
+    std::vector<std::shared_ptr<const GLuint>> textures;
+
+    glm::vec3                boundsMin;
+    glm::vec3                boundsMax;
+
+    std::shared_ptr<const MeshBvh> bvh;
+
+    Mesh()
+        : vao(0), vbo(0), ebo(0), depthVao(0), positionVbo(0), indexType(GL_UNSIGNED_INT), indexCount(0),
+          boundsMin(0.0f), boundsMax(0.0f)
+    { }
+
+    size_t getIndexSize() const { return indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint); }
+    size_t getLodCount() const { return lods.size() + 1; }
+
+    const std::vector<Submesh> & getSubmeshes(const size_t & lod) const
+    {
+        return (lod == 0 || lod > lods.size()) ? submeshes : lods[lod - 1].submeshes;
+    }
+
+    size_t selectLod(const glm::mat4 & modelView, const glm::mat4 & projection, const float & viewportHeight, const float & maxPixelError=1.0f) const;
+};
+
+////////////////////////////////////////////////////////////////
+// \brief Picks the coarsest level of detail whose error covers
+// at most maxPixelError pixels on screen, judged from the point
+// of the mesh's bounds that is closest to the camera.
+//
+////////////////////////////////////////////////////////////////
+inline size_t Mesh::selectLod(const glm::mat4 & modelView, const glm::mat4 & projection, const float & viewportHeight, const float & maxPixelError) const
+{
+    if (lods.empty())
+        return 0;
+
+    glm::vec3 size = boundsMax - boundsMin;
+    float extent = glm::max(size.x, glm::max(size.y, size.z));
+
+    // Errors scale with the largest axis of the model matrix.
+    float scale = glm::max(glm::length(glm::vec3(modelView[0])),
+                  glm::max(glm::length(glm::vec3(modelView[1])), glm::length(glm::vec3(modelView[2]))));
+
+    // Pixels per world unit at the nearest point of the bounds. An
+    // orthographic projection doesn't depend on the distance.
+    float pixelsPerUnit = projection[1][1] * viewportHeight * 0.5f;
+
+    if (projection[3][3] == 0.0f)
+    {
+        glm::vec4 center = modelView * glm::vec4((boundsMin + boundsMax) * 0.5f, 1.0f);
+        float distance = -center.z - glm::length(size) * 0.5f * scale;
+
+        if (distance <= 0.0f)
+            return 0;
+
+        pixelsPerUnit /= distance;
+    }
+
+    for (size_t lod = lods.size(); lod > 0; --lod)
+    {
+        if (lods[lod - 1].error * extent * scale * pixelsPerUnit <= maxPixelError)
+            return lod;
+    }
+
+    return 0;
+}
+
+} // namespace ce
+
+#endif
@@ -0,0 +1,177 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_MESH_BUILDER_HPP
+#define CE_MESH_BUILDER_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <vector>
+#include "OpenGL.hpp"
+#include <glm/glm.hpp>
+
+#include "Mesh/ObjParser.hpp"
+
+// Position (3), texture coordinate (2) and normal (3).
+#define CE_MESH_VERTEX_SIZE 8
+
+// Quantized position (3 shorts and 2 bytes of padding), texture
+// coordinate (2 shorts) and octahedral normal (2 bytes and 2
+// bytes of padding).
+#define CE_MESH_QUANTIZED_VERTEX_BYTES 16
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief How the vertices of a mesh are stored on the GPU.
+//
+// Quantized positions and texture coordinates are normalized
+// 16 bit values, and decode as value * scale + offset. Their
+// normals are octahedral encoded into 2 normalized bytes.
+//
+////////////////////////////////////////////////////////////////
+struct MeshVertexFormat
+{
+    bool      quantized;
+    glm::vec3 positionScale;
+    glm::vec3 positionOffset;
+    glm::vec2 texCoordScale;
+    glm::vec2 texCoordOffset;
+
+    MeshVertexFormat()
+        : quantized(false), positionScale(1.0f), positionOffset(0.0f),
+          texCoordScale(1.0f), texCoordOffset(0.0f)
+    { }
+
+    GLsizei getStride() const { return quantized ? CE_MESH_QUANTIZED_VERTEX_BYTES : CE_MESH_VERTEX_SIZE * sizeof(GLfloat); }
+};
+
+////////////////////////////////////////////////////////////////
+// \brief A run of indices that is drawn with one material.
+//
+////////////////////////////////////////////////////////////////
+struct MeshRange
+{
+    GLuint firstIndex;
+    GLuint indexCount;
+    int    material; // Index into MeshData::materials, or -1 for none
+};
+
+////////////////////////////////////////////////////////////////
+// \brief The ranges of a simplified level of detail, and its
+// error relative to the size of the mesh.
+//
+////////////////////////////////////////////////////////////////
+struct MeshLodData
+{
+    float                  error;
+    std::vector<MeshRange> ranges;
+};
+
+////////////////////////////////////////////////////////////////
+// \brief A small cluster of neighbouring triangles that is
+// culled as a whole. Its triangles are a contiguous run of
+// indices inside of one range.
+//
+////////////////////////////////////////////////////////////////
+struct Meshlet
+{
+    GLuint    firstIndex;
+    GLuint    indexCount;
+    glm::vec3 center;     // Bounding sphere
+    float     radius;
+    glm::vec3 coneAxis;   // Average direction the triangles face
+    float     coneCutoff; // Sine of the normal cone's half angle, 1 if it can't be culled
+};
+
+////////////////////////////////////////////////////////////////
+// \brief An indexed triangle mesh ready to be uploaded, with
+// interleaved vertices of CE_MESH_VERTEX_SIZE floats each.
+//
+////////////////////////////////////////////////////////////////
+struct MeshData
+{
+    std::vector<GLfloat>     vertices;
+    std::vector<GLuint>      indices;
+    std::vector<MeshRange>   ranges;
+    std::vector<MeshLodData> lods; // Coarser levels, indexing the same vertices
+    std::vector<Meshlet>     meshlets;
+    std::vector<ObjMaterial> materials;
+
+    glm::vec3                boundsMin;
+    glm::vec3                boundsMax;
+
+    // Filled in by MeshQuantizer.
+    MeshVertexFormat           format;
+    std::vector<unsigned char> quantizedVertices;
+
+    size_t getVertexCount() const { return vertices.size() / CE_MESH_VERTEX_SIZE; }
+
+    // The vertices as they are uploaded, in the format above.
+    const GLvoid * getVertexData() const
+    {
+        if (format.quantized)
+            return quantizedVertices.empty() ? nullptr : &quantizedVertices[0];
+
+        return vertices.empty() ? nullptr : &vertices[0];
+    }
+
+    size_t getVertexDataSize() const { return getVertexCount() * format.getStride(); }
+
+    // 16 bit indices are used whenever every vertex can be reached
+    // with them, which halves the size of the element buffer.
+    GLenum getIndexType() const { return getVertexCount() <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT; }
+    size_t getIndexSize() const { return getIndexType() == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint); }
+};
+
+////////////////////////////////////////////////////////////////
+// \brief Turns parsed OBJ data into an indexed mesh.
+//
+// Face corners that reference the same position, texture
+// coordinate and normal are welded into a single vertex through
+// a hash map, so shared vertices are only stored (and shaded)
+// once. The triangles of every material (from the "usemtl"
+// groups) are gathered into a single range of indices that
+// refers to the matching entry of the given materials.
+//
+// The weld table and the other temporaries can be taken from a
+// scratch arena, which is left for the caller to reset.
+//
+////////////////////////////////////////////////////////////////
+class MeshBuilder
+{
+    public:
+        void build(const ObjData & obj, const std::vector<ObjMaterial> & materials, MeshData & mesh, LinearArena * scratch=nullptr);
+
+        static void getIndexData(const MeshData & mesh, std::vector<unsigned char> & indexData);
+};
+
+} // namespace ce
+
+#endif
@@ -0,0 +1,148 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_MESH_BVH_HPP
+#define CE_MESH_BVH_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "LinearArena.hpp"
+#include "Mesh/Mesh.hpp"
+
+#define CE_MESHBVH_BINS           16   // Candidate splits per axis
+#define CE_MESHBVH_MAX_LEAF_SIZE  4    // Triangles in a leaf before it must be split
+#define CE_MESHBVH_MAX_DEPTH      60   // Leaves are forced below this, to bound the traversal stack
+#define CE_MESHBVH_TASK_SIZE      8192 // Subtrees this small are built on one thread
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief A node of a MeshBvh, 32 bytes. The two children of a
+// node are always stored next to each other.
+//
+////////////////////////////////////////////////////////////////
+struct MeshBvhNode
+{
+    glm::vec3 boundsMin;
+    uint32_t  first;     // First triangle of a leaf, or the left child
+    glm::vec3 boundsMax;
+    uint32_t  count;     // Triangles in a leaf, 0 for an inner node
+};
+
+////////////////////////////////////////////////////////////////
+// \brief A triangle, stored the way the ray test wants it.
+//
+////////////////////////////////////////////////////////////////
+struct MeshBvhTriangle
+{
+    glm::vec3 corner;
+    glm::vec3 edge1;   // Second corner - corner
+    glm::vec3 edge2;   // Third corner - corner
+    uint32_t  index;   // Of the triangle in the order it was given
+};
+
+////////////////////////////////////////////////////////////////
+// \brief The closest hit of a ray. Distances are in multiples of
+// the ray direction, so they are world space distances when the
+// direction is normalized.
+//
+// The same hit can be passed to several raycasts to find the
+// closest of them, as only hits closer than distance replace it.
+//
+////////////////////////////////////////////////////////////////
+struct MeshRayHit
+{
+    uint32_t  triangle; // Index of the triangle in the mesh
+    float     distance;
+    glm::vec2 uv;       // Barycentric coordinates of the second and third corner
+    glm::vec3 position; // Where the ray hit, in world space
+    glm::vec3 normal;   // Of the triangle, in world space
+
+    MeshRayHit()
+        : triangle(0), distance(FLT_MAX), uv(0.0f), position(0.0f), normal(0.0f)
+    { }
+};
+
+////////////////////////////////////////////////////////////////
+// \brief Bounding volume hierarchy over the triangles of a mesh,
+// for ray picking.
+//
+// It is built top down with the surface area heuristic, binning
+// the triangle centroids along every axis. The top of the tree is
+// split on the calling thread, and the subtrees below it are
+// built on all cores.
+//
+// Nodes are stored depth first in one array and the triangles in
+// leaf order in another, so that a ray query touches nothing but
+// those two.
+//
+// Meshes loaded with MESH_LOAD_BVH have one over the triangles of
+// their full level of detail. For OBJ meshes their index is their
+// first index in the element buffer divided by three, for glTF
+// ones it counts through the primitives in file order.
+//
+////////////////////////////////////////////////////////////////
+class MeshBvh
+{
+    public:
+        void build(const glm::vec3 * corners, const size_t triangleCount, LinearArena * scratch=nullptr);
+
+        // In the space of the triangles. Only hits closer than
+        // hit.distance are reported.
+        bool intersect(const glm::vec3 & origin, const glm::vec3 & direction, MeshRayHit & hit) const;
+
+        bool isEmpty() const { return m_nodes.empty(); }
+        const std::vector<MeshBvhNode> & getNodes() const { return m_nodes; }
+        const std::vector<MeshBvhTriangle> & getTriangles() const { return m_triangles; }
+
+        // Casts a world space ray against a mesh placed with the
+        // model matrix. Meshes without a BVH are never hit.
+        static bool raycast(const Mesh & mesh, const glm::mat4 & model, const glm::vec3 & origin, const glm::vec3 & direction, MeshRayHit & hit);
+
+        // The world space ray through a point of the viewport, with
+        // the origin at the bottom left (like the window's mouse
+        // position).
+        static void getPickRay(const glm::vec2 & point, const glm::vec2 & viewportSize, const glm::mat4 & view, const glm::mat4 & projection, glm::vec3 & origin, glm::vec3 & direction);
+
+    private:
+        ////////////////////////////////////////////////////////////////
+        // Member data
+        ////////////////////////////////////////////////////////////////
+        std::vector<MeshBvhNode>     m_nodes;
+        std::vector<MeshBvhTriangle> m_triangles;
+};
+
+} // namespace ce
+
+#endif
@@ -0,0 +1,144 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_MESH_CACHE_HPP
+#define CE_MESH_CACHE_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.hpp"
+#include "Mesh/MeshBuilder.hpp"
+
+#define CE_MESHCACHE_MAGIC     0x534D4543 // "CEMS"
+#define CE_MESHCACHE_VERSION   7
+#define CE_MESHCACHE_EXTENSION ".cemesh"
+#define CE_MESHCACHE_ALIGNMENT 16
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief The fixed size start of a cooked mesh file. Every
+// section is aligned to CE_MESHCACHE_ALIGNMENT bytes and found
+// through its offset from the start of the file.
+//
+////////////////////////////////////////////////////////////////
+struct MeshCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourceHash;    // Hash of the OBJ file the mesh was cooked from
+    uint64_t materialHash;  // Hash of its MTL file, or 0 without one
+    uint64_t fileSize;
+    uint32_t flags;         // The MeshLoadFlags the mesh was cooked with
+    uint32_t lodCount;      // Levels of detail after the full one
+
+    uint32_t vertexCount;
+    uint32_t vertexStride;  // In bytes, tells quantized vertices apart
+    uint32_t indexCount;
+    uint32_t indexType;     // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    uint32_t rangeCount;
+    uint32_t materialCount;
+    uint32_t meshletCount;
+
+    float    boundsMin[3];
+    float    boundsMax[3];
+
+    float    positionScale[3];  // See MeshVertexFormat
+    float    positionOffset[3];
+    float    texCoordScale[2];
+    float    texCoordOffset[2];
+
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t rangeOffset;
+    uint64_t lodOffset;      // Error and ranges of every level of detail
+    uint64_t meshletOffset;
+    uint64_t materialOffset; // Material library name followed by the materials
+};
+
+////////////////////////////////////////////////////////////////
+// \brief Binary sidecar files that hold a mesh exactly as it is
+// uploaded to the GPU, so that it can be loaded without parsing
+// any text.
+//
+// A sidecar lives next to the OBJ file it was cooked from (with
+// CE_MESHCACHE_EXTENSION appended) and is only used while the
+// hashes of the OBJ and its MTL still match, it was cooked with
+// the same load flags and its version is current. Open sidecars
+// are memory mapped, so the vertex and index data can be handed
+// straight to glBufferData.
+//
+// Ranges, meshlets and indices that point past the data they
+// belong to mark the sidecar as corrupt, and it's rebuilt too.
+//
+////////////////////////////////////////////////////////////////
+class MeshCache
+{
+    public:
+        MeshCache();
+
+        bool open(const std::string & filename, const uint64_t sourceHash, const unsigned int flags);
+        static bool write(const std::string & filename, const uint64_t sourceHash, const unsigned int flags, const std::string & materialLibrary, const MeshData & mesh);
+
+        const GLvoid * getVertexData() const;
+        size_t getVertexDataSize() const;
+        MeshVertexFormat getVertexFormat() const;
+        const GLvoid * getIndexData() const;
+        size_t getIndexDataSize() const;
+        size_t getIndexCount() const;
+        GLenum getIndexType() const;
+        glm::vec3 getBoundsMin() const;
+        glm::vec3 getBoundsMax() const;
+
+        void getRanges(std::vector<MeshRange> & ranges) const;
+        bool getLods(std::vector<MeshLodData> & lods) const;
+        void getMeshlets(std::vector<Meshlet> & meshlets) const;
+        void getMaterials(std::vector<ObjMaterial> & materials) const;
+
+        static std::string getCacheFilename(const std::string & filename);
+
+    private:
+        static uint64_t hashMaterialLibrary(const std::string & filename, const std::string & materialLibrary);
+        bool validate() const;
+        bool readMaterials(std::string * materialLibrary, std::vector<ObjMaterial> * materials) const;
+
+        ////////////////////////////////////////////////////////////////
+        // Member data
+        ////////////////////////////////////////////////////////////////
+        MappedFile              m_file;
+        const MeshCacheHeader * m_header;
+};
+
+} // namespace ce
+
+#endif
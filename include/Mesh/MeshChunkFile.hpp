@@ -0,0 +1,161 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_MESH_CHUNK_FILE_HPP
+#define CE_MESH_CHUNK_FILE_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.hpp"
+#include "Mesh/MeshBuilder.hpp"
+
+#define CE_MESHCHUNKS_MAGIC     0x4B484345 // "CEHK"
+#define CE_MESHCHUNKS_VERSION   2
+#define CE_MESHCHUNKS_EXTENSION ".cechunks"
+#define CE_MESHCHUNKS_ALIGNMENT 16
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief The fixed size start of a chunked mesh file.
+//
+////////////////////////////////////////////////////////////////
+struct MeshChunkFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t fileSize;
+    uint64_t sourceHash;     // Of the OBJ file it was converted from
+    uint32_t chunkCount;
+    uint32_t triangleCount;
+
+    float    boundsMin[3];
+    float    boundsMax[3];
+
+    uint64_t chunkOffset;    // Table of MeshChunkInfo
+    uint64_t materialOffset; // Name of the material library
+};
+
+////////////////////////////////////////////////////////////////
+// \brief Where the vertices (of CE_MESH_VERTEX_SIZE floats),
+// indices and per-material ranges of one chunk are stored. The
+// ranges' materials index the materials of the library in the
+// order they appear in it.
+//
+////////////////////////////////////////////////////////////////
+struct MeshChunkInfo
+{
+    float    boundsMin[3];
+    float    boundsMax[3];
+
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t indexType; // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    uint32_t rangeCount;
+
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t rangeOffset;
+};
+
+////////////////////////////////////////////////////////////////
+// \brief How a MeshRange is laid out in a chunked mesh file.
+//
+////////////////////////////////////////////////////////////////
+struct MeshChunkRange
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    int32_t  material;
+};
+
+////////////////////////////////////////////////////////////////
+// \brief A mesh that was converted by ObjStreamConverter into
+// spatially separate chunks, each of which can be uploaded on
+// its own when it's needed.
+//
+// The file is memory mapped. Opening it checks that it was
+// converted from the OBJ file as it is now (when that is still
+// around), and that the ranges and indices of every chunk stay
+// inside of the chunk, so the getters don't have to. Chunks are
+// only uploaded when they are asked for.
+//
+// The texture files of the materials are found and hashed once,
+// so that the chunks can share their textures: only the first
+// chunk that is created needs to decode them.
+//
+////////////////////////////////////////////////////////////////
+class MeshChunkFile
+{
+    public:
+        MeshChunkFile();
+
+        bool open(const std::string & filename);
+
+        size_t getChunkCount() const;
+        const MeshChunkInfo & getChunk(const size_t & chunk) const;
+        const GLvoid * getVertexData(const size_t & chunk) const;
+        size_t getVertexDataSize(const size_t & chunk) const;
+        const GLvoid * getIndexData(const size_t & chunk) const;
+        size_t getIndexDataSize(const size_t & chunk) const;
+        void getRanges(const size_t & chunk, std::vector<MeshRange> & ranges) const;
+
+        glm::vec3 getBoundsMin() const;
+        glm::vec3 getBoundsMax() const;
+        const std::vector<ObjMaterial> & getMaterials() const;
+        const std::vector<std::string> & getImageFiles() const;
+        const std::vector<uint64_t> & getImageHashes() const;
+        const std::vector<int> & getMaterialImages() const;
+        const std::string & getFilename() const;
+
+        static std::string getChunkFilename(const std::string & filename);
+
+    private:
+        bool validate() const;
+
+        ////////////////////////////////////////////////////////////////
+        // Member data
+        ////////////////////////////////////////////////////////////////
+        MappedFile                  m_file;
+        std::string                 m_filename;
+        const MeshChunkFileHeader * m_header;
+        std::vector<MeshChunkInfo>  m_chunks;
+        std::vector<ObjMaterial>    m_materials;
+        std::vector<std::string>    m_imageFiles;     // Diffuse maps of the materials
+        std::vector<uint64_t>       m_imageHashes;    // See MeshLoader::hashImageFile()
+        std::vector<int>            m_materialImages; // Into the image files, or -1
+};
+
+} // namespace ce
+
+#endif
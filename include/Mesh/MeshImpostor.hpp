@@ -0,0 +1,135 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_MESH_IMPOSTOR_HPP
+#define CE_MESH_IMPOSTOR_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <vector>
+#include "OpenGL.hpp"
+#include <glm/glm.hpp>
+
+#include "Mesh/Mesh.hpp"
+
+#define CE_IMPOSTOR_VIEWS       8   // Views along either side of the atlas
+#define CE_IMPOSTOR_VIEW_SIZE   128 // Texels along either side of a view
+#define CE_IMPOSTOR_VERTEX_SIZE 5   // Position and atlas coordinate
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief How many views of a mesh an impostor keeps, and how
+// large they are.
+//
+////////////////////////////////////////////////////////////////
+struct ImpostorSettings
+{
+    int  views;      // Along either side of the atlas
+    int  viewSize;   // Texels along either side of a view
+    bool hemisphere; // Only views from above, for meshes standing on the ground
+
+    ImpostorSettings()
+        : views(CE_IMPOSTOR_VIEWS), viewSize(CE_IMPOSTOR_VIEW_SIZE), hemisphere(true)
+    { }
+};
+
+////////////////////////////////////////////////////////////////
+// \brief A mesh rendered from views all around it into one
+// atlas, to draw far away instances of it as a single quad.
+//
+// The views are laid out on an octahedral map of directions (a
+// hemi-octahedral one with hemisphere set): the cell at (x, y)
+// shows the mesh as seen from getViewDirection(x, y), through an
+// orthographic projection of its bounding sphere.
+//
+// \see Renderer::createImpostor, ImpostorBatch
+//
+////////////////////////////////////////////////////////////////
+struct MeshImpostor
+{
+    GLuint           texture;     // The atlas, with alpha where the mesh is
+    GLuint           frameBuffer; // Renders into the atlas
+    GLuint           depthBuffer;
+    ImpostorSettings settings;
+    glm::vec3        center;      // Of the bounding sphere, in object space
+    float            radius;
+
+    MeshImpostor()
+        : texture(0), frameBuffer(0), depthBuffer(0), center(0.0f), radius(0.0f)
+    { }
+
+    size_t getViewCount() const { return (size_t) settings.views * settings.views; }
+
+    // The direction from the mesh that a view is seen from, in
+    // object space.
+    glm::vec3 getViewDirection(const int & x, const int & y) const;
+
+    // The cell of the view seen from closest to direction.
+    void getView(const glm::vec3 & direction, int & x, int & y) const;
+
+    // The camera that renders a view, looking at the bounding sphere
+    // from direction, and the orientation of its image.
+    void getViewAxes(const glm::vec3 & direction, glm::vec3 & right, glm::vec3 & up) const;
+    glm::mat4 getViewMatrix(const glm::vec3 & direction) const;
+    glm::mat4 getProjectionMatrix() const;
+
+    // Pixels across the bounding sphere on screen. Once this drops
+    // below the view size, the impostor is at least as sharp as the
+    // mesh would be.
+    float getScreenSize(const glm::mat4 & modelView, const glm::mat4 & projection, const float & viewportHeight) const;
+};
+
+////////////////////////////////////////////////////////////////
+// \brief The quads of the instances of one impostor, to be drawn
+// with Renderer::drawImpostors and the impostor shaders.
+//
+// Each quad lies across the view that was rendered closest to the
+// direction of the camera, so that the view lines up with it. The
+// instance models may rotate, translate and scale uniformly.
+// Keeping a batch around between frames avoids reallocating it.
+//
+////////////////////////////////////////////////////////////////
+class ImpostorBatch
+{
+    public:
+        void clear() { m_vertices.clear(); }
+
+        void addInstance(const MeshImpostor & impostor, const glm::mat4 & model, const glm::vec3 & cameraPosition);
+
+        const std::vector<GLfloat> & getVertices() const { return m_vertices; }
+        size_t getVertexCount() const { return m_vertices.size() / CE_IMPOSTOR_VERTEX_SIZE; }
+
+    private:
+        std::vector<GLfloat> m_vertices;
+};
+
+} // namespace ce
+
+#endif
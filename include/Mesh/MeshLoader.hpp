@@ -0,0 +1,201 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_MESH_LOADER_HPP
+#define CE_MESH_LOADER_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "OpenGL.hpp"
+
+#include "Image.hpp"
+#include "LinearArena.hpp"
+#include "MappedFile.hpp"
+#include "Mesh/Mesh.hpp"
+#include "Mesh/MeshCache.hpp"
+#include "Mesh/GltfParser.hpp"
+
+#define CE_MESHLOADER_MAX_THREADS 4
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief Everything about a mesh that can be prepared without an
+// OpenGL context: its buffers, ranges, levels of detail, meshlets,
+// materials and decoded diffuse maps.
+//
+// The vertex and index data point into whichever of the cooked
+// mesh file, the built mesh or the mapped glTF file the mesh was
+// read from, all of which are owned here.
+//
+////////////////////////////////////////////////////////////////
+struct MeshLoadData
+{
+    Mesh                        mesh; // Without OpenGL objects or submeshes
+    std::vector<MeshRange>      ranges;
+    std::vector<MeshLodData>    lods;
+    std::vector<Image>          images;
+    std::vector<uint64_t>       imageHashes;    // Of the encoded images, to share their textures
+    std::vector<int>            materialImages; // Index into images for every material, or -1
+
+    std::vector<unsigned char>  positionData; // With MESH_LOAD_POSITIONS
+
+    const GLvoid *              vertexData;
+    size_t                      vertexDataSize;
+    const GLvoid *              indexData;
+    size_t                      indexDataSize;
+
+    bool                        gltf;
+    GltfData                    gltfData;
+
+    std::unique_ptr<MeshCache>  cache;
+    std::unique_ptr<MappedFile> file;
+    MeshData                    built;
+    std::vector<unsigned char>  builtIndices;
+
+    MeshLoadData()
+        : vertexData(nullptr), vertexDataSize(0), indexData(nullptr), indexDataSize(0), gltf(false)
+    { }
+};
+
+////////////////////////////////////////////////////////////////
+// \brief A mesh that is being loaded in the background. Only the
+// worker that loads it touches it until it is handed back to the
+// context thread, which uploads it and sets ready.
+//
+////////////////////////////////////////////////////////////////
+struct MeshLoadRequest
+{
+    std::string  filename;
+    unsigned int flags;
+    MeshLoadData data;
+    bool         loaded;
+    bool         ready;
+    Mesh         mesh;
+
+    MeshLoadRequest()
+        : flags(0), loaded(false), ready(false)
+    { }
+};
+
+////////////////////////////////////////////////////////////////
+// \brief Refers to a mesh created with createMeshAsync. Until it
+// is ready, get() returns an empty mesh that draws nothing, so it
+// can be drawn every frame from the start. Only use it on the
+// thread that owns the OpenGL context.
+//
+////////////////////////////////////////////////////////////////
+class MeshHandle
+{
+    public:
+        MeshHandle()
+        { }
+
+        explicit MeshHandle(const std::shared_ptr<MeshLoadRequest> & request)
+            : m_request(request)
+        { }
+
+        bool isReady() const
+        {
+            return m_request && m_request->ready;
+        }
+
+        const Mesh & get() const
+        {
+            static const Mesh empty;
+            return isReady() ? m_request->mesh : empty;
+        }
+
+    private:
+        std::shared_ptr<MeshLoadRequest> m_request;
+};
+
+////////////////////////////////////////////////////////////////
+// \brief Does the CPU side of loading a mesh: reading the file,
+// parsing it (or its cooked copy), building it and decoding its
+// textures.
+//
+// Besides loading meshes on the calling thread, it runs a small
+// pool of worker threads that load requested meshes one after the
+// other and queue them up for the renderer to upload. The workers
+// are started with the first request.
+//
+// Temporaries (the parsed OBJ, the weld table) are taken from the
+// scratch arena when one is given. Nothing that outlives the load
+// is, so the caller can reset the arena as soon as load() returns.
+// Every worker has its own. Textures are decoded on all cores,
+// and every thread that decodes them keeps a scratch arena of its
+// own from one image to the next. hashImageFile() gives the hash
+// that decoding a texture file would, so that a texture made from
+// it before can be found without decoding it again.
+//
+////////////////////////////////////////////////////////////////
+class MeshLoader
+{
+    public:
+        MeshLoader();
+        ~MeshLoader();
+
+        std::shared_ptr<MeshLoadRequest> request(const std::string & filename, const unsigned int flags);
+        bool popLoaded(std::shared_ptr<MeshLoadRequest> & request);
+
+        static bool load(const std::string & filename, const unsigned int flags, MeshLoadData & data, LinearArena * scratch=nullptr);
+        static void loadImages(const std::string & filename, const std::vector<ObjMaterial> & materials, std::vector<Image> & images, std::vector<uint64_t> & imageHashes, std::vector<int> & materialImages);
+        static void findImages(const std::string & filename, const std::vector<ObjMaterial> & materials, std::vector<std::string> & imageFiles, std::vector<int> & materialImages);
+        static void loadImageFiles(const std::vector<std::string> & imageFiles, std::vector<Image> & images, std::vector<uint64_t> & imageHashes);
+        static uint64_t hashImageFile(const std::string & filename);
+
+    private:
+        MeshLoader(const MeshLoader &);
+        MeshLoader & operator= (const MeshLoader &);
+
+        static bool loadGltf(const std::string & filename, MeshLoadData & data);
+        static void extractPositions(MeshLoadData & data);
+        static void buildBvh(MeshLoadData & data, LinearArena * scratch);
+        void run();
+
+        std::vector<std::thread>                     m_threads;
+        std::deque<std::shared_ptr<MeshLoadRequest>> m_requests;
+        std::deque<std::shared_ptr<MeshLoadRequest>> m_loaded;
+        std::mutex                                   m_mutex;
+        std::condition_variable                      m_condition;
+        bool                                         m_stopping;
+};
+
+} // namespace ce
+
+#endif
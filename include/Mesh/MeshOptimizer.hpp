@@ -0,0 +1,81 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_MESH_OPTIMIZER_HPP
+#define CE_MESH_OPTIMIZER_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <vector>
+#include "OpenGL.hpp"
+
+#include "Mesh/MeshBuilder.hpp"
+
+// Size of the LRU cache that triangles are ordered for.
+#define CE_MESHOPTIMIZER_CACHE_SIZE   32
+
+// Size of the FIFO cache that the ACMR is measured with.
+#define CE_MESHOPTIMIZER_FIFO_SIZE    16
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief Reorders the triangles and vertices of a mesh so that
+// it renders faster, without changing how it looks.
+//
+// Each range (including those of the levels of detail) is
+// optimized on its own, so materials stay contiguous:
+//  - Triangles are ordered for post-transform vertex cache
+//    reuse with Tom Forsyth's "Linear-Speed Vertex Cache
+//    Optimisation".
+//  - The result is split into clusters wherever the cache runs
+//    cold, and the clusters are sorted so that those facing
+//    outwards are drawn first, which cuts overdraw while
+//    keeping most of the cache reuse (as in Sander et al.,
+//    "Fast Triangle Reordering for Vertex Locality and Reduced
+//    Overdraw").
+//  - Finally the vertices are renumbered in the order they are
+//    first used, so vertex fetches walk memory forwards.
+//
+////////////////////////////////////////////////////////////////
+class MeshOptimizer
+{
+    public:
+        static void optimize(MeshData & mesh);
+
+        static void optimizeVertexCache(GLuint * indices, const size_t indexCount, const size_t vertexCount);
+        static void optimizeOverdraw(GLuint * indices, const size_t indexCount, const std::vector<GLfloat> & vertices);
+        static void optimizeVertexFetch(MeshData & mesh);
+
+        static float getACMR(const GLuint * indices, const size_t indexCount, const size_t vertexCount);
+};
+
+} // namespace ce
+
+#endif
@@ -0,0 +1,66 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_MESH_QUANTIZER_HPP
+#define CE_MESH_QUANTIZER_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include "OpenGL.hpp"
+#include <glm/glm.hpp>
+
+#include "Mesh/MeshBuilder.hpp"
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief Packs the vertices of a mesh into
+// CE_MESH_QUANTIZED_VERTEX_BYTES bytes each, half of their
+// size as floats.
+//
+// Positions and texture coordinates are mapped onto the range
+// of the mesh's bounds and stored as normalized 16 bit values,
+// which keeps about 1/65535 of the mesh's size in precision.
+// Normals are projected onto an octahedron and stored as two
+// normalized bytes. The float vertices are kept, since the CPU
+// side still uses them.
+//
+////////////////////////////////////////////////////////////////
+class MeshQuantizer
+{
+    public:
+        static void quantize(MeshData & mesh);
+
+        static void encodeOctahedral(const glm::vec3 & normal, GLbyte encoded[2]);
+        static glm::vec3 decodeOctahedral(const GLbyte encoded[2]);
+};
+
+} // namespace ce
+
+#endif
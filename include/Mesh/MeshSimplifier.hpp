@@ -0,0 +1,78 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_MESH_SIMPLIFIER_HPP
+#define CE_MESH_SIMPLIFIER_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <vector>
+#include "OpenGL.hpp"
+
+#include "Mesh/MeshBuilder.hpp"
+
+// Most levels of detail that are built for a mesh.
+#define CE_MESHSIMPLIFIER_MAX_LODS      4
+
+// Largest error a level of detail may have, relative to the
+// size of the mesh.
+#define CE_MESHSIMPLIFIER_MAX_ERROR     0.05f
+
+// Levels that don't get below this fraction of the triangles of
+// the level before them are not worth keeping.
+#define CE_MESHSIMPLIFIER_MIN_REDUCTION 0.8f
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief Reduces the triangle count of meshes with quadric
+// error metrics (Garland and Heckbert, "Surface Simplification
+// Using Quadric Error Metrics").
+//
+// Edges are collapsed into one of their end points, so the
+// simplified triangles index the vertices of the original mesh
+// and every level of detail can share its vertex buffer.
+// Vertices on texture seams only move along other seam
+// vertices, and vertices on open borders (including the borders
+// between materials) only move along the border, so the levels
+// don't tear apart.
+//
+////////////////////////////////////////////////////////////////
+class MeshSimplifier
+{
+    public:
+        static float simplify(const std::vector<GLfloat> & vertices, const GLuint * indices, const size_t indexCount,
+                              const size_t targetIndexCount, const float maxError, std::vector<GLuint> & result);
+
+        static void buildLods(MeshData & mesh);
+};
+
+} // namespace ce
+
+#endif
@@ -0,0 +1,69 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_MESHLET_BUILDER_HPP
+#define CE_MESHLET_BUILDER_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include "OpenGL.hpp"
+
+#include "Mesh/MeshBuilder.hpp"
+
+// Most vertices and triangles in one meshlet.
+#define CE_MESHLET_MAX_VERTICES  64
+#define CE_MESHLET_MAX_TRIANGLES 124
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief Splits every range of a mesh into meshlets.
+//
+// Meshlets are grown one triangle at a time from a seed,
+// taking the neighbouring triangle that adds the fewest new
+// vertices and faces closest to the meshlet's average
+// direction, until they run out of neighbours or hit the
+// vertex or triangle limit. The triangles of each meshlet are
+// then moved together (in the order they had, so earlier
+// vertex cache optimization mostly survives), and its bounding
+// sphere and normal cone are computed for culling.
+//
+////////////////////////////////////////////////////////////////
+class MeshletBuilder
+{
+    public:
+        static void build(MeshData & mesh);
+
+    private:
+        static void buildRange(MeshData & mesh, const MeshRange & range);
+};
+
+} // namespace ce
+
+#endif
@@ -0,0 +1,97 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_MESHLET_CULLER_HPP
+#define CE_MESHLET_CULLER_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <vector>
+#include "OpenGL.hpp"
+#include <glm/glm.hpp>
+
+#include "Mesh/Mesh.hpp"
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief A run of draws in a MeshDrawList that all use the same
+// vertex array and texture.
+//
+////////////////////////////////////////////////////////////////
+struct MeshDrawBatch
+{
+    GLuint vao;
+    GLenum indexType;
+    GLuint texture;
+    size_t first;
+    size_t count;
+};
+
+////////////////////////////////////////////////////////////////
+// \brief The parts of a mesh left to draw after culling, laid
+// out for glMultiDrawElements. Keeping one around between frames
+// avoids reallocating it.
+//
+////////////////////////////////////////////////////////////////
+struct MeshDrawList
+{
+    std::vector<GLsizei>        counts;
+    std::vector<const GLvoid *> offsets;
+    std::vector<MeshDrawBatch>  batches;
+
+    void clear()
+    {
+        counts.clear();
+        offsets.clear();
+        batches.clear();
+    }
+};
+
+////////////////////////////////////////////////////////////////
+// \brief Builds the draw list of a mesh level of detail, leaving
+// out the meshlets that are outside of the view frustum or only
+// face away from the camera. Neighbouring meshlets that survive
+// are merged into one draw. Submeshes without meshlets are drawn
+// whole.
+//
+////////////////////////////////////////////////////////////////
+class MeshletCuller
+{
+    public:
+        static void cull(const Mesh & mesh, const size_t & lod, const glm::mat4 & model, const glm::mat4 & view, const glm::mat4 & projection, MeshDrawList & drawList);
+
+        // The normalized planes of a clip matrix's frustum, facing
+        // inwards.
+        static void getFrustumPlanes(const glm::mat4 & clip, glm::vec4 planes[6]);
+};
+
+} // namespace ce
+
+#endif
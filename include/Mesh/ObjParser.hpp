@@ -0,0 +1,139 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_OBJ_PARSER_HPP
+#define CE_OBJ_PARSER_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "LinearArena.hpp"
+#include "Logger.hpp"
+#include "MappedFile.hpp"
+
+#define CE_OBJPARSER_MIN_CHUNK_SIZE 1048576 // 1 MB per thread
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief One corner of a face, holding zero based indices into
+// the position, texture coordinate and normal arrays. Missing
+// indices (e.g. "f 1//1") are stored as -1.
+//
+////////////////////////////////////////////////////////////////
+struct ObjIndex
+{
+    int position;
+    int texCoord;
+    int normal;
+};
+
+////////////////////////////////////////////////////////////////
+// \brief A "usemtl" statement, which applies the named material
+// to every triangle from firstTriangle onwards.
+//
+////////////////////////////////////////////////////////////////
+struct ObjMaterialGroup
+{
+    std::string name;
+    size_t      firstTriangle;
+};
+
+////////////////////////////////////////////////////////////////
+// \brief Material properties read from an MTL file.
+//
+////////////////////////////////////////////////////////////////
+struct ObjMaterial
+{
+    ObjMaterial()
+        : diffuse(1.0f), specular(0.0f), shininess(0.0f)
+    { }
+
+    std::string name;
+    glm::vec3   diffuse;
+    glm::vec3   specular;
+    float       shininess;
+    std::string diffuseMap;
+};
+
+////////////////////////////////////////////////////////////////
+// \brief The raw contents of an OBJ file. Faces are triangulated
+// while parsing, so every three corners make up one triangle.
+//
+////////////////////////////////////////////////////////////////
+struct ObjData
+{
+    ////////////////////////////////////////////////////////////////
+    // Loaders that throw the data away once the mesh is built can
+    // keep it in a scratch arena.
+    ////////////////////////////////////////////////////////////////
+    explicit ObjData(LinearArena * arena = nullptr)
+        : positions(arena), texCoords(arena), normals(arena), corners(arena), materialGroups(arena)
+    { }
+
+    ArenaVector<glm::vec3>        positions;
+    ArenaVector<glm::vec2>        texCoords;
+    ArenaVector<glm::vec3>        normals;
+    ArenaVector<ObjIndex>         corners;
+    ArenaVector<ObjMaterialGroup> materialGroups;
+    std::string                   materialLibrary;
+};
+
+////////////////////////////////////////////////////////////////
+// \brief Reads Wavefront OBJ and MTL files.
+//
+// The files are memory mapped and lexed in place by walking a
+// pointer over the mapped bytes, so no copy of the file is made
+// and no global tokenizer state is used. Separate ObjParser
+// instances can safely be used from different threads.
+//
+// Large files are split into chunks at line boundaries that are
+// parsed on all cores, then stitched back together in order.
+//
+// Negative indices are resolved against the elements parsed in
+// the same call. Callers that parse a file in several pieces can
+// ask for them as (corner * 3 + attribute) to offset them.
+//
+////////////////////////////////////////////////////////////////
+class ObjParser
+{
+    public:
+        bool parseFile(const std::string & filename, ObjData & data);
+        void parse(const char * begin, const char * end, ObjData & data, std::vector<size_t> * relativeIndices=nullptr);
+
+        bool parseMaterialFile(const std::string & filename, std::vector<ObjMaterial> & materials);
+        void parseMaterials(const char * begin, const char * end, std::vector<ObjMaterial> & materials);
+};
+
+} // namespace ce
+
+#endif
@@ -0,0 +1,73 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_OBJ_STREAM_CONVERTER_HPP
+#define CE_OBJ_STREAM_CONVERTER_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <string>
+
+#include "Mesh/MeshChunkFile.hpp"
+
+#define CE_OBJSTREAM_WINDOW_SIZE         16777216 // 16 MB of OBJ text parsed at a time
+#define CE_OBJSTREAM_BUFFER_TRIANGLES    262144   // Triangles held while sorting them into chunks
+#define CE_OBJSTREAM_CHUNK_TRIANGLES     65536    // Triangles per chunk that the grid aims for
+#define CE_OBJSTREAM_MAX_CHUNK_TRIANGLES 262144   // Fuller grid cells are split into several chunks
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief Converts OBJ files that are too large to load at once
+// into a MeshChunkFile, keeping memory use fixed no matter how
+// large the file is.
+//
+// The conversion makes three passes, each of them bounded:
+//
+// 1. The OBJ file is read in windows of CE_OBJSTREAM_WINDOW_SIZE
+//    bytes. The attributes and triangles of every window are
+//    appended to temporary files next to the output.
+// 2. The triangles are sorted on disk into the cells of a grid
+//    over the mesh's bounds, sized so that a cell holds about
+//    CE_OBJSTREAM_CHUNK_TRIANGLES triangles.
+// 3. Every cell is welded into an indexed chunk and written out.
+//
+// The attribute files are memory mapped for random access while
+// the triangles look them up, which leaves paging them to the OS.
+//
+////////////////////////////////////////////////////////////////
+class ObjStreamConverter
+{
+    public:
+        static bool convert(const std::string & filename);
+};
+
+} // namespace ce
+
+#endif
@@ -0,0 +1,168 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_STATIC_BATCH_HPP
+#define CE_STATIC_BATCH_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "OpenGL.hpp"
+#include <glm/glm.hpp>
+
+#include "Image.hpp"
+#include "Mesh/MeshLoader.hpp"
+
+#define CE_STATIC_BATCH_COLORED_SIZE  9 // Floats per vertex
+#define CE_STATIC_BATCH_TEXTURED_SIZE 8
+#define CE_STATIC_BATCH_LIGHTMAP_SIZE 2 // Added by LightmapBaker
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief The vertex layouts of static batches, which match the
+// objects that they are built from.
+//
+////////////////////////////////////////////////////////////////
+enum StaticBatchLayout
+{
+    STATIC_BATCH_COLORED  = 0, // Position, color, normal (like createVoxel)
+    STATIC_BATCH_TEXTURED = 1  // Position, texture coordinate, normal (like createMesh)
+};
+
+////////////////////////////////////////////////////////////////
+// \brief The merged, pre-transformed geometry of one batch, along
+// with its bounds in world space.
+//
+// Once a lightmap is baked for it, every vertex is followed by
+// its lightmap coordinate.
+//
+////////////////////////////////////////////////////////////////
+struct StaticBatchData
+{
+    StaticBatchLayout    layout;
+    int                  image; // Index into the builder's images, or -1
+    std::vector<GLfloat> vertices;
+    std::vector<GLuint>  indices;
+    glm::vec3            boundsMin;
+    glm::vec3            boundsMax;
+
+    bool                 lightmapped;
+    Image                lightmap;
+
+    StaticBatchData()
+        : layout(STATIC_BATCH_COLORED), image(-1), lightmapped(false)
+    { }
+
+    size_t getVertexSize() const
+    {
+        return (layout == STATIC_BATCH_COLORED ? CE_STATIC_BATCH_COLORED_SIZE : CE_STATIC_BATCH_TEXTURED_SIZE) +
+               (lightmapped ? CE_STATIC_BATCH_LIGHTMAP_SIZE : 0);
+    }
+};
+
+////////////////////////////////////////////////////////////////
+// \brief A static batch uploaded to the GPU, drawn with a single
+// call.
+//
+////////////////////////////////////////////////////////////////
+struct StaticBatch
+{
+    StaticBatchLayout layout;
+    GLuint            vao;
+    GLuint            vbo;
+    GLuint            ebo;
+    GLuint            texture;  // 0 for colored batches
+    GLuint            lightmap; // 0 unless one was baked
+    GLenum            indexType;
+    GLsizei           indexCount;
+    glm::vec3         boundsMin;
+    glm::vec3         boundsMax;
+
+    std::shared_ptr<const GLuint> textureRef; // Keeps the shared texture alive
+};
+
+////////////////////////////////////////////////////////////////
+// \brief Collects objects that never move and merges the ones
+// that have the same vertex layout and texture into batches,
+// transforming their vertices into world space on the way.
+//
+// With a cell size, objects are also split into batches by the
+// grid cell that the center of their bounds falls in, so that
+// batches can be culled against the view. Models added more than
+// once are only loaded once.
+//
+// Lightmaps are baked once everything has been added, see
+// LightmapBaker.
+//
+////////////////////////////////////////////////////////////////
+class StaticBatchBuilder
+{
+    public:
+        StaticBatchBuilder(const float cellSize=0.0f);
+
+        void addVoxel(const glm::vec3 & tl, const glm::vec3 & size, const glm::vec3 & color, const glm::mat4 & model);
+        void addRect(const glm::vec2 & tl, const glm::vec2 & br, const glm::vec3 & color, const glm::mat4 & model);
+        bool addMesh(const std::string & filename, const glm::mat4 & model, const unsigned int flags=MESH_LOAD_DEFAULT);
+
+        const std::vector<StaticBatchData> & getBatches() const { return m_batches; }
+        std::vector<StaticBatchData> & getBatches() { return m_batches; }
+        std::vector<Image> & getImages() { return m_images; }
+        const std::vector<uint64_t> & getImageHashes() const { return m_imageHashes; }
+
+    private:
+        struct SourceMesh
+        {
+            std::string      filename;
+            unsigned int     flags;
+            MeshLoadData     data;
+            std::vector<int> materialImages; // Into the builder's images
+        };
+
+        void addColoredGeometry(const GLfloat * vertices, const size_t & vertexCount, const GLuint * indices, const size_t & indexCount, const glm::mat4 & model);
+        StaticBatchData & getBatch(const StaticBatchLayout & layout, const int & image, const glm::vec3 & center);
+        const SourceMesh * getSourceMesh(const std::string & filename, const unsigned int flags);
+
+        float                                                 m_cellSize;
+        std::vector<StaticBatchData>                          m_batches;
+        std::map<std::tuple<int, int, int, int, int>, size_t> m_batchIndices;
+        std::vector<std::unique_ptr<SourceMesh>>              m_meshes;
+        std::vector<Image>                                    m_images;
+        std::vector<uint64_t>                                 m_imageHashes;
+        LinearArena                                           m_scratch;
+};
+
+} // namespace ce
+
+#endif
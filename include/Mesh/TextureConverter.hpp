@@ -0,0 +1,70 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_TEXTURE_CONVERTER_HPP
+#define CE_TEXTURE_CONVERTER_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <string>
+
+#define CE_TEXTURE_HASH_EXTENSION ".hash" // Appended to the QOI filename
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief Converts the PNG diffuse maps of an OBJ model's material
+// library into QOI files, written next to them with ".qoi" added
+// to the PNG's name (see getQoiFilename()). Models are converted
+// ahead of time with the convert tool (tools/ConvertModel.cpp).
+//
+// MeshLoader prefers such a file over the PNG when it finds one,
+// since it decodes a few times faster and gives the same pixels.
+// The hash of the PNG it was converted from is kept next to it
+// (in a CE_TEXTURE_HASH_EXTENSION file), and a QOI file whose PNG
+// has changed since is logged and passed over until the model is
+// converted again.
+//
+////////////////////////////////////////////////////////////////
+class TextureConverter
+{
+    public:
+        static bool convert(const std::string & filename);
+
+        static bool hasCurrentQoi(const std::string & filename);
+        static std::string getQoiFilename(const std::string & filename);
+
+    private:
+        static bool convertImage(const std::string & filename);
+        static bool writeFile(const std::string & filename, const void * data, const size_t size);
+};
+
+} // namespace ce
+
+#endif
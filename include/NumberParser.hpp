@@ -0,0 +1,366 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_NUMBER_PARSER_HPP
+#define CE_NUMBER_PARSER_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <clocale>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CE_NUMBER_PARSER_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifndef _WIN32
+#include <locale.h>
+#endif
+
+////////////////////////////////////////////////////////////////
+// The slow path copies numbers up to this long onto the stack for
+// the C library, longer ones into a string.
+////////////////////////////////////////////////////////////////
+#define CE_NUMBER_PARSER_MAX_LENGTH 128
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief Locale independent number parsing for the asset loaders.
+//
+// Every function reads a number starting at p, never reads at
+// or beyond end, and returns a pointer just past the number (or
+// p itself if there was no number). Nothing is allocated, except
+// for numbers of CE_NUMBER_PARSER_MAX_LENGTH characters or more.
+//
+// parseDouble returns exactly what strtod would in the "C"
+// locale. Plain decimal numbers with up to 19 digits and a small
+// exponent, which is practically every number in an asset file,
+// take a fast path that converts eight digits at a time and is
+// exact by construction (Clinger's algorithm). Anything else is
+// passed to strtod_l with the "C" locale.
+//
+////////////////////////////////////////////////////////////////
+class NumberParser
+{
+    public:
+        static const char * parseDouble(const char * p, const char * end, double & value);
+        static const char * parseFloat(const char * p, const char * end, float & value);
+        static const char * parseInt(const char * p, const char * end, long & value);
+
+    private:
+        static size_t countDigits(const char * p, const char * end);
+        static uint64_t parseDigits(const char * p, size_t count);
+        static uint32_t parseEightDigits(uint64_t chunk);
+        static const char * parseDoubleSlow(const char * p, const char * end, double & value);
+};
+
+////////////////////////////////////////////////////////////////
+inline size_t NumberParser::countDigits(const char * p, const char * end)
+{
+    const char * start = p;
+
+#ifdef CE_NUMBER_PARSER_SSE2
+    // Classify 16 bytes at a time. A byte is a digit when
+    // (byte - '0') is at most 9 as an unsigned value.
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+
+    while (end - p >= 16)
+    {
+        __m128i chunk  = _mm_sub_epi8(_mm_loadu_si128((const __m128i *) p), zero);
+        __m128i digits = _mm_cmpeq_epi8(_mm_min_epu8(chunk, nine), chunk);
+        unsigned int mask = ~(unsigned int)_mm_movemask_epi8(digits) & 0xFFFF;
+
+        if (mask != 0)
+        {
+#ifdef _MSC_VER
+            unsigned long first;
+            _BitScanForward(&first, mask);
+            return (p - start) + first;
+#else
+            return (p - start) + __builtin_ctz(mask);
+#endif
+        }
+
+        p += 16;
+    }
+#endif
+
+    while (p < end && (unsigned char)(*p - '0') <= 9)
+        ++p;
+
+    return p - start;
+}
+
+////////////////////////////////////////////////////////////////
+inline uint32_t NumberParser::parseEightDigits(uint64_t chunk)
+{
+    // SWAR conversion of eight ASCII digits (first digit in the
+    // lowest byte): combine neighbouring digits, then pairs, then
+    // quads, using three multiplies instead of eight.
+    chunk -= 0x3030303030303030ULL;
+    chunk = (chunk * 10) + (chunk >> 8);
+    chunk = (((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+             (((chunk >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+
+    return (uint32_t) chunk;
+}
+
+////////////////////////////////////////////////////////////////
+inline uint64_t NumberParser::parseDigits(const char * p, size_t count)
+{
+    uint64_t value = 0;
+
+    // Callers only get here with at least 16 readable bytes, so whole
+    // eight byte loads are safe. A partial group is shifted up so the
+    // bytes past the digits fall off and the missing digits read as
+    // leading zeros.
+    while (count >= 8)
+    {
+        uint64_t chunk;
+        memcpy(&chunk, p, 8);
+        value = value * 100000000 + parseEightDigits(chunk);
+
+        p += 8;
+        count -= 8;
+    }
+
+    if (count > 0)
+    {
+        static const uint64_t powers[8] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000 };
+
+        uint64_t chunk;
+        memcpy(&chunk, p, 8);
+        chunk = (chunk - 0x3030303030303030ULL) << (8 * (8 - count));
+        value = value * powers[count] + parseEightDigits(chunk + 0x3030303030303030ULL);
+    }
+
+    return value;
+}
+
+////////////////////////////////////////////////////////////////
+inline const char * NumberParser::parseDoubleSlow(const char * p, const char * end, double & value)
+{
+    size_t length = 0;
+
+    // Copy everything strtod could possibly accept (including hex,
+    // "inf" and "nan") so it sees the same text it would in place.
+    while (p + length < end)
+    {
+        const char c = p[length];
+        const char lower = c | 0x20;
+
+        if (!((c >= '0' && c <= '9') || (lower >= 'a' && lower <= 'z') || c == '+' || c == '-' || c == '.'))
+            break;
+
+        ++length;
+    }
+
+    // However long the number is, strtod has to see all of it, or
+    // both the value and the end would be wrong.
+    char buffer[CE_NUMBER_PARSER_MAX_LENGTH];
+    std::string longNumber;
+    char * number = buffer;
+
+    if (length < sizeof(buffer))
+    {
+        memcpy(buffer, p, length);
+        buffer[length] = '\0';
+    }
+    else
+    {
+        longNumber.assign(p, length);
+        number = &longNumber[0];
+    }
+
+    char * numberEnd = number;
+
+#ifdef _WIN32
+    static _locale_t cLocale = _create_locale(LC_NUMERIC, "C");
+    value = _strtod_l(number, &numberEnd, cLocale);
+#else
+    static locale_t cLocale = newlocale(LC_NUMERIC_MASK, "C", (locale_t) 0);
+    value = strtod_l(number, &numberEnd, cLocale);
+#endif
+
+    return p + (numberEnd - number);
+}
+
+////////////////////////////////////////////////////////////////
+inline const char * NumberParser::parseDouble(const char * p, const char * end, double & value)
+{
+    // The fast path reads whole 8 and 16 byte blocks and never looks
+    // further than 64 bytes ahead, so numbers closer than that to the
+    // end of the buffer are parsed by the C library instead.
+    if (end - p < 64)
+        return parseDoubleSlow(p, end, value);
+
+    const char * start = p;
+    bool negative = false;
+
+    if (*p == '-' || *p == '+')
+    {
+        negative = *p == '-';
+        ++p;
+    }
+
+    // Up to 19 digits always fit into the 64 bit mantissa.
+    size_t integerDigits = countDigits(p, end);
+    if (integerDigits > 19)
+        return parseDoubleSlow(start, end, value);
+
+    const char * integer = p;
+    p += integerDigits;
+
+    // Hexadecimal floats ("0x1p3") are rare enough to leave to strtod.
+    if ((*p | 0x20) == 'x')
+        return parseDoubleSlow(start, end, value);
+
+    size_t fractionDigits = 0;
+    const char * fraction = p;
+
+    if (*p == '.')
+    {
+        fraction = ++p;
+        fractionDigits = countDigits(p, end);
+        p += fractionDigits;
+    }
+
+    if (integerDigits + fractionDigits == 0 || integerDigits + fractionDigits > 19)
+        return parseDoubleSlow(start, end, value);
+
+    long exponent = 0;
+
+    if ((*p | 0x20) == 'e')
+    {
+        const char * exponentStart = p + 1;
+        bool negativeExponent = false;
+
+        if (*exponentStart == '-' || *exponentStart == '+')
+        {
+            negativeExponent = *exponentStart == '-';
+            ++exponentStart;
+        }
+
+        size_t exponentDigits = countDigits(exponentStart, end);
+
+        // A bare "e" isn't part of the number, just like in strtod.
+        if (exponentDigits > 0)
+        {
+            if (exponentDigits > 4)
+                return parseDoubleSlow(start, end, value);
+
+            exponent = (long) parseDigits(exponentStart, exponentDigits);
+            exponent = negativeExponent ? -exponent : exponent;
+            p = exponentStart + exponentDigits;
+        }
+    }
+
+    static const uint64_t integerPowers[20] = {
+        1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+        100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+        10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+        100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+    };
+
+    uint64_t mantissa = parseDigits(integer, integerDigits) * integerPowers[fractionDigits] +
+                        parseDigits(fraction, fractionDigits);
+    exponent -= (long) fractionDigits;
+
+    // Both the mantissa and the power of ten are exact doubles in
+    // this range, so a single multiply or divide rounds correctly.
+    static const double powers[23] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    if (mantissa == 0)
+        value = 0.0;
+    else if (mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22)
+        value = exponent < 0 ? (double) mantissa / powers[-exponent] : (double) mantissa * powers[exponent];
+    else
+        return parseDoubleSlow(start, end, value);
+
+    value = negative ? -value : value;
+    return p;
+}
+
+////////////////////////////////////////////////////////////////
+inline const char * NumberParser::parseFloat(const char * p, const char * end, float & value)
+{
+    // Rounding through double matches (float)strtod() exactly.
+    double result;
+    p = parseDouble(p, end, result);
+    value = (float) result;
+
+    return p;
+}
+
+////////////////////////////////////////////////////////////////
+inline const char * NumberParser::parseInt(const char * p, const char * end, long & value)
+{
+    bool negative = false;
+
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+
+    size_t digits = countDigits(p, end);
+
+    if (digits <= 16 && end - p >= 16)
+        value = (long) parseDigits(p, digits);
+    else
+    {
+        // Unsigned, so that too many digits wrap around instead of
+        // overflowing.
+        unsigned long magnitude = 0;
+        for (size_t count = 0; count < digits; ++count)
+            magnitude = magnitude * 10 + (unsigned long)(p[count] - '0');
+
+        value = (long) magnitude;
+    }
+
+    value = negative ? (long)(0UL - (unsigned long) value) : value;
+    return p + digits;
+}
+
+} // namespace ce
+
+#endif
@@ -0,0 +1,244 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_PARALLEL_HPP
+#define CE_PARALLEL_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <deque>
+#include <vector>
+#include <algorithm>
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief Returns the number of threads that can run at once, and
+// never less than one.
+//
+////////////////////////////////////////////////////////////////
+inline unsigned int getThreadCount()
+{
+    unsigned int threadCount = std::thread::hardware_concurrency();
+    return threadCount > 0 ? threadCount : 1;
+}
+
+////////////////////////////////////////////////////////////////
+// \brief The threads that parallelFor hands work to. They are
+// started on first use and shared by every caller, so that
+// concurrent and nested calls (such as those of the MeshLoader
+// workers) never run more pool threads than there are cores, and
+// no call has to start threads of its own.
+//
+////////////////////////////////////////////////////////////////
+class ThreadPool
+{
+    public:
+        static ThreadPool & getInstance()
+        {
+            static ThreadPool pool;
+            return pool;
+        }
+
+        size_t getThreadCount() const
+        {
+            return m_threads.size();
+        }
+
+        void push(std::function<void()> && job)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_jobs.push_back(std::move(job));
+            }
+
+            m_condition.notify_one();
+        }
+
+    private:
+        ////////////////////////////////////////////////////////////////
+        // The thread that calls parallelFor works too, so the pool
+        // leaves it a core.
+        ////////////////////////////////////////////////////////////////
+        ThreadPool()
+            : m_stopping(false)
+        {
+            for (unsigned int thread = 1; thread < ce::getThreadCount(); ++thread)
+                m_threads.emplace_back(&ThreadPool::run, this);
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopping = true;
+            }
+
+            m_condition.notify_all();
+
+            for (std::thread & thread : m_threads)
+                thread.join();
+        }
+
+        ThreadPool(const ThreadPool &);
+        ThreadPool & operator= (const ThreadPool &);
+
+        void run()
+        {
+            for (;;)
+            {
+                std::function<void()> job;
+
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_condition.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+
+                    if (m_stopping)
+                        return;
+
+                    job = std::move(m_jobs.front());
+                    m_jobs.pop_front();
+                }
+
+                job();
+            }
+        }
+
+        ////////////////////////////////////////////////////////////////
+        // Member data
+        ////////////////////////////////////////////////////////////////
+        std::vector<std::thread>          m_threads;
+        std::deque<std::function<void()>> m_jobs;
+        std::mutex                        m_mutex;
+        std::condition_variable           m_condition;
+        bool                              m_stopping;
+};
+
+////////////////////////////////////////////////////////////////
+// \brief Calls function(index) for every index in [0, count),
+// spread over the ThreadPool. The calling thread takes part in
+// the work, and the call returns once every index has been
+// handled.
+//
+// Pool threads that only get to a call's job after the calling
+// thread has run out of indices skip it, so a call never waits
+// on jobs queued behind others, and nesting calls can't deadlock.
+//
+// An exception thrown by function on the calling thread is passed
+// on once the pool threads have let go of function; one thrown on
+// a pool thread ends the program, as with any std::thread.
+//
+////////////////////////////////////////////////////////////////
+template <typename Function>
+void parallelFor(const size_t count, const Function & function)
+{
+    ThreadPool & pool = ThreadPool::getInstance();
+    size_t helperCount = std::min<size_t>(pool.getThreadCount(), count > 0 ? count - 1 : 0);
+
+    if (helperCount == 0)
+    {
+        for (size_t index = 0; index < count; ++index)
+            function(index);
+
+        return;
+    }
+
+    struct Work
+    {
+        std::atomic<size_t>     nextIndex;
+        std::mutex              mutex;
+        std::condition_variable finished;
+        size_t                  running;
+        bool                    closed;
+    };
+
+    // Closes the call and waits for the helpers still running when
+    // it goes out of scope, also when function throws, and hands out
+    // no more indices so they're done after their current one.
+    struct WorkCloser
+    {
+        const std::shared_ptr<Work> & work;
+        size_t                        count;
+
+        ~WorkCloser()
+        {
+            work->nextIndex = count;
+
+            std::unique_lock<std::mutex> lock(work->mutex);
+            work->closed = true;
+            work->finished.wait(lock, [this]() { return work->running == 0; });
+        }
+    };
+
+    std::shared_ptr<Work> work = std::make_shared<Work>();
+    work->nextIndex = 0;
+    work->running   = 0;
+    work->closed    = false;
+
+    // Helpers only touch the function while the call is open, and
+    // the call doesn't return while any of them is still running.
+    const Function * body = &function;
+    WorkCloser closer = { work, count };
+
+    for (size_t helper = 0; helper < helperCount; ++helper)
+    {
+        pool.push([work, body, count]()
+        {
+            {
+                std::lock_guard<std::mutex> lock(work->mutex);
+
+                if (work->closed)
+                    return;
+
+                ++work->running;
+            }
+
+            for (size_t index = work->nextIndex++; index < count; index = work->nextIndex++)
+                (*body)(index);
+
+            std::lock_guard<std::mutex> lock(work->mutex);
+
+            if (--work->running == 0)
+                work->finished.notify_all();
+        });
+    }
+
+    for (size_t index = work->nextIndex++; index < count; index = work->nextIndex++)
+        function(index);
+}
+
+} // namespace ce
+
+#endif
@@ -0,0 +1,87 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CE_QOI_HPP
+#define CE_QOI_HPP
+
+////////////////////////////////////////////////////////////////
+// Headers
+////////////////////////////////////////////////////////////////
+#include <vector>
+#include <cstddef>
+
+#define CE_QOI_HEADER_SIZE 14       // "qoif", width, height, channels and colorspace
+#define CE_QOI_END_SIZE    8        // Seven zeros and a one close the stream
+#define CE_QOI_MAX_PIXELS  400000000 // Larger images are refused, as the reference decoder does
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief Encodes and decodes images in the "Quite OK Image"
+// format (https://qoiformat.org). It's lossless like PNG, and
+// the files are somewhat larger, but it is decoded in a single
+// pass over the bytes with no inflating or unfiltering, which
+// makes it a few times faster to load.
+//
+// Pixels are 8 bit RGBA, row by row from the top, exactly what
+// decodePNG gives for the same image.
+//
+////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////
+// \brief Whether the data starts like a QOI file.
+////////////////////////////////////////////////////////////////
+bool isQoi(const unsigned char * data, const size_t & size);
+
+////////////////////////////////////////////////////////////////
+// \brief Reads the width and height from the header. Returns
+// false if it isn't a valid QOI header.
+////////////////////////////////////////////////////////////////
+bool readQoiSize(const unsigned char * data, const size_t & size, unsigned long & width, unsigned long & height);
+
+////////////////////////////////////////////////////////////////
+// \brief Decodes straight into pixels, which must have room for
+// 4 * width * height bytes. They're only written to, so they can
+// be a mapped buffer. Returns false if the data is broken, with
+// the pixels after the break left as they were.
+////////////////////////////////////////////////////////////////
+bool decodeQoi(const unsigned char * data, const size_t & size, unsigned char * pixels, const size_t & pixelsSize);
+
+////////////////////////////////////////////////////////////////
+// \brief Decodes into a vector sized for the image.
+////////////////////////////////////////////////////////////////
+bool decodeQoi(const unsigned char * data, const size_t & size, std::vector<unsigned char> & pixels, unsigned long & width, unsigned long & height);
+
+////////////////////////////////////////////////////////////////
+// \brief Encodes RGBA pixels into a whole QOI file.
+////////////////////////////////////////////////////////////////
+void encodeQoi(const unsigned char * pixels, const unsigned long & width, const unsigned long & height, std::vector<unsigned char> & data);
+
+} // namespace ce
+
+#endif
@@ -32,6 +32,7 @@
 // Headers
 ////////////////////////////////////////////////////////////////
 #include <vector>
+#include <cstdint>
 #include <iostream>
 #include "OpenGL.hpp"
 #include <glm/glm.hpp>
@@ -41,10 +42,36 @@
 #include "Logger.hpp"
 #include "FileReader.hpp"
 #include "Image.hpp"
+#include "Mesh/ObjParser.hpp"
+#include "Mesh/Mesh.hpp"
+#include "Mesh/MeshBuilder.hpp"
+#include "Mesh/MeshCache.hpp"
+#include "Mesh/MeshOptimizer.hpp"
+#include "Mesh/MeshSimplifier.hpp"
+#include "Mesh/MeshQuantizer.hpp"
+#include "Mesh/MeshletBuilder.hpp"
+#include "Mesh/MeshletCuller.hpp"
+#include "Mesh/MeshBvh.hpp"
+#include "Mesh/MeshChunkFile.hpp"
+#include "Mesh/GltfParser.hpp"
+#include "Mesh/MeshLoader.hpp"
+#include "Mesh/StaticBatch.hpp"
+#include "Mesh/MeshImpostor.hpp"
+#include "Hash.hpp"
+#include "AssetCache.hpp"
 
 namespace ce
 {
 
+////////////////////////////////////////////////////////////////
+// \brief Shared handles to cached assets. The OpenGL objects of
+// an asset are deleted when its last handle is dropped.
+//
+////////////////////////////////////////////////////////////////
+typedef std::shared_ptr<const GLuint> TextureRef;
+typedef std::shared_ptr<const GLuint> ShaderRef;
+typedef std::shared_ptr<const Mesh>   MeshRef;
+
 ////////////////////////////////////////////////////////////////
 // \brief Interface for the Renderer service, don't instantiate.
 //
@@ -58,15 +85,18 @@ class IRenderer
 
         virtual GLuint generateVAO() = 0;
         virtual GLuint generateVBO() = 0;
+        virtual GLuint generateEBO() = 0;
         virtual GLuint generateTexture() = 0;
         virtual GLuint generateFrameBuffer() = 0;
         virtual GLuint generateRenderBuffer() = 0;
         virtual void bindVAO(const GLuint & vao) = 0;
         virtual void bindArrayBuffer(const GLuint & vbo, const unsigned int & vertexDataSize, const GLvoid * data, const bool & staticDraw=true) = 0;
+        virtual void bindElementBuffer(const GLuint & ebo, const unsigned int & indexDataSize, const GLvoid * data, const bool & staticDraw=true) = 0;
         virtual void bindTexture(const GLuint & texture) = 0;
         virtual void bindFrameBuffer(const GLuint & frameBuffer) = 0;
         virtual void bindRenderBuffer(const GLuint & renderBuffer) = 0;
-        virtual void addVertexAttribute(const GLint & size, const bool & normalize, const int & stride, const int & offset) = 0;
+        virtual void addVertexAttribute(const GLint & size, const bool & normalize, const int & stride, const int & offset, const GLenum & type=GL_FLOAT) = 0;
+        virtual void addIntegerVertexAttribute(const GLint & size, const GLenum & type, const int & stride, const int & offset) = 0;
         virtual void loadTextureImage(const unsigned char * textureData, const unsigned int & width, const unsigned int & height) = 0;
         virtual void loadEmptyTextureImage(const unsigned int & width, const unsigned int & height) = 0;
         virtual void attachRenderBufferToFrameBuffer(const GLuint & renderBuffer, const GLenum & renderBufferTarget=GL_DEPTH_ATTACHMENT) = 0;
@@ -74,9 +104,16 @@ class IRenderer
         virtual void unbindArrayBuffer() = 0;
         virtual void unbindTexture() = 0;
         virtual void setActiveTexture(const GLuint & textureHandle, const GLenum & texture=GL_TEXTURE0) = 0;
-        virtual void setTextureSampler(const GLuint & shaderProgram, const char * uniformName) = 0;
+        virtual void setTextureSampler(const GLuint & shaderProgram, const char * uniformName, const GLint & textureUnit=0) = 0;
         virtual void drawArrays(const GLuint & vao, const int & first, const int & count) = 0;
         virtual void drawArraysTriangleFan(const GLuint & vao, const int & first, const int & count) = 0;
+        virtual void drawElements(const GLuint & vao, const int & count, const GLenum & indexType, const size_t & offset=0) = 0;
+        virtual void drawMesh(const Mesh & mesh, const size_t & lod=0) = 0;
+        virtual void drawMeshList(const Mesh & mesh, const MeshDrawList & drawList) = 0;
+        virtual void drawMeshDepth(const Mesh & mesh, const size_t & lod=0) = 0;
+        virtual void drawMeshListDepth(const Mesh & mesh, const MeshDrawList & drawList) = 0;
+        virtual void drawStaticBatches(const std::vector<StaticBatch> & batches, const StaticBatchLayout & layout, const glm::mat4 & view, const glm::mat4 & projection) = 0;
+        virtual void drawImpostors(const MeshImpostor & impostor, const ImpostorBatch & batch) = 0;
         virtual void setColorDrawBuffer() = 0;
         virtual void setMinTextureFiltering(const GLint & filter) = 0;
         virtual void setMagTextureFiltering(const GLint & filter) = 0;
@@ -85,14 +122,30 @@ class IRenderer
         virtual void setRenderBufferStorage(const GLsizei & width, const GLsizei & height, const GLenum & internalFormat=GL_DEPTH_COMPONENT) = 0;
         virtual void setFrameBufferTexture(const GLuint & textureHandle, const GLenum & attachment=GL_COLOR_ATTACHMENT0, const GLint & mipMapLevel=0) = 0;
         virtual void passUniformMatrix(const GLuint & shaderProgram, const char * uniformName, const glm::mat4 & uniformMatrix, const bool & normalize=false) = 0;
+        virtual void passUniformVector(const GLuint & shaderProgram, const char * uniformName, const glm::vec2 & uniformVector) = 0;
+        virtual void passUniformVector(const GLuint & shaderProgram, const char * uniformName, const glm::vec3 & uniformVector) = 0;
         virtual GLuint createShaderProgram(const char * vertexShaderSource, const char * fragmentShaderSource) = 0;
         virtual GLuint createShaderProgramFromFiles(const char * vertexShaderFilename, const char * fragmentShaderFilename) = 0;
         virtual GLuint createRect(const GLfloat & width, const GLfloat & height, const glm::vec3 & color) = 0;
         virtual GLuint createRect(const glm::vec2 & tl, const glm::vec2 & br, const glm::vec3 & color) = 0;
         virtual GLuint createOctagon(const glm::vec2 & tl, const glm::vec2 & br, const glm::vec3 & color) = 0;
         virtual GLuint createVoxel(const glm::vec3 & tl, const glm::vec3 & size, const glm::vec3 & color) = 0;
-        virtual GLuint createMesh(const std::string & filename, GLuint & texture, size_t & numVertices) = 0;
+        virtual GLuint createVoxel(const glm::vec3 & tl, const glm::vec3 & size, const glm::vec3 & color, GLuint & depthVAO) = 0;
+        virtual Mesh createMesh(const std::string & filename, const unsigned int & flags=MESH_LOAD_DEFAULT) = 0;
+        virtual MeshHandle createMeshAsync(const std::string & filename, const unsigned int & flags=MESH_LOAD_DEFAULT) = 0;
+        virtual Mesh createMeshChunk(const MeshChunkFile & chunks, const size_t & chunk) = 0;
+        virtual std::vector<StaticBatch> createStaticBatches(StaticBatchBuilder & builder) = 0;
+        virtual void processMeshUploads(const size_t & maxUploads=1) = 0;
         virtual GLuint createFrameBuffer(const GLsizei & width, const GLsizei & height, GLuint & renderedTexture, GLuint & quadVAO) = 0;
+        virtual MeshImpostor createImpostor(const Mesh & mesh, const GLuint & shaderProgram, const ImpostorSettings & settings=ImpostorSettings()) = 0;
+        virtual void updateImpostor(MeshImpostor & impostor, const Mesh & mesh, const GLuint & shaderProgram, const size_t & firstView=0, const size_t & viewCount=SIZE_MAX) = 0;
+        virtual TextureRef loadTexture(const std::string & filename) = 0;
+        virtual ShaderRef loadShaderProgram(const std::string & vertexShaderFilename, const std::string & fragmentShaderFilename) = 0;
+        virtual MeshRef loadMesh(const std::string & filename, const unsigned int & flags=MESH_LOAD_DEFAULT) = 0;
+        virtual void deleteTexture(const GLuint & texture) = 0;
+        virtual void deleteShaderProgram(const GLuint & program) = 0;
+        virtual void deleteMesh(Mesh & mesh) = 0;
+        virtual void deleteImpostor(MeshImpostor & impostor) = 0;
 };
 
 ////////////////////////////////////////////////////////////////
@@ -109,16 +162,19 @@ class Renderer : public IRenderer
         // Low level OpenGL wrapper methods
         GLuint generateVAO();
         GLuint generateVBO();
+        GLuint generateEBO();
         GLuint generateTexture();
         GLuint generateFrameBuffer();
         GLuint generateRenderBuffer();
 
         void bindVAO(const GLuint & vao);
         void bindArrayBuffer(const GLuint & vbo, const unsigned int & vertexDataSize, const GLvoid * data, const bool & staticDraw=true);
+        void bindElementBuffer(const GLuint & ebo, const unsigned int & indexDataSize, const GLvoid * data, const bool & staticDraw=true);
         void bindTexture(const GLuint & texture);
         void bindFrameBuffer(const GLuint & framebuffer);
         void bindRenderBuffer(const GLuint & renderBuffer);
-        void addVertexAttribute(const GLint & size, const bool & normalize, const int & stride, const int & offset);
+        void addVertexAttribute(const GLint & size, const bool & normalize, const int & stride, const int & offset, const GLenum & type=GL_FLOAT);
+        void addIntegerVertexAttribute(const GLint & size, const GLenum & type, const int & stride, const int & offset);
         void loadTextureImage(const unsigned char * textureData, const unsigned int & width, const unsigned int & height);
         void loadEmptyTextureImage(const unsigned int & width, const unsigned int & height);
         void attachRenderBufferToFrameBuffer(const GLuint & renderBuffer, const GLenum & renderBufferTarget=GL_DEPTH_ATTACHMENT);
@@ -128,10 +184,17 @@ class Renderer : public IRenderer
         void unbindTexture();
 
         void setActiveTexture(const GLuint & textureHandle, const GLenum & texture=GL_TEXTURE0);
-        void setTextureSampler(const GLuint & shaderProgram, const char * uniformName);
+        void setTextureSampler(const GLuint & shaderProgram, const char * uniformName, const GLint & textureUnit=0);
 
         void drawArrays(const GLuint & vao, const int & first, const int & count);
         void drawArraysTriangleFan(const GLuint & vao, const int & first, const int & count);
+        void drawElements(const GLuint & vao, const int & count, const GLenum & indexType, const size_t & offset=0);
+        void drawMesh(const Mesh & mesh, const size_t & lod=0);
+        void drawMeshList(const Mesh & mesh, const MeshDrawList & drawList);
+        void drawMeshDepth(const Mesh & mesh, const size_t & lod=0);
+        void drawMeshListDepth(const Mesh & mesh, const MeshDrawList & drawList);
+        void drawStaticBatches(const std::vector<StaticBatch> & batches, const StaticBatchLayout & layout, const glm::mat4 & view, const glm::mat4 & projection);
+        void drawImpostors(const MeshImpostor & impostor, const ImpostorBatch & batch);
         void setColorDrawBuffer();
 
         void setMinTextureFiltering(const GLint & filter);
@@ -145,6 +208,8 @@ class Renderer : public IRenderer
         void setFrameBufferTexture(const GLuint & textureHandle, const GLenum & attachment=GL_COLOR_ATTACHMENT0, const GLint & mipMapLevel=0);
 
         void passUniformMatrix(const GLuint & shaderProgram, const char * uniformName, const glm::mat4 & uniformMatrix, const bool & normalize=false);
+        void passUniformVector(const GLuint & shaderProgram, const char * uniformName, const glm::vec2 & uniformVector);
+        void passUniformVector(const GLuint & shaderProgram, const char * uniformName, const glm::vec3 & uniformVector);
 
         // High level methods
         GLuint createShaderProgram(const char * vertexShaderSource, const char * fragmentShaderSource);
@@ -153,15 +218,76 @@ class Renderer : public IRenderer
         GLuint createRect(const glm::vec2 & tl, const glm::vec2 & br, const glm::vec3 & color);
         GLuint createOctagon(const glm::vec2 & tl, const glm::vec2 & br, const glm::vec3 & color);
         GLuint createVoxel(const glm::vec3 & tl, const glm::vec3 & size, const glm::vec3 & color);
-        GLuint createMesh(const std::string & filename, GLuint & texture, size_t & numVertices);
+        GLuint createVoxel(const glm::vec3 & tl, const glm::vec3 & size, const glm::vec3 & color, GLuint & depthVAO);
+        Mesh createMesh(const std::string & filename, const unsigned int & flags=MESH_LOAD_DEFAULT);
+        MeshHandle createMeshAsync(const std::string & filename, const unsigned int & flags=MESH_LOAD_DEFAULT);
+        Mesh createMeshChunk(const MeshChunkFile & chunks, const size_t & chunk);
+        std::vector<StaticBatch> createStaticBatches(StaticBatchBuilder & builder);
         GLuint createFrameBuffer(const GLsizei & width, const GLsizei & height, GLuint & renderedTexture, GLuint & quadVAO);
 
+        // Renders the mesh from every view of the impostor with
+        // shaderProgram, which has to write an alpha of 1 (see the
+        // impostor_capture shader). Updating a range of views spreads
+        // the work over frames, or refreshes a mesh that changed.
+        MeshImpostor createImpostor(const Mesh & mesh, const GLuint & shaderProgram, const ImpostorSettings & settings=ImpostorSettings());
+        void updateImpostor(MeshImpostor & impostor, const Mesh & mesh, const GLuint & shaderProgram, const size_t & firstView=0, const size_t & viewCount=SIZE_MAX);
+
+        // Uploads up to maxUploads meshes that finished loading in
+        // the background, call it once per frame.
+        void processMeshUploads(const size_t & maxUploads=1);
+
+        // Cached assets, shared by everyone who loads the same file
+        TextureRef loadTexture(const std::string & filename);
+        ShaderRef loadShaderProgram(const std::string & vertexShaderFilename, const std::string & fragmentShaderFilename);
+        MeshRef loadMesh(const std::string & filename, const unsigned int & flags=MESH_LOAD_DEFAULT);
+
+        void deleteTexture(const GLuint & texture);
+        void deleteShaderProgram(const GLuint & program);
+        void deleteMesh(Mesh & mesh);
+        void deleteImpostor(MeshImpostor & impostor);
+
     private:
+        ////////////////////////////////////////////////////////////
+        // The caches are shared with the deleters of the handles,
+        // which may outlive the renderer (and then have nothing
+        // left to delete).
+        ////////////////////////////////////////////////////////////
+        struct Assets
+        {
+            Renderer *               renderer;
+            AssetCache<const GLuint> textures; // By content hash
+            AssetCache<const GLuint> shaders;  // By canonical paths
+            AssetCache<const Mesh>   meshes;   // By canonical path and flags
+        };
+
+        TextureRef acquireTexture(Image & image, const uint64_t & hash);
+        TextureRef shareTexture(const GLuint & name, const uint64_t & hash);
+
+        Mesh uploadLoadedMesh(MeshLoadData & data);
+        Mesh uploadGltfMesh(MeshLoadData & data);
+        GLuint createMeshTexture(Image & image);
+        GLuint createMeshTexture(const unsigned char * data, const size_t & size);
+        GLuint createLightmapTexture(Image & image);
+        void createMaterialTextures(Mesh & mesh, std::vector<Image> & images, const std::vector<uint64_t> & imageHashes, const std::vector<int> & materialImages, std::vector<GLuint> & materialTextures);
+        void uploadMesh(Mesh & mesh, const GLvoid * vertexData, const size_t & vertexDataSize, const GLvoid * indexData, const size_t & indexDataSize);
+        void uploadPositions(Mesh & mesh, const std::vector<unsigned char> & positionData);
+        GLuint createVoxelBuffers(const glm::vec3 & tl, const glm::vec3 & size, const glm::vec3 & color, GLuint * depthVAO);
+        void loadMeshTextures(Mesh & mesh, const std::vector<MeshRange> & ranges, const std::vector<MeshLodData> & lods, std::vector<Image> & images, const std::vector<uint64_t> & imageHashes, const std::vector<int> & materialImages);
+
+        MeshLoader              m_meshLoader;
+        LinearArena             m_loadScratch; // For the loads done on the render thread
+        std::shared_ptr<Assets> m_assets;
+
         std::vector<GLuint> m_vaoList;
         std::vector<GLuint> m_vboList;
         std::vector<GLuint> m_textureList;
         std::vector<GLuint> m_frameBufferList;
         std::vector<GLuint> m_renderBufferList;
+        std::vector<GLuint> m_programList;
+
+        // Streams the quads of impostor batches.
+        GLuint m_impostorVAO;
+        GLuint m_impostorVBO;
 
         unsigned int m_vertexAttributeCount;
 };
@@ -171,15 +297,18 @@ class NullRenderer : public IRenderer
     public:
         GLuint generateVAO() { return 0; }
         GLuint generateVBO() { return 0; }
+        GLuint generateEBO() { return 0; }
         GLuint generateTexture() { return 0; }
         GLuint generateFrameBuffer() { return 0; }
         GLuint generateRenderBuffer() { return 0; }
         void bindVAO(const GLuint & vao) { }
         void bindArrayBuffer(const GLuint & vbo, const unsigned int & vertexDataSize, const GLvoid * data, const bool & staticDraw=true) { }
+        void bindElementBuffer(const GLuint & ebo, const unsigned int & indexDataSize, const GLvoid * data, const bool & staticDraw=true) { }
         void bindTexture(const GLuint & texture) { }
         void bindFrameBuffer(const GLuint & framebuffer) { }
         void bindRenderBuffer(const GLuint & renderBuffer) { }
-        void addVertexAttribute(const GLint & size, const bool & normalize, const int & stride, const int & offset) { }
+        void addVertexAttribute(const GLint & size, const bool & normalize, const int & stride, const int & offset, const GLenum & type=GL_FLOAT) { }
+        void addIntegerVertexAttribute(const GLint & size, const GLenum & type, const int & stride, const int & offset) { }
         void loadTextureImage(const unsigned char * textureData, const unsigned int & width, const unsigned int & height) { }
         void loadEmptyTextureImage(const unsigned int & width, const unsigned int & height) { }
         void attachRenderBufferToFrameBuffer(const GLuint & renderBuffer, const GLenum & renderBufferTarget=GL_DEPTH_ATTACHMENT) { }
@@ -187,9 +316,16 @@ class NullRenderer : public IRenderer
         void unbindArrayBuffer() { }
         void unbindTexture() { }
         void setActiveTexture(const GLuint & textureHandle, const GLenum & texture=GL_TEXTURE0) { }
-        void setTextureSampler(const GLuint & shaderProgram, const char * uniformName) { }
+        void setTextureSampler(const GLuint & shaderProgram, const char * uniformName, const GLint & textureUnit=0) { }
         void drawArrays(const GLuint & vao, const int & first, const int & count) { }
         void drawArraysTriangleFan(const GLuint & vao, const int & first, const int & count) { }
+        void drawElements(const GLuint & vao, const int & count, const GLenum & indexType, const size_t & offset=0) { }
+        void drawMesh(const Mesh & mesh, const size_t & lod=0) { }
+        void drawMeshList(const Mesh & mesh, const MeshDrawList & drawList) { }
+        void drawMeshDepth(const Mesh & mesh, const size_t & lod=0) { }
+        void drawMeshListDepth(const Mesh & mesh, const MeshDrawList & drawList) { }
+        void drawStaticBatches(const std::vector<StaticBatch> & batches, const StaticBatchLayout & layout, const glm::mat4 & view, const glm::mat4 & projection) { }
+        void drawImpostors(const MeshImpostor & impostor, const ImpostorBatch & batch) { }
         void setColorDrawBuffer() { }
         void setMinTextureFiltering(const GLint & filter) { }
         void setMagTextureFiltering(const GLint & filter) { }
@@ -198,14 +334,30 @@ class NullRenderer : public IRenderer
         void setRenderBufferStorage(const GLsizei & width, const GLsizei & height, const GLenum & internalFormat=GL_DEPTH_COMPONENT) { }
         void setFrameBufferTexture(const GLuint & textureHandle, const GLenum & attachment=GL_COLOR_ATTACHMENT0, const GLint & mipMapLevel=0) { }
         void passUniformMatrix(const GLuint & shaderProgram, const char * uniformName, const glm::mat4 & uniformMatrix, const bool & normalize=false) { }
+        void passUniformVector(const GLuint & shaderProgram, const char * uniformName, const glm::vec2 & uniformVector) { }
+        void passUniformVector(const GLuint & shaderProgram, const char * uniformName, const glm::vec3 & uniformVector) { }
         GLuint createShaderProgram(const char * vertexShaderSource, const char * fragmentShaderSource) { return 0; }
         GLuint createShaderProgramFromFiles(const char * vertexShaderFilename, const char * fragmentShaderFilename) { return 0; }
         GLuint createRect(const GLfloat & width, const GLfloat & height, const glm::vec3 & color) { return 0; }
         GLuint createRect(const glm::vec2 & tl, const glm::vec2 & br, const glm::vec3 & color) { return 0; }
         GLuint createOctagon(const glm::vec2 & tl, const glm::vec2 & br, const glm::vec3 & color) { return 0; }
         GLuint createVoxel(const glm::vec3 & tl, const glm::vec3 & size, const glm::vec3 & color) { return 0; }
-        GLuint createMesh(const std::string & filename, GLuint & texture, size_t & numVertices) { return 0; }
+        GLuint createVoxel(const glm::vec3 & tl, const glm::vec3 & size, const glm::vec3 & color, GLuint & depthVAO) { return 0; }
+        Mesh createMesh(const std::string & filename, const unsigned int & flags=MESH_LOAD_DEFAULT) { return Mesh(); }
+        MeshHandle createMeshAsync(const std::string & filename, const unsigned int & flags=MESH_LOAD_DEFAULT) { return MeshHandle(); }
+        Mesh createMeshChunk(const MeshChunkFile & chunks, const size_t & chunk) { return Mesh(); }
+        std::vector<StaticBatch> createStaticBatches(StaticBatchBuilder & builder) { return std::vector<StaticBatch>(); }
+        void processMeshUploads(const size_t & maxUploads=1) { }
+        TextureRef loadTexture(const std::string & filename) { return std::make_shared<const GLuint>(0); }
+        ShaderRef loadShaderProgram(const std::string & vertexShaderFilename, const std::string & fragmentShaderFilename) { return std::make_shared<const GLuint>(0); }
+        MeshRef loadMesh(const std::string & filename, const unsigned int & flags=MESH_LOAD_DEFAULT) { return std::make_shared<const Mesh>(); }
+        void deleteTexture(const GLuint & texture) { }
+        void deleteShaderProgram(const GLuint & program) { }
+        void deleteMesh(Mesh & mesh) { }
+        void deleteImpostor(MeshImpostor & impostor) { }
         GLuint createFrameBuffer(const GLsizei & width, const GLsizei & height, GLuint & renderedTexture, GLuint & quadVAO) { return 0; }
+        MeshImpostor createImpostor(const Mesh & mesh, const GLuint & shaderProgram, const ImpostorSettings & settings=ImpostorSettings()) { return MeshImpostor(); }
+        void updateImpostor(MeshImpostor & impostor, const Mesh & mesh, const GLuint & shaderProgram, const size_t & firstView=0, const size_t & viewCount=SIZE_MAX) { }
 };
 
 ////////////////////////////////////////////////////////////////
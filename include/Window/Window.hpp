@@ -52,6 +52,10 @@ class Window
         virtual void begin()             = 0;
         virtual void end()               = 0;
 
+        // In pixels, from the bottom left corner of the window.
+        glm::vec2 getMousePosition() const;
+        glm::vec2 getSize() const;
+
     protected:
         //////////////////////////////////////////////////////////////
         // Data members
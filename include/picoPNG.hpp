@@ -12,6 +12,8 @@
 #include <vector>
 #include <cstddef>
 
+namespace ce { class LinearArena; }
+
 /*
 decodePNG: The picoPNG function, decodes a PNG file buffer in memory, into a raw pixel buffer.
 out_image: output parameter, this will contain the raw pixels after decoding.
@@ -31,8 +33,29 @@ convert_to_rgba32: optional parameter, true by default.
   Information about the color type or palette colors are not provided. You need
   to know this information yourself to be able to use the data so this only
   works for trusted PNG files. Use LodePNG instead of picoPNG if you need this information.
+scratch: optional parameter, the arena that the decoder's image sized temporaries are
+  taken from. It is not reset by the decoder.
 return: 0 if success, not 0 if some error occured.
 */
-int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width, unsigned long& image_height, const unsigned char* in_png, size_t in_size, bool convert_to_rgba32 = true);
+int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width, unsigned long& image_height, const unsigned char* in_png, size_t in_size, bool convert_to_rgba32 = true, ce::LinearArena* scratch = 0);
+
+/*
+decodePNGInto: decodes a PNG file buffer in memory as 32-bit RGBA color, straight into a
+  buffer of the caller's, such as a mapped pixel unpack buffer. The IDAT chunks are inflated
+  where they are in in_png, and every scanline is unfiltered and converted as soon as it's
+  inflated, so besides out_pixels the decoder only needs about 128KB and two scanlines.
+  Interlaced images are still gathered whole before they're unfiltered.
+out_pixels: output parameter, the rows of pixels, top row first. It is only written to.
+out_size: size of out_pixels in bytes, at least 4 * width * height (see getPNGSize).
+The other parameters and the return value are the same as decodePNG's.
+*/
+int decodePNGInto(unsigned char* out_pixels, size_t out_size, unsigned long& image_width, unsigned long& image_height, const unsigned char* in_png, size_t in_size, ce::LinearArena* scratch = 0);
+
+/*
+getPNGSize: reads the width and height of a PNG file buffer in memory from its header,
+  without decoding the image.
+return: 0 if success, not 0 if the header isn't valid.
+*/
+int getPNGSize(unsigned long& image_width, unsigned long& image_height, const unsigned char* in_png, size_t in_size);
 
 #endif
@@ -0,0 +1,23 @@
+#version 330 core
+
+layout (location=0) in vec3 inPos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+// Quantized meshes map their positions back onto the mesh, for
+// the others these stay at 1 and 0.
+uniform vec3 positionScale = vec3(1.0);
+uniform vec3 positionOffset = vec3(0.0);
+
+// Computed the same way as in the entity shaders, so that their
+// depth matches the prepass exactly.
+invariant gl_Position;
+
+void main()
+{
+    vec3 position = vec3(model * vec4(inPos * positionScale + positionOffset, 1.0));
+
+    gl_Position = projection * view * vec4(position, 1.0);
+}
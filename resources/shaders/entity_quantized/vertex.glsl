@@ -0,0 +1,44 @@
+#version 330 core
+
+layout (location=0) in vec3 inPos;
+layout (location=1) in vec2 inText;
+layout (location=2) in ivec2 inNorm;
+
+out vec2 fragTexCoord;
+out vec3 fragNormal;
+out vec3 fragPosition;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+// Matches the depth shader, see depth/vertex.glsl.
+invariant gl_Position;
+
+// Map the normalized 16 bit attributes back onto the mesh.
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+uniform vec2 texCoordScale;
+uniform vec2 texCoordOffset;
+
+vec3 decodeOctahedral(ivec2 encoded)
+{
+    vec2 projected = max(vec2(encoded) / 127.0, -1.0);
+    vec3 normal = vec3(projected, 1.0 - abs(projected.x) - abs(projected.y));
+
+    // Unfold the lower half of the octahedron.
+    float fold = max(-normal.z, 0.0);
+    normal.x += normal.x >= 0.0 ? -fold : fold;
+    normal.y += normal.y >= 0.0 ? -fold : fold;
+
+    return normalize(normal);
+}
+
+void main()
+{
+    fragPosition = vec3(model * vec4(inPos * positionScale + positionOffset, 1.0));
+    fragNormal   = mat3(transpose(inverse(model))) * decodeOctahedral(inNorm);
+    fragTexCoord = inText * texCoordScale + texCoordOffset;
+
+    gl_Position = projection * view * vec4(fragPosition, 1.0);
+}
@@ -12,6 +12,9 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// Matches the depth shader, see depth/vertex.glsl.
+invariant gl_Position;
+
 void main()
 {
     fragPosition = vec3(model * vec4(inPos, 1.0));
@@ -0,0 +1,18 @@
+#version 330 core
+
+in vec2 fragTexCoord;
+
+layout (location=0) out vec3 color;
+
+uniform sampler2D text;
+
+void main()
+{
+    vec4 view = texture(text, fragTexCoord);
+
+    // Around the mesh, so nothing is drawn.
+    if (view.a < 0.5)
+        discard;
+
+    color = view.xyz;
+}
@@ -0,0 +1,17 @@
+#version 330 core
+
+layout (location=0) in vec3 inPos;
+layout (location=1) in vec2 inText;
+
+out vec2 fragTexCoord;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    // Impostor quads are already in world space.
+    fragTexCoord = inText;
+
+    gl_Position = projection * view * vec4(inPos, 1.0);
+}
@@ -0,0 +1,17 @@
+#version 330 core
+
+// Renders the views of an impostor. Goes with the vertex shader
+// of the mesh, entity_textured or entity_quantized.
+in vec2 fragTexCoord;
+in vec3 fragNormal;
+in vec3 fragPosition;
+
+layout (location=0) out vec4 color;
+
+uniform sampler2D text;
+
+void main()
+{
+    // Alpha tells the mesh apart from the space around it.
+    color = vec4(texture(text, fragTexCoord).xyz, 1.0);
+}
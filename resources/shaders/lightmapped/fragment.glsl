@@ -0,0 +1,18 @@
+#version 330 core
+
+in vec3 fragAttribute;
+in vec2 fragLightmap;
+
+layout (location=0) out vec3 color;
+
+uniform sampler2D text;
+uniform sampler2D lightmap;
+uniform bool textured;
+
+void main()
+{
+    vec3 albedo = textured ? texture(text, fragAttribute.xy).xyz : fragAttribute;
+
+    // Baked light is stored halved, see CE_LIGHTMAP_RANGE.
+    color = albedo * texture(lightmap, fragLightmap).xyz * 2.0;
+}
@@ -0,0 +1,22 @@
+#version 330 core
+
+// Static batches: colored ones carry a color at location 1,
+// textured ones a texture coordinate in its xy.
+layout (location=0) in vec3 inPos;
+layout (location=1) in vec3 inAttribute;
+layout (location=3) in vec2 inLightmap;
+
+out vec3 fragAttribute;
+out vec2 fragLightmap;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    fragAttribute = inAttribute;
+    fragLightmap  = inLightmap;
+
+    // Batches are already in world space.
+    gl_Position = projection * view * vec4(inPos, 1.0);
+}
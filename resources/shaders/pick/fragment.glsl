@@ -0,0 +1,12 @@
+#version 330 core
+
+layout (location=0) out vec3 color;
+
+// A flat color, so that the picked triangle stands out from the
+// textured mesh it is drawn over.
+uniform vec3 highlightColor;
+
+void main()
+{
+    color = highlightColor;
+}
@@ -0,0 +1,367 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#include <cstring>
+#include <limits>
+
+#include "Json.hpp"
+#include "Mesh/GltfParser.hpp"
+
+namespace ce
+{
+
+//////////////////////////////////////////////////////////////
+static int getComponentCount(const std::string & type)
+{
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2")   return 2;
+    if (type == "VEC3")   return 3;
+    if (type == "VEC4")   return 4;
+
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////
+static size_t getSize(const JsonValue & value)
+{
+    double number = value.getNumber(0.0);
+
+    // Casting numbers that don't fit is undefined, so they're made
+    // as large as possible instead, which no bounds check passes.
+    if (!(number >= 0.0 && number < (double) std::numeric_limits<size_t>::max()))
+        return std::numeric_limits<size_t>::max();
+
+    return (size_t) number;
+}
+
+//////////////////////////////////////////////////////////////
+size_t GltfParser::getComponentSize(const GLenum & componentType)
+{
+    switch (componentType)
+    {
+        case GL_BYTE:
+        case GL_UNSIGNED_BYTE:  return 1;
+        case GL_SHORT:
+        case GL_UNSIGNED_SHORT: return 2;
+        case GL_UNSIGNED_INT:
+        case GL_FLOAT:          return 4;
+        default:                return 0;
+    }
+}
+
+//////////////////////////////////////////////////////////////
+size_t GltfParser::getElementSize(const GltfAccessor & accessor)
+{
+    return getComponentSize(accessor.componentType) * accessor.componentCount;
+}
+
+//////////////////////////////////////////////////////////////
+size_t GltfParser::getStride(const GltfData & data, const GltfAccessor & accessor)
+{
+    size_t stride = data.bufferViews[accessor.bufferView].byteStride;
+    return stride != 0 ? stride : getElementSize(accessor);
+}
+
+//////////////////////////////////////////////////////////////
+static bool isValidAccessor(const GltfData & data, const int accessor, const int componentCount)
+{
+    if (accessor < 0 || (size_t) accessor >= data.accessors.size())
+        return false;
+
+    const GltfAccessor & info = data.accessors[accessor];
+
+    if (info.bufferView < 0 || info.componentCount != componentCount || info.count == 0 ||
+        GltfParser::getComponentSize(info.componentType) == 0)
+        return false;
+
+    // Every element, including the last one, has to be inside of
+    // the buffer view, and every element has to be aligned to its
+    // component size for OpenGL. The sizes are divided rather than
+    // multiplied, so that huge counts can't overflow.
+    const GltfBufferView & view = data.bufferViews[info.bufferView];
+    size_t componentSize = GltfParser::getComponentSize(info.componentType);
+    size_t elementSize = GltfParser::getElementSize(info);
+    size_t stride = GltfParser::getStride(data, info);
+
+    if (info.byteOffset > view.byteLength || elementSize > view.byteLength - info.byteOffset ||
+        info.count - 1 > (view.byteLength - info.byteOffset - elementSize) / stride)
+        return false;
+
+    return (view.byteOffset + info.byteOffset) % componentSize == 0 && stride % componentSize == 0;
+}
+
+//////////////////////////////////////////////////////////////
+template <typename Index>
+static size_t getLargestIndex(const unsigned char * indices, const size_t count)
+{
+    Index largest = 0;
+
+    for (size_t index = 0; index < count; ++index)
+    {
+        Index value;
+        memcpy(&value, indices + index * sizeof(Index), sizeof(Index));
+
+        largest = value > largest ? value : largest;
+    }
+
+    return largest;
+}
+
+//////////////////////////////////////////////////////////////
+static size_t getLargestIndex(const GltfData & data, const GltfAccessor & accessor)
+{
+    const unsigned char * indices = data.binary + data.bufferViews[accessor.bufferView].byteOffset + accessor.byteOffset;
+
+    if (accessor.componentType == GL_UNSIGNED_BYTE)
+        return getLargestIndex<GLubyte>(indices, accessor.count);
+
+    if (accessor.componentType == GL_UNSIGNED_SHORT)
+        return getLargestIndex<GLushort>(indices, accessor.count);
+
+    return getLargestIndex<GLuint>(indices, accessor.count);
+}
+
+//////////////////////////////////////////////////////////////
+bool GltfParser::parse(const char * begin, const char * end, GltfData & data)
+{
+    data = GltfData();
+    data.binary = nullptr;
+    data.binarySize = 0;
+
+    //////////////////////////////////////////
+    // Find the JSON and binary chunks.
+    //////////////////////////////////////////
+    uint32_t header[3];
+
+    if ((size_t)(end - begin) < sizeof(header))
+        return false;
+
+    memcpy(header, begin, sizeof(header));
+
+    if (header[0] != CE_GLTF_MAGIC || header[1] != 2 || header[2] > (size_t)(end - begin))
+    {
+        LOG("Not a valid binary glTF 2.0 file.");
+        return false;
+    }
+
+    const char * p = begin + sizeof(header);
+    end = begin + header[2];
+
+    const char * json = nullptr;
+    const char * jsonEnd = nullptr;
+
+    while (end - p >= 8)
+    {
+        uint32_t chunk[2];
+        memcpy(chunk, p, sizeof(chunk));
+        p += sizeof(chunk);
+
+        if (chunk[0] > (size_t)(end - p))
+            return false;
+
+        if (chunk[1] == CE_GLTF_CHUNK_JSON && json == nullptr)
+        {
+            json = p;
+            jsonEnd = p + chunk[0];
+        }
+        else if (chunk[1] == CE_GLTF_CHUNK_BIN && data.binary == nullptr)
+        {
+            data.binary = (const unsigned char *) p;
+            data.binarySize = chunk[0];
+        }
+
+        p += chunk[0];
+    }
+
+    JsonValue root;
+
+    if (json == nullptr || !JsonValue::parse(json, jsonEnd, root))
+    {
+        LOG("Could not read the glTF JSON chunk.");
+        return false;
+    }
+
+    //////////////////////////////////////////
+    // Buffer views. Only the binary chunk is
+    // supported as a buffer, so views into
+    // other buffers are left empty.
+    //////////////////////////////////////////
+    const JsonValue & bufferViews = root["bufferViews"];
+    data.bufferViews.resize(bufferViews.getSize());
+
+    for (size_t count = 0; count < data.bufferViews.size(); ++count)
+    {
+        const JsonValue & view = bufferViews[count];
+        GltfBufferView & result = data.bufferViews[count];
+
+        result.byteOffset = getSize(view["byteOffset"]);
+        result.byteLength = getSize(view["byteLength"]);
+        result.byteStride = getSize(view["byteStride"]);
+
+        if (view["buffer"].getInt(-1) != 0 || data.binary == nullptr ||
+            result.byteOffset > data.binarySize || result.byteLength > data.binarySize - result.byteOffset)
+        {
+            result.byteOffset = result.byteLength = 0;
+        }
+    }
+
+    //////////////////////////////////////////
+    // Accessors
+    //////////////////////////////////////////
+    const JsonValue & accessors = root["accessors"];
+    data.accessors.resize(accessors.getSize());
+
+    for (size_t count = 0; count < data.accessors.size(); ++count)
+    {
+        const JsonValue & accessor = accessors[count];
+        GltfAccessor & result = data.accessors[count];
+
+        result.bufferView     = accessor["bufferView"].getInt(-1);
+        result.byteOffset     = getSize(accessor["byteOffset"]);
+        result.componentType  = (GLenum) accessor["componentType"].getInt(0);
+        result.componentCount = getComponentCount(accessor["type"].getString());
+        result.count          = getSize(accessor["count"]);
+        result.normalized     = accessor["normalized"].getBool(false);
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            result.min[axis] = (float) accessor["min"][axis].getNumber(0.0);
+            result.max[axis] = (float) accessor["max"][axis].getNumber(0.0);
+        }
+
+        if (result.bufferView >= (int) data.bufferViews.size())
+            result.bufferView = -1;
+    }
+
+    //////////////////////////////////////////
+    // Materials and the images they use as
+    // their base color.
+    //////////////////////////////////////////
+    const JsonValue & images = root["images"];
+    data.images.resize(images.getSize());
+
+    for (size_t count = 0; count < data.images.size(); ++count)
+    {
+        data.images[count].bufferView = images[count]["bufferView"].getInt(-1);
+        data.images[count].uri        = images[count]["uri"].getString();
+        data.images[count].mimeType   = images[count]["mimeType"].getString();
+
+        if (data.images[count].bufferView >= (int) data.bufferViews.size())
+            data.images[count].bufferView = -1;
+    }
+
+    const JsonValue & textures  = root["textures"];
+    const JsonValue & materials = root["materials"];
+
+    data.materials.resize(materials.getSize());
+    data.materialImages.resize(materials.getSize(), -1);
+
+    for (size_t count = 0; count < data.materials.size(); ++count)
+    {
+        const JsonValue & material = materials[count];
+        const JsonValue & pbr = material["pbrMetallicRoughness"];
+
+        data.materials[count].name = material["name"].getString();
+
+        for (int channel = 0; channel < 3; ++channel)
+            data.materials[count].diffuse[channel] = (float) pbr["baseColorFactor"][channel].getNumber(1.0);
+
+        int texture = pbr["baseColorTexture"]["index"].getInt(-1);
+        int image = texture >= 0 ? textures[(size_t) texture]["source"].getInt(-1) : -1;
+
+        if (image >= 0 && (size_t) image < data.images.size())
+        {
+            data.materialImages[count] = image;
+            data.materials[count].diffuseMap = data.images[image].uri;
+        }
+    }
+
+    //////////////////////////////////////////
+    // The primitives of every mesh, in order.
+    //////////////////////////////////////////
+    const JsonValue & meshes = root["meshes"];
+
+    for (size_t mesh = 0; mesh < meshes.getSize(); ++mesh)
+    {
+        const JsonValue & primitives = meshes[mesh]["primitives"];
+
+        for (size_t count = 0; count < primitives.getSize(); ++count)
+        {
+            const JsonValue & primitive  = primitives[count];
+            const JsonValue & attributes = primitive["attributes"];
+
+            GltfPrimitive result;
+            result.position = attributes["POSITION"].getInt(-1);
+            result.texCoord = attributes["TEXCOORD_0"].getInt(-1);
+            result.normal   = attributes["NORMAL"].getInt(-1);
+            result.indices  = primitive["indices"].getInt(-1);
+            result.material = primitive["material"].getInt(-1);
+
+            if (primitive["mode"].getInt(GL_TRIANGLES) != GL_TRIANGLES || !isValidAccessor(data, result.position, 3) ||
+                !isValidAccessor(data, result.indices, 1))
+            {
+                LOG("Skipping a glTF primitive that isn't an indexed triangle list.");
+                continue;
+            }
+
+            // Indices have to be tightly packed unsigned integers.
+            const GltfAccessor & indices = data.accessors[result.indices];
+
+            if ((indices.componentType != GL_UNSIGNED_BYTE && indices.componentType != GL_UNSIGNED_SHORT && indices.componentType != GL_UNSIGNED_INT) ||
+                data.bufferViews[indices.bufferView].byteStride != 0 || indices.count % 3 != 0)
+            {
+                LOG("Skipping a glTF primitive with unsupported indices.");
+                continue;
+            }
+
+            // OpenGL doesn't check the indices it draws, so ones past
+            // the vertices would read outside of the vertex buffer.
+            const size_t vertexCount = data.accessors[result.position].count;
+
+            if (getLargestIndex(data, indices) >= vertexCount)
+            {
+                LOG("Skipping a glTF primitive whose indices go past its vertices.");
+                continue;
+            }
+
+            if (!isValidAccessor(data, result.texCoord, 2) || data.accessors[result.texCoord].count < vertexCount)
+                result.texCoord = -1;
+
+            if (!isValidAccessor(data, result.normal, 3) || data.accessors[result.normal].count < vertexCount)
+                result.normal = -1;
+
+            if (result.material >= (int) data.materials.size())
+                result.material = -1;
+
+            data.primitives.push_back(result);
+        }
+    }
+
+    return true;
+}
+
+} // namespace ce
@@ -0,0 +1,671 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+#include "Parallel.hpp"
+#include "Mesh/LightmapBaker.hpp"
+
+#define CE_LIGHTMAP_PI 3.14159265358979f
+
+namespace ce
+{
+
+//////////////////////////////////////////////////////////////
+// \brief Where a triangle is laid out in its lightmap. The
+// corners are in texels, relative to the chart.
+//////////////////////////////////////////////////////////////
+struct LightmapChart
+{
+    glm::vec2 corners[3];
+    int       x;
+    int       y;
+    int       width;
+    int       height;
+};
+
+//////////////////////////////////////////////////////////////
+static uint32_t hashSeed(uint32_t value)
+{
+    value = (value ^ 61) ^ (value >> 16);
+    value *= 9;
+    value = value ^ (value >> 4);
+    value *= 0x27D4EB2D;
+    value = value ^ (value >> 15);
+
+    return value != 0 ? value : 1;
+}
+
+//////////////////////////////////////////////////////////////
+static float nextRandom(uint32_t & state)
+{
+    // Xorshift, plenty for sampling directions.
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+
+    return (state >> 8) * (1.0f / 16777216.0f);
+}
+
+//////////////////////////////////////////////////////////////
+static glm::vec3 sampleCosine(const glm::vec3 & normal, uint32_t & random)
+{
+    float angle  = 2.0f * CE_LIGHTMAP_PI * nextRandom(random);
+    float square = nextRandom(random);
+    float radius = std::sqrt(square);
+
+    // A basis around the normal without branching on its axis
+    // (Duff et al., "Building an Orthonormal Basis, Revisited").
+    float sign = normal.z >= 0.0f ? 1.0f : -1.0f;
+    float a = -1.0f / (sign + normal.z);
+    float b = normal.x * normal.y * a;
+
+    glm::vec3 tangent(1.0f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x);
+    glm::vec3 bitangent(b, sign + normal.y * normal.y * a, -normal.y);
+
+    return tangent * (radius * std::cos(angle)) + bitangent * (radius * std::sin(angle)) + normal * std::sqrt(std::max(0.0f, 1.0f - square));
+}
+
+//////////////////////////////////////////////////////////////
+static float cross2(const glm::vec2 & left, const glm::vec2 & right)
+{
+    return left.x * right.y - left.y * right.x;
+}
+
+//////////////////////////////////////////////////////////////
+static glm::vec2 getClosestOnSegment(const glm::vec2 & point, const glm::vec2 & begin, const glm::vec2 & end)
+{
+    glm::vec2 segment = end - begin;
+    float lengthSquared = glm::dot(segment, segment);
+    float along = lengthSquared > 0.0f ? glm::clamp(glm::dot(point - begin, segment) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+
+    return begin + segment * along;
+}
+
+//////////////////////////////////////////////////////////////
+// \brief Lays every triangle of a batch flat in its plane at
+// density texels per unit and shelf packs them, tallest first.
+// The lightmap is at most maxSize wide, unless a chart is wider,
+// and as tall as the charts need.
+//////////////////////////////////////////////////////////////
+static void layCharts(const StaticBatchData & batch, const float density, const int padding, const int maxSize,
+                      std::vector<LightmapChart> & charts, int & width, int & height)
+{
+    const size_t stride = batch.getVertexSize();
+    const size_t triangleCount = batch.indices.size() / 3;
+
+    auto getPosition = [&](const size_t index)
+    {
+        const GLfloat * vertex = &batch.vertices[batch.indices[index] * stride];
+        return glm::vec3(vertex[0], vertex[1], vertex[2]);
+    };
+
+    std::vector<size_t> order(triangleCount);
+    double area = 0.0;
+    int widest = 0;
+
+    charts.resize(triangleCount);
+
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+    {
+        glm::vec3 edge1 = getPosition(triangle * 3 + 1) - getPosition(triangle * 3);
+        glm::vec3 edge2 = getPosition(triangle * 3 + 2) - getPosition(triangle * 3);
+        glm::vec3 normal = glm::cross(edge1, edge2);
+
+        LightmapChart & chart = charts[triangle];
+        glm::vec2 flat[3] = { glm::vec2(0.0f), glm::vec2(0.0f), glm::vec2(0.0f) };
+        float edgeLength = glm::length(edge1);
+
+        if (edgeLength > 0.0f && glm::length(normal) > 0.0f)
+        {
+            glm::vec3 axisU = edge1 / edgeLength;
+            glm::vec3 axisV = glm::normalize(glm::cross(normal, axisU));
+
+            flat[1] = glm::vec2(edgeLength, 0.0f) * density;
+            flat[2] = glm::vec2(glm::dot(edge2, axisU), glm::dot(edge2, axisV)) * density;
+        }
+
+        float left = std::min(0.0f, flat[2].x);
+        float right = std::max(flat[1].x, flat[2].x);
+
+        for (int corner = 0; corner < 3; ++corner)
+            chart.corners[corner] = flat[corner] + glm::vec2(padding - left, (float) padding);
+
+        chart.width  = (int) std::ceil(right - left) + padding * 2;
+        chart.height = (int) std::ceil(flat[2].y) + padding * 2;
+
+        area += (double) chart.width * chart.height;
+        widest = std::max(widest, chart.width);
+        order[triangle] = triangle;
+    }
+
+    std::sort(order.begin(), order.end(), [&](const size_t left, const size_t right)
+    {
+        return charts[left].height > charts[right].height;
+    });
+
+    width = 1;
+    while ((double) width * width < area || width < widest)
+        width <<= 1;
+
+    width = std::max(std::min(width, maxSize), widest);
+
+    int x = 0;
+    int y = 0;
+    int shelf = 0;
+
+    for (size_t triangle : order)
+    {
+        LightmapChart & chart = charts[triangle];
+
+        if (x + chart.width > width)
+        {
+            x = 0;
+            y += shelf;
+            shelf = 0;
+        }
+
+        chart.x = x;
+        chart.y = y;
+
+        x += chart.width;
+        shelf = std::max(shelf, chart.height);
+    }
+
+    height = y + shelf;
+}
+
+//////////////////////////////////////////////////////////////
+// \brief Copies the triangles in [firstIndex, lastIndex) of a
+// batch into a batch of their own, with only the vertices they
+// use.
+//////////////////////////////////////////////////////////////
+static StaticBatchData copyTriangles(const StaticBatchData & batch, const size_t firstIndex, const size_t lastIndex)
+{
+    const size_t stride = batch.getVertexSize();
+    std::vector<GLuint> remap(batch.vertices.size() / stride, (GLuint) -1);
+
+    StaticBatchData result;
+    result.layout      = batch.layout;
+    result.image       = batch.image;
+    result.lightmapped = batch.lightmapped;
+    result.boundsMin   = glm::vec3( FLT_MAX);
+    result.boundsMax   = glm::vec3(-FLT_MAX);
+    result.indices.reserve(lastIndex - firstIndex);
+
+    for (size_t index = firstIndex; index < lastIndex; ++index)
+    {
+        GLuint vertex = batch.indices[index];
+
+        if (remap[vertex] == (GLuint) -1)
+        {
+            const GLfloat * source = &batch.vertices[vertex * stride];
+
+            remap[vertex] = (GLuint)(result.vertices.size() / stride);
+            result.vertices.insert(result.vertices.end(), source, source + stride);
+            result.boundsMin = glm::min(result.boundsMin, glm::vec3(source[0], source[1], source[2]));
+            result.boundsMax = glm::max(result.boundsMax, glm::vec3(source[0], source[1], source[2]));
+        }
+
+        result.indices.push_back(remap[vertex]);
+    }
+
+    return result;
+}
+
+//////////////////////////////////////////////////////////////
+LightmapBaker::LightmapBaker(const LightmapSettings & settings)
+    : m_settings(settings), m_bias(0.0f)
+{ }
+
+//////////////////////////////////////////////////////////////
+void LightmapBaker::addLight(const glm::vec3 & position, const glm::vec3 & color)
+{
+    m_lights.push_back({ position, color });
+}
+
+//////////////////////////////////////////////////////////////
+void LightmapBaker::bake(StaticBatchBuilder & builder)
+{
+    std::vector<StaticBatchData> & batches = builder.getBatches();
+    std::vector<Image> & images = builder.getImages();
+
+    //////////////////////////////////////////
+    // Light bounces off textured surfaces with
+    // the average color of their texture.
+    //////////////////////////////////////////
+    std::vector<glm::vec3> imageColors(images.size(), glm::vec3(1.0f));
+
+    for (size_t image = 0; image < images.size(); ++image)
+    {
+        const std::vector<unsigned char> & pixels = images[image].getImageBuffer();
+        glm::vec3 sum(0.0f);
+
+        for (size_t pixel = 0; pixel + 3 < pixels.size(); pixel += 4)
+            sum += glm::vec3(pixels[pixel], pixels[pixel + 1], pixels[pixel + 2]);
+
+        if (!pixels.empty())
+            imageColors[image] = sum / (255.0f * (pixels.size() / 4));
+    }
+
+    //////////////////////////////////////////
+    // Split the batches whose charts don't fit
+    // into one lightmap at the lowest allowed
+    // resolution. Every chart takes at least a
+    // texel and its padding on either side.
+    //////////////////////////////////////////
+    const int padding = std::max(m_settings.padding, 1);
+    const float minDensity = std::min(m_settings.minTexelsPerUnit, m_settings.texelsPerUnit);
+    const size_t chartsPerSide = (size_t) std::max(m_settings.maxSize / (2 * padding + 1), 1);
+    const size_t batchCount = batches.size();
+
+    for (size_t batchIndex = 0; batchIndex < batches.size(); ++batchIndex)
+    {
+        for (;;)
+        {
+            const size_t triangleCount = batches[batchIndex].indices.size() / 3;
+
+            if (triangleCount <= 1)
+                break;
+
+            if (triangleCount <= chartsPerSide * chartsPerSide)
+            {
+                std::vector<LightmapChart> charts;
+                int width = 0;
+                int height = 0;
+
+                layCharts(batches[batchIndex], minDensity, padding, m_settings.maxSize, charts, width, height);
+
+                if (width <= m_settings.maxSize && height <= m_settings.maxSize)
+                    break;
+            }
+
+            const size_t middle = (triangleCount / 2) * 3;
+            StaticBatchData second = copyTriangles(batches[batchIndex], middle, batches[batchIndex].indices.size());
+
+            batches[batchIndex] = copyTriangles(batches[batchIndex], 0, middle);
+            batches.push_back(std::move(second));
+        }
+    }
+
+    if (batches.size() > batchCount)
+        LOG("Split the batches into " + std::to_string(batches.size()) + " to fit them into lightmaps.");
+
+    //////////////////////////////////////////
+    // Put the triangles of all the batches
+    // into one BVH to trace against.
+    //////////////////////////////////////////
+    std::vector<glm::vec3> corners;
+    glm::vec3 sceneMin( FLT_MAX);
+    glm::vec3 sceneMax(-FLT_MAX);
+
+    m_albedos.clear();
+
+    for (const StaticBatchData & batch : batches)
+    {
+        const size_t stride = batch.getVertexSize();
+
+        for (size_t triangle = 0; triangle + 2 < batch.indices.size(); triangle += 3)
+        {
+            glm::vec3 color(0.0f);
+
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                const GLfloat * vertex = &batch.vertices[batch.indices[triangle + corner] * stride];
+
+                corners.push_back(glm::vec3(vertex[0], vertex[1], vertex[2]));
+                sceneMin = glm::min(sceneMin, corners.back());
+                sceneMax = glm::max(sceneMax, corners.back());
+
+                if (batch.layout == STATIC_BATCH_COLORED)
+                    color += glm::vec3(vertex[3], vertex[4], vertex[5]) / 3.0f;
+            }
+
+            if (batch.layout == STATIC_BATCH_TEXTURED)
+                color = batch.image >= 0 ? imageColors[batch.image] : glm::vec3(1.0f);
+
+            m_albedos.push_back(color);
+        }
+    }
+
+    if (corners.empty())
+        return;
+
+    m_bias = std::max(glm::length(sceneMax - sceneMin) * 1e-4f, 1e-6f);
+    m_scene.build(&corners[0], corners.size() / 3);
+
+    std::vector<glm::vec3>().swap(corners);
+
+    LOG("Baking lightmaps for " + std::to_string(m_albedos.size()) + " triangles.");
+
+    for (size_t batchIndex = 0; batchIndex < batches.size(); ++batchIndex)
+    {
+        StaticBatchData & batch = batches[batchIndex];
+
+        const size_t stride = batch.getVertexSize();
+        const size_t baseSize = batch.layout == STATIC_BATCH_COLORED ? CE_STATIC_BATCH_COLORED_SIZE : CE_STATIC_BATCH_TEXTURED_SIZE;
+        const size_t normalOffset = batch.layout == STATIC_BATCH_COLORED ? 6 : 5;
+        const size_t triangleCount = batch.indices.size() / 3;
+
+        if (triangleCount == 0)
+            continue;
+
+        auto getPosition = [&](const size_t index)
+        {
+            const GLfloat * vertex = &batch.vertices[batch.indices[index] * stride];
+            return glm::vec3(vertex[0], vertex[1], vertex[2]);
+        };
+
+        auto getNormal = [&](const size_t index)
+        {
+            const GLfloat * vertex = &batch.vertices[batch.indices[index] * stride] + normalOffset;
+            return glm::vec3(vertex[0], vertex[1], vertex[2]);
+        };
+
+        //////////////////////////////////////////
+        // When the lightmap would grow too large,
+        // lay the charts out again at a lower
+        // resolution. Batches were split so that
+        // they fit at the lowest one allowed.
+        //////////////////////////////////////////
+        std::vector<LightmapChart> charts;
+        float density = m_settings.texelsPerUnit;
+        int width = 0;
+        int height = 0;
+
+        // Only a lone triangle may go below the lowest resolution,
+        // as it can't be split any further.
+        const float lowestDensity = triangleCount > 1 ? minDensity : 1e-6f;
+
+        for (;;)
+        {
+            layCharts(batch, density, padding, m_settings.maxSize, charts, width, height);
+
+            if ((width <= m_settings.maxSize && height <= m_settings.maxSize) || density <= lowestDensity)
+                break;
+
+            density *= std::min(0.9f, std::sqrt((float) m_settings.maxSize * m_settings.maxSize / ((float) width * height)));
+            density = std::max(density, lowestDensity);
+        }
+
+        if (width > m_settings.maxSize || height > m_settings.maxSize)
+        {
+            LOG("Could not fit a batch of " + std::to_string(triangleCount) + " triangles into a lightmap, it isn't baked.");
+            continue;
+        }
+
+        if (density < m_settings.texelsPerUnit)
+            LOG("Lowered the lightmap resolution of a batch to " + std::to_string(density) + " texels per unit to fit it.");
+
+        //////////////////////////////////////////
+        // Trace the texels that every triangle
+        // covers. Texels just outside of its edges
+        // are traced at the nearest point on it,
+        // so that filtering never reads texels
+        // that weren't baked.
+        //////////////////////////////////////////
+        std::vector<glm::vec3> light((size_t) width * height, glm::vec3(0.0f));
+        std::vector<unsigned char> covered((size_t) width * height, 0);
+
+        parallelFor(triangleCount, [&](const size_t triangle)
+        {
+            const LightmapChart & chart = charts[triangle];
+            const glm::vec2 offset((float) chart.x, (float) chart.y);
+            const glm::vec2 a = chart.corners[0] + offset;
+            const glm::vec2 b = chart.corners[1] + offset;
+            const glm::vec2 c = chart.corners[2] + offset;
+            const float area = cross2(b - a, c - a);
+
+            const glm::vec3 positions[3] = { getPosition(triangle * 3), getPosition(triangle * 3 + 1), getPosition(triangle * 3 + 2) };
+            const glm::vec3 normals[3] = { getNormal(triangle * 3), getNormal(triangle * 3 + 1), getNormal(triangle * 3 + 2) };
+            glm::vec3 facing = glm::cross(positions[1] - positions[0], positions[2] - positions[0]);
+
+            if (area <= 0.0f || glm::length(facing) <= 0.0f)
+                return;
+
+            facing = glm::normalize(facing);
+
+            if (glm::dot(facing, normals[0] + normals[1] + normals[2]) < 0.0f)
+                facing = -facing;
+
+            for (int y = chart.y; y < chart.y + chart.height; ++y)
+            {
+                for (int x = chart.x; x < chart.x + chart.width; ++x)
+                {
+                    glm::vec2 point(x + 0.5f, y + 0.5f);
+                    float weightB = cross2(point - a, c - a) / area;
+                    float weightC = cross2(b - a, point - a) / area;
+
+                    if (weightB < 0.0f || weightC < 0.0f || weightB + weightC > 1.0f)
+                    {
+                        glm::vec2 closest = getClosestOnSegment(point, a, b);
+
+                        for (const glm::vec2 & candidate : { getClosestOnSegment(point, b, c), getClosestOnSegment(point, c, a) })
+                        {
+                            if (glm::length(candidate - point) < glm::length(closest - point))
+                                closest = candidate;
+                        }
+
+                        // Only texels that a filtered lookup inside of
+                        // the triangle can reach.
+                        if (glm::length(closest - point) > 0.75f)
+                            continue;
+
+                        weightB = glm::clamp(cross2(closest - a, c - a) / area, 0.0f, 1.0f);
+                        weightC = glm::clamp(cross2(b - a, closest - a) / area, 0.0f, 1.0f - weightB);
+                    }
+
+                    float weightA = 1.0f - weightB - weightC;
+
+                    Texel texel;
+                    texel.position = positions[0] * weightA + positions[1] * weightB + positions[2] * weightC;
+                    texel.normal   = normals[0] * weightA + normals[1] * weightB + normals[2] * weightC;
+                    texel.facing   = facing;
+
+                    texel.normal = glm::length(texel.normal) > 0.0f ? glm::normalize(texel.normal) : facing;
+
+                    size_t index = (size_t) y * width + x;
+                    uint32_t random = hashSeed((uint32_t)(index * 2654435761u) ^ hashSeed((uint32_t) batchIndex));
+
+                    light[index]   = getLight(texel, random);
+                    covered[index] = 1;
+                }
+            }
+        });
+
+        //////////////////////////////////////////
+        // Grow the charts into their padding.
+        //////////////////////////////////////////
+        for (int pass = 0; pass < padding; ++pass)
+        {
+            std::vector<glm::vec3> grown = light;
+            std::vector<unsigned char> grownCovered = covered;
+
+            for (int y = 0; y < height; ++y)
+            {
+                for (int x = 0; x < width; ++x)
+                {
+                    size_t index = (size_t) y * width + x;
+
+                    if (covered[index])
+                        continue;
+
+                    glm::vec3 sum(0.0f);
+                    int count = 0;
+
+                    for (int neighbourY = std::max(y - 1, 0); neighbourY <= std::min(y + 1, height - 1); ++neighbourY)
+                    {
+                        for (int neighbourX = std::max(x - 1, 0); neighbourX <= std::min(x + 1, width - 1); ++neighbourX)
+                        {
+                            size_t neighbour = (size_t) neighbourY * width + neighbourX;
+
+                            if (covered[neighbour])
+                            {
+                                sum += light[neighbour];
+                                ++count;
+                            }
+                        }
+                    }
+
+                    if (count > 0)
+                    {
+                        grown[index] = sum / (float) count;
+                        grownCovered[index] = 1;
+                    }
+                }
+            }
+
+            light.swap(grown);
+            covered.swap(grownCovered);
+        }
+
+        std::vector<unsigned char> pixels((size_t) width * height * 4);
+
+        for (size_t texel = 0; texel < light.size(); ++texel)
+        {
+            for (int channel = 0; channel < 3; ++channel)
+                pixels[texel * 4 + channel] = (unsigned char)(glm::clamp(light[texel][channel] / CE_LIGHTMAP_RANGE, 0.0f, 1.0f) * 255.0f + 0.5f);
+
+            pixels[texel * 4 + 3] = 255;
+        }
+
+        //////////////////////////////////////////
+        // Give every corner its own vertex, with
+        // the lightmap coordinate after it.
+        //////////////////////////////////////////
+        std::vector<GLfloat> vertices;
+        vertices.reserve(triangleCount * 3 * (baseSize + CE_STATIC_BATCH_LIGHTMAP_SIZE));
+
+        for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+        {
+            const LightmapChart & chart = charts[triangle];
+
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                const GLfloat * vertex = &batch.vertices[batch.indices[triangle * 3 + corner] * stride];
+
+                vertices.insert(vertices.end(), vertex, vertex + baseSize);
+                vertices.push_back((chart.corners[corner].x + chart.x) / width);
+                vertices.push_back((chart.corners[corner].y + chart.y) / height);
+            }
+        }
+
+        batch.vertices.swap(vertices);
+
+        for (size_t index = 0; index < batch.indices.size(); ++index)
+            batch.indices[index] = (GLuint) index;
+
+        batch.lightmapped = true;
+        batch.lightmap.create(width, height, std::move(pixels));
+    }
+
+    LOG("Baked the lightmaps of " + std::to_string(batches.size()) + " batches.");
+
+    m_scene = MeshBvh();
+    std::vector<glm::vec3>().swap(m_albedos);
+}
+
+//////////////////////////////////////////////////////////////
+glm::vec3 LightmapBaker::getDirectLight(const glm::vec3 & position, const glm::vec3 & normal) const
+{
+    glm::vec3 light(0.0f);
+
+    for (const LightmapLight & source : m_lights)
+    {
+        glm::vec3 toLight = source.position - position;
+        float distance = glm::length(toLight);
+
+        if (distance <= 0.0f)
+            continue;
+
+        glm::vec3 direction = toLight / distance;
+        float lambert = glm::dot(normal, direction);
+
+        if (lambert <= 0.0f)
+            continue;
+
+        // Anything between the surface and the light shadows it.
+        MeshRayHit hit;
+        hit.distance = distance;
+
+        if (!m_scene.intersect(position, direction, hit))
+            light += source.color * lambert;
+    }
+
+    return light;
+}
+
+//////////////////////////////////////////////////////////////
+glm::vec3 LightmapBaker::getLight(const Texel & texel, uint32_t & random) const
+{
+    const glm::vec3 origin = texel.position + texel.facing * m_bias;
+    glm::vec3 indirect(0.0f);
+
+    for (int sample = 0; sample < m_settings.samples && m_settings.bounces > 0; ++sample)
+    {
+        glm::vec3 throughput(1.0f);
+        glm::vec3 position = origin;
+        glm::vec3 normal = texel.normal;
+
+        for (int bounce = 0; bounce < m_settings.bounces; ++bounce)
+        {
+            glm::vec3 direction = sampleCosine(normal, random);
+
+            // Interpolated normals can lean past the surface.
+            if (bounce == 0 && glm::dot(direction, texel.facing) <= 0.0f)
+                break;
+
+            MeshRayHit hit;
+
+            if (!m_scene.intersect(position, direction, hit))
+            {
+                indirect += throughput * m_settings.skyColor;
+                break;
+            }
+
+            glm::vec3 hitNormal = glm::normalize(hit.normal);
+
+            if (glm::dot(hitNormal, direction) > 0.0f)
+                hitNormal = -hitNormal;
+
+            throughput = throughput * m_albedos[hit.triangle];
+            position   = position + direction * hit.distance + hitNormal * m_bias;
+            normal     = hitNormal;
+
+            indirect += throughput * getDirectLight(position, normal);
+        }
+    }
+
+    if (m_settings.samples > 0)
+        indirect /= (float) m_settings.samples;
+
+    return getDirectLight(origin, texel.normal) + indirect;
+}
+
+} // namespace ce
@@ -0,0 +1,248 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#include <cfloat>
+#include <cstring>
+#include <algorithm>
+
+#include "Mesh/MeshBuilder.hpp"
+
+#define CE_MESHBUILDER_EMPTY_SLOT 0xFFFFFFFF
+
+namespace ce
+{
+
+//////////////////////////////////////////////////////////////
+static inline bool operator== (const ObjIndex & left, const ObjIndex & right)
+{
+    return left.position == right.position && left.texCoord == right.texCoord && left.normal == right.normal;
+}
+
+//////////////////////////////////////////////////////////////
+static inline size_t hashCorner(const ObjIndex & corner)
+{
+    uint64_t hash = (uint32_t) corner.position;
+    hash = (hash * 0x9E3779B97F4A7C15ULL) ^ (uint32_t) corner.texCoord;
+    hash = (hash * 0x9E3779B97F4A7C15ULL) ^ (uint32_t) corner.normal;
+
+    return (size_t)(hash ^ (hash >> 29));
+}
+
+//////////////////////////////////////////////////////////////
+static inline int validIndex(const int index, const size_t count)
+{
+    return (index >= 0 && (size_t)index < count) ? index : -1;
+}
+
+//////////////////////////////////////////////////////////////
+void MeshBuilder::build(const ObjData & obj, const std::vector<ObjMaterial> & materials, MeshData & mesh, LinearArena * scratch)
+{
+    const size_t cornerCount = obj.corners.size();
+
+    // Open addressing keeps the table in one allocation. Keeping it
+    // at most half full keeps the probe sequences short.
+    size_t tableSize = 16;
+    while (tableSize < cornerCount * 2)
+        tableSize <<= 1;
+
+    ArenaVector<GLuint>   table(tableSize, CE_MESHBUILDER_EMPTY_SLOT, scratch);
+    ArenaVector<ObjIndex> uniqueCorners(scratch);
+
+    // Every corner may turn out to be unique, and growing the list
+    // one push_back at a time would leave its old copies behind in
+    // the arena.
+    uniqueCorners.reserve(cornerCount);
+
+    mesh.vertices.clear();
+    mesh.indices.resize(cornerCount);
+    mesh.format = MeshVertexFormat();
+    mesh.quantizedVertices.clear();
+
+    for (size_t count = 0; count < cornerCount; ++count)
+    {
+        // Corners that are missing an attribute (or reference one
+        // outside of the file) fall back to zero for it.
+        ObjIndex corner;
+        corner.position = validIndex(obj.corners[count].position, obj.positions.size());
+        corner.texCoord = validIndex(obj.corners[count].texCoord, obj.texCoords.size());
+        corner.normal   = validIndex(obj.corners[count].normal,   obj.normals.size());
+
+        size_t slot = hashCorner(corner) & (tableSize - 1);
+
+        while (table[slot] != CE_MESHBUILDER_EMPTY_SLOT && !(uniqueCorners[table[slot]] == corner))
+            slot = (slot + 1) & (tableSize - 1);
+
+        if (table[slot] == CE_MESHBUILDER_EMPTY_SLOT)
+        {
+            table[slot] = (GLuint) uniqueCorners.size();
+            uniqueCorners.push_back(corner);
+        }
+
+        mesh.indices[count] = table[slot];
+    }
+
+    //////////////////////////////////////////
+    // Interleave the attributes of the unique
+    // vertices.
+    //////////////////////////////////////////
+    mesh.vertices.resize(uniqueCorners.size() * CE_MESH_VERTEX_SIZE, 0.0f);
+    GLfloat * vertex = mesh.vertices.empty() ? nullptr : &mesh.vertices[0];
+
+    mesh.boundsMin = glm::vec3(uniqueCorners.empty() ? 0.0f :  FLT_MAX);
+    mesh.boundsMax = glm::vec3(uniqueCorners.empty() ? 0.0f : -FLT_MAX);
+
+    for (const ObjIndex & corner : uniqueCorners)
+    {
+        if (corner.position >= 0)
+        {
+            vertex[0] = obj.positions[corner.position].x;
+            vertex[1] = obj.positions[corner.position].y;
+            vertex[2] = obj.positions[corner.position].z;
+        }
+
+        mesh.boundsMin = glm::min(mesh.boundsMin, glm::vec3(vertex[0], vertex[1], vertex[2]));
+        mesh.boundsMax = glm::max(mesh.boundsMax, glm::vec3(vertex[0], vertex[1], vertex[2]));
+
+        if (corner.texCoord >= 0)
+        {
+            vertex[3] = obj.texCoords[corner.texCoord].x;
+            vertex[4] = obj.texCoords[corner.texCoord].y;
+        }
+
+        if (corner.normal >= 0)
+        {
+            vertex[5] = obj.normals[corner.normal].x;
+            vertex[6] = obj.normals[corner.normal].y;
+            vertex[7] = obj.normals[corner.normal].z;
+        }
+
+        vertex += CE_MESH_VERTEX_SIZE;
+    }
+
+    //////////////////////////////////////////
+    // Find the material of every triangle from
+    // the usemtl groups.
+    //////////////////////////////////////////
+    mesh.materials = materials;
+    mesh.ranges.clear();
+    mesh.lods.clear();
+    mesh.meshlets.clear();
+
+    const size_t triangleCount = cornerCount / 3;
+    const size_t groupCount = obj.materialGroups.size();
+
+    // Slot 0 holds the triangles without a material, slot N + 1
+    // the ones that use materials[N].
+    ArenaVector<size_t> triangleSlots(triangleCount, 0, scratch);
+    ArenaVector<size_t> slotCounts(materials.size() + 1, 0, scratch);
+
+    for (size_t group = 0; group < groupCount; ++group)
+    {
+        size_t slot = 0;
+
+        for (size_t material = 0; material < materials.size(); ++material)
+        {
+            if (materials[material].name == obj.materialGroups[group].name)
+            {
+                slot = material + 1;
+                break;
+            }
+        }
+
+        size_t firstTriangle = std::min(obj.materialGroups[group].firstTriangle, triangleCount);
+        size_t endTriangle   = group + 1 < groupCount ? std::min(obj.materialGroups[group + 1].firstTriangle, triangleCount) : triangleCount;
+
+        for (size_t triangle = firstTriangle; triangle < endTriangle; ++triangle)
+            triangleSlots[triangle] = slot;
+    }
+
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+        ++slotCounts[triangleSlots[triangle]];
+
+    //////////////////////////////////////////
+    // Gather the triangles of each material
+    // into one contiguous range (keeping their
+    // order within it), so that every material
+    // is drawn with a single call.
+    //////////////////////////////////////////
+    ArenaVector<size_t> slotStarts(slotCounts.size(), 0, scratch);
+
+    for (size_t slot = 0; slot < slotCounts.size(); ++slot)
+    {
+        slotStarts[slot] = slot > 0 ? slotStarts[slot - 1] + slotCounts[slot - 1] : 0;
+
+        if (slotCounts[slot] > 0)
+        {
+            MeshRange range;
+            range.firstIndex = (GLuint)(slotStarts[slot] * 3);
+            range.indexCount = (GLuint)(slotCounts[slot] * 3);
+            range.material   = (int) slot - 1;
+
+            mesh.ranges.push_back(range);
+        }
+    }
+
+    if (mesh.ranges.size() > 1)
+    {
+        std::vector<GLuint> indices(triangleCount * 3);
+
+        for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+        {
+            size_t target = slotStarts[triangleSlots[triangle]]++;
+
+            indices[target * 3 + 0] = mesh.indices[triangle * 3 + 0];
+            indices[target * 3 + 1] = mesh.indices[triangle * 3 + 1];
+            indices[target * 3 + 2] = mesh.indices[triangle * 3 + 2];
+        }
+
+        mesh.indices.swap(indices);
+    }
+
+    LOG("Welded " + std::to_string(cornerCount) + " corners into " +
+        std::to_string(uniqueCorners.size()) + " vertices.");
+}
+
+//////////////////////////////////////////////////////////////
+void MeshBuilder::getIndexData(const MeshData & mesh, std::vector<unsigned char> & indexData)
+{
+    indexData.resize(mesh.indices.size() * mesh.getIndexSize());
+
+    if (mesh.getIndexType() == GL_UNSIGNED_INT)
+    {
+        if (!mesh.indices.empty())
+            memcpy(&indexData[0], &mesh.indices[0], indexData.size());
+    }
+    else
+    {
+        GLushort * indices = indexData.empty() ? nullptr : (GLushort *) &indexData[0];
+
+        for (size_t count = 0; count < mesh.indices.size(); ++count)
+            indices[count] = (GLushort) mesh.indices[count];
+    }
+}
+
+} // namespace ce
@@ -0,0 +1,465 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <algorithm>
+
+#include "Parallel.hpp"
+#include "Mesh/MeshBvh.hpp"
+
+namespace ce
+{
+
+//////////////////////////////////////////////////////////////
+// \brief The per triangle data that the build reads, and the
+// order of the triangles that it sorts into leaves.
+//////////////////////////////////////////////////////////////
+struct MeshBvhBuildInput
+{
+    const glm::vec3 * boundsMin;
+    const glm::vec3 * boundsMax;
+    const glm::vec3 * centroids;
+    uint32_t *        order;
+};
+
+//////////////////////////////////////////////////////////////
+// \brief A subtree that is left to be built on its own thread.
+//////////////////////////////////////////////////////////////
+struct MeshBvhTask
+{
+    size_t   node;
+    uint32_t begin;
+    uint32_t end;
+    int      depth;
+
+    std::vector<MeshBvhNode> nodes;
+};
+
+//////////////////////////////////////////////////////////////
+static float getHalfArea(const glm::vec3 & boundsMin, const glm::vec3 & boundsMax)
+{
+    glm::vec3 size = glm::max(boundsMax - boundsMin, glm::vec3(0.0f));
+    return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+//////////////////////////////////////////////////////////////
+static void buildNode(const MeshBvhBuildInput & input, std::vector<MeshBvhNode> & nodes, const size_t node,
+                      const uint32_t begin, const uint32_t end, const int depth, std::vector<MeshBvhTask> * tasks)
+{
+    glm::vec3 boundsMin( FLT_MAX), boundsMax(-FLT_MAX);
+    glm::vec3 centroidMin( FLT_MAX), centroidMax(-FLT_MAX);
+
+    for (uint32_t index = begin; index < end; ++index)
+    {
+        uint32_t triangle = input.order[index];
+
+        boundsMin   = glm::min(boundsMin, input.boundsMin[triangle]);
+        boundsMax   = glm::max(boundsMax, input.boundsMax[triangle]);
+        centroidMin = glm::min(centroidMin, input.centroids[triangle]);
+        centroidMax = glm::max(centroidMax, input.centroids[triangle]);
+    }
+
+    const uint32_t count = end - begin;
+
+    nodes[node].boundsMin = boundsMin;
+    nodes[node].boundsMax = boundsMax;
+    nodes[node].first     = begin;
+    nodes[node].count     = count;
+
+    if (count <= 1 || depth >= CE_MESHBVH_MAX_DEPTH)
+        return;
+
+    // Hand the subtree over to a thread of its own, keeping its
+    // range in the node until then.
+    if (tasks != nullptr && count <= CE_MESHBVH_TASK_SIZE)
+    {
+        tasks->push_back({ node, begin, end, depth, std::vector<MeshBvhNode>() });
+        return;
+    }
+
+    //////////////////////////////////////////
+    // Bin the centroids along every axis and
+    // find the cheapest split between bins.
+    //////////////////////////////////////////
+    float bestCost = FLT_MAX;
+    int bestAxis = -1;
+    int bestSplit = 0;
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        float extent = centroidMax[axis] - centroidMin[axis];
+
+        if (extent <= 0.0f)
+            continue;
+
+        glm::vec3 binMin[CE_MESHBVH_BINS], binMax[CE_MESHBVH_BINS];
+        uint32_t binCount[CE_MESHBVH_BINS] = { 0 };
+        float scale = CE_MESHBVH_BINS / extent;
+
+        for (int bin = 0; bin < CE_MESHBVH_BINS; ++bin)
+        {
+            binMin[bin] = glm::vec3( FLT_MAX);
+            binMax[bin] = glm::vec3(-FLT_MAX);
+        }
+
+        for (uint32_t index = begin; index < end; ++index)
+        {
+            uint32_t triangle = input.order[index];
+            int bin = std::min(CE_MESHBVH_BINS - 1, (int)((input.centroids[triangle][axis] - centroidMin[axis]) * scale));
+
+            binMin[bin] = glm::min(binMin[bin], input.boundsMin[triangle]);
+            binMax[bin] = glm::max(binMax[bin], input.boundsMax[triangle]);
+            ++binCount[bin];
+        }
+
+        // Sweep from the right to get the cost of everything past
+        // a split, then from the left to add the rest.
+        float rightCost[CE_MESHBVH_BINS];
+        glm::vec3 sweepMin( FLT_MAX), sweepMax(-FLT_MAX);
+        uint32_t sweepCount = 0;
+
+        for (int bin = CE_MESHBVH_BINS - 1; bin > 0; --bin)
+        {
+            sweepMin = glm::min(sweepMin, binMin[bin]);
+            sweepMax = glm::max(sweepMax, binMax[bin]);
+            sweepCount += binCount[bin];
+            rightCost[bin] = sweepCount * getHalfArea(sweepMin, sweepMax);
+        }
+
+        sweepMin = glm::vec3( FLT_MAX);
+        sweepMax = glm::vec3(-FLT_MAX);
+        sweepCount = 0;
+
+        for (int bin = 0; bin + 1 < CE_MESHBVH_BINS; ++bin)
+        {
+            sweepMin = glm::min(sweepMin, binMin[bin]);
+            sweepMax = glm::max(sweepMax, binMax[bin]);
+            sweepCount += binCount[bin];
+
+            if (sweepCount == 0 || sweepCount == count)
+                continue;
+
+            float cost = sweepCount * getHalfArea(sweepMin, sweepMax) + rightCost[bin + 1];
+
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = bin + 1;
+            }
+        }
+    }
+
+    // Splitting costs a box test for every triangle on top of what
+    // the children cost, relative to the area of the node.
+    float leafCost = (float) count;
+    float area = getHalfArea(boundsMin, boundsMax);
+    bestCost = area > 0.0f ? 1.0f + bestCost / area : FLT_MAX;
+
+    if (count <= CE_MESHBVH_MAX_LEAF_SIZE && bestCost >= leafCost)
+        return;
+
+    //////////////////////////////////////////
+    // Sort the triangles to either side. When
+    // the centroids can't be told apart they
+    // are simply halved.
+    //////////////////////////////////////////
+    uint32_t middle = begin + count / 2;
+
+    if (bestAxis >= 0)
+    {
+        float scale = CE_MESHBVH_BINS / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+        float offset = centroidMin[bestAxis];
+        const glm::vec3 * centroids = input.centroids;
+
+        uint32_t * split = std::partition(input.order + begin, input.order + end, [&](const uint32_t triangle)
+        {
+            return std::min(CE_MESHBVH_BINS - 1, (int)((centroids[triangle][bestAxis] - offset) * scale)) < bestSplit;
+        });
+
+        middle = (uint32_t)(split - input.order);
+    }
+
+    if (middle == begin || middle == end)
+        middle = begin + count / 2;
+
+    size_t left = nodes.size();
+    nodes.resize(left + 2);
+
+    nodes[node].first = (uint32_t) left;
+    nodes[node].count = 0;
+
+    buildNode(input, nodes, left,     begin,  middle, depth + 1, tasks);
+    buildNode(input, nodes, left + 1, middle, end,    depth + 1, tasks);
+}
+
+//////////////////////////////////////////////////////////////
+void MeshBvh::build(const glm::vec3 * corners, const size_t triangleCount, LinearArena * scratch)
+{
+    m_nodes.clear();
+    m_triangles.clear();
+
+    if (triangleCount == 0)
+        return;
+
+    ArenaVector<glm::vec3> boundsMin(triangleCount, glm::vec3(0.0f), scratch);
+    ArenaVector<glm::vec3> boundsMax(triangleCount, glm::vec3(0.0f), scratch);
+    ArenaVector<glm::vec3> centroids(triangleCount, glm::vec3(0.0f), scratch);
+    ArenaVector<uint32_t>  order(triangleCount, 0, scratch);
+
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+    {
+        const glm::vec3 * corner = corners + triangle * 3;
+
+        boundsMin[triangle] = glm::min(corner[0], glm::min(corner[1], corner[2]));
+        boundsMax[triangle] = glm::max(corner[0], glm::max(corner[1], corner[2]));
+        centroids[triangle] = (boundsMin[triangle] + boundsMax[triangle]) * 0.5f;
+        order[triangle]     = (uint32_t) triangle;
+    }
+
+    MeshBvhBuildInput input = { &boundsMin[0], &boundsMax[0], &centroids[0], &order[0] };
+
+    //////////////////////////////////////////
+    // Split the top of the tree here, then
+    // build the subtrees below it in parallel
+    // (each sorts its own range of the order)
+    // and append them in turn.
+    //////////////////////////////////////////
+    std::vector<MeshBvhTask> tasks;
+
+    m_nodes.reserve(triangleCount * 2 - 1);
+    m_nodes.resize(1);
+    buildNode(input, m_nodes, 0, 0, (uint32_t) triangleCount, 0, &tasks);
+
+    parallelFor(tasks.size(), [&](const size_t index)
+    {
+        MeshBvhTask & task = tasks[index];
+
+        task.nodes.resize(1);
+        buildNode(input, task.nodes, 0, task.begin, task.end, task.depth, nullptr);
+    });
+
+    for (const MeshBvhTask & task : tasks)
+    {
+        // The root of the subtree replaces the node it was split
+        // from, so the rest move down by one.
+        size_t offset = m_nodes.size() - 1;
+
+        for (size_t node = 0; node < task.nodes.size(); ++node)
+        {
+            MeshBvhNode copy = task.nodes[node];
+
+            if (copy.count == 0)
+                copy.first += (uint32_t) offset;
+
+            if (node == 0)
+                m_nodes[task.node] = copy;
+            else
+                m_nodes.push_back(copy);
+        }
+    }
+
+    m_nodes.shrink_to_fit();
+
+    //////////////////////////////////////////
+    // Store the triangles in leaf order.
+    //////////////////////////////////////////
+    m_triangles.resize(triangleCount);
+
+    for (size_t index = 0; index < triangleCount; ++index)
+    {
+        const glm::vec3 * corner = corners + order[index] * 3;
+
+        m_triangles[index].corner = corner[0];
+        m_triangles[index].edge1  = corner[1] - corner[0];
+        m_triangles[index].edge2  = corner[2] - corner[0];
+        m_triangles[index].index  = order[index];
+    }
+}
+
+//////////////////////////////////////////////////////////////
+// \brief Where a ray enters a box, or FLT_MAX when it misses it
+// or only enters it past the closest hit so far.
+//////////////////////////////////////////////////////////////
+static float intersectBox(const MeshBvhNode & node, const glm::vec3 & origin, const glm::vec3 & inverseDirection, const float closest)
+{
+    glm::vec3 near = (node.boundsMin - origin) * inverseDirection;
+    glm::vec3 far  = (node.boundsMax - origin) * inverseDirection;
+
+    glm::vec3 entry = glm::min(near, far);
+    glm::vec3 exit  = glm::max(near, far);
+
+    float enter = std::max(std::max(entry.x, entry.y), std::max(entry.z, 0.0f));
+    float leave = std::min(std::min(exit.x, exit.y), std::min(exit.z, closest));
+
+    return enter <= leave ? enter : FLT_MAX;
+}
+
+//////////////////////////////////////////////////////////////
+bool MeshBvh::intersect(const glm::vec3 & origin, const glm::vec3 & direction, MeshRayHit & hit) const
+{
+    if (m_nodes.empty())
+        return false;
+
+    const glm::vec3 inverseDirection = 1.0f / direction;
+    float closest = hit.distance;
+    bool found = false;
+
+    uint32_t stack[CE_MESHBVH_MAX_DEPTH + 1];
+    size_t stackSize = 0;
+    uint32_t node = 0;
+
+    if (intersectBox(m_nodes[0], origin, inverseDirection, closest) == FLT_MAX)
+        return false;
+
+    for (;;)
+    {
+        const MeshBvhNode & current = m_nodes[node];
+
+        if (current.count > 0)
+        {
+            //////////////////////////////////////////
+            // Moller-Trumbore against every triangle
+            // of the leaf, from either side.
+            //////////////////////////////////////////
+            for (uint32_t index = current.first; index < current.first + current.count; ++index)
+            {
+                const MeshBvhTriangle & triangle = m_triangles[index];
+
+                glm::vec3 p = glm::cross(direction, triangle.edge2);
+                float determinant = glm::dot(triangle.edge1, p);
+
+                if (std::fabs(determinant) < 1e-12f)
+                    continue;
+
+                float inverseDeterminant = 1.0f / determinant;
+                glm::vec3 t = origin - triangle.corner;
+                float u = glm::dot(t, p) * inverseDeterminant;
+
+                if (u < 0.0f || u > 1.0f)
+                    continue;
+
+                glm::vec3 q = glm::cross(t, triangle.edge1);
+                float v = glm::dot(direction, q) * inverseDeterminant;
+
+                if (v < 0.0f || u + v > 1.0f)
+                    continue;
+
+                float distance = glm::dot(triangle.edge2, q) * inverseDeterminant;
+
+                if (distance >= 0.0f && distance < closest)
+                {
+                    closest = distance;
+                    found = true;
+
+                    hit.triangle = triangle.index;
+                    hit.distance = distance;
+                    hit.uv       = glm::vec2(u, v);
+                    hit.normal   = glm::cross(triangle.edge1, triangle.edge2);
+                }
+            }
+        }
+        else
+        {
+            //////////////////////////////////////////
+            // Visit the nearer child first and come
+            // back to the other one if it may still
+            // hold something closer.
+            //////////////////////////////////////////
+            uint32_t nearChild = current.first;
+            uint32_t farChild  = current.first + 1;
+
+            float nearDistance = intersectBox(m_nodes[nearChild], origin, inverseDirection, closest);
+            float farDistance  = intersectBox(m_nodes[farChild],  origin, inverseDirection, closest);
+
+            if (farDistance < nearDistance)
+            {
+                std::swap(nearChild, farChild);
+                std::swap(nearDistance, farDistance);
+            }
+
+            if (nearDistance != FLT_MAX)
+            {
+                if (farDistance != FLT_MAX)
+                    stack[stackSize++] = farChild;
+
+                node = nearChild;
+                continue;
+            }
+        }
+
+        // Skip the subtrees that start behind the closest hit.
+        bool next = false;
+
+        while (stackSize > 0 && !next)
+        {
+            node = stack[--stackSize];
+            next = intersectBox(m_nodes[node], origin, inverseDirection, closest) != FLT_MAX;
+        }
+
+        if (!next)
+            break;
+    }
+
+    return found;
+}
+
+//////////////////////////////////////////////////////////////
+bool MeshBvh::raycast(const Mesh & mesh, const glm::mat4 & model, const glm::vec3 & origin, const glm::vec3 & direction, MeshRayHit & hit)
+{
+    if (!mesh.bvh)
+        return false;
+
+    // The ray isn't normalized in model space, so that distances
+    // along it stay the same in both spaces.
+    glm::mat4 inverseModel = glm::inverse(model);
+    glm::vec3 localOrigin    = glm::vec3(inverseModel * glm::vec4(origin, 1.0f));
+    glm::vec3 localDirection = glm::vec3(inverseModel * glm::vec4(direction, 0.0f));
+
+    if (!mesh.bvh->intersect(localOrigin, localDirection, hit))
+        return false;
+
+    hit.position = origin + direction * hit.distance;
+    hit.normal   = glm::normalize(glm::vec3(glm::transpose(inverseModel) * glm::vec4(hit.normal, 0.0f)));
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////
+void MeshBvh::getPickRay(const glm::vec2 & point, const glm::vec2 & viewportSize, const glm::mat4 & view, const glm::mat4 & projection, glm::vec3 & origin, glm::vec3 & direction)
+{
+    glm::vec2 device = point / viewportSize * 2.0f - 1.0f;
+    glm::mat4 inverseClip = glm::inverse(projection * view);
+
+    glm::vec4 nearPoint = inverseClip * glm::vec4(device, -1.0f, 1.0f);
+    glm::vec4 farPoint  = inverseClip * glm::vec4(device,  1.0f, 1.0f);
+
+    origin    = glm::vec3(nearPoint) / nearPoint.w;
+    direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+}
+
+} // namespace ce
@@ -0,0 +1,657 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#include "Hash.hpp"
+#include "Mesh/MeshCache.hpp"
+
+// The fewest bytes a level of detail (its error and range count)
+// and a material (empty names, colors and shininess) can take up.
+#define CE_MESHCACHE_MIN_LOD_BYTES      (sizeof(float) + sizeof(uint32_t))
+#define CE_MESHCACHE_MIN_MATERIAL_BYTES (2 * sizeof(uint32_t) + 7 * sizeof(float))
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief How a MeshRange is laid out in a cooked mesh file.
+//
+////////////////////////////////////////////////////////////////
+struct MeshCacheRange
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    int32_t  material;
+};
+
+////////////////////////////////////////////////////////////////
+// \brief How a Meshlet is laid out in a cooked mesh file.
+//
+////////////////////////////////////////////////////////////////
+struct MeshCacheMeshlet
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float    center[3];
+    float    radius;
+    float    coneAxis[3];
+    float    coneCutoff;
+};
+
+//////////////////////////////////////////////////////////////
+static inline uint64_t alignOffset(const uint64_t offset)
+{
+    return (offset + CE_MESHCACHE_ALIGNMENT - 1) & ~(uint64_t)(CE_MESHCACHE_ALIGNMENT - 1);
+}
+
+//////////////////////////////////////////////////////////////
+static void writeString(std::vector<unsigned char> & buffer, const std::string & value)
+{
+    uint32_t length = (uint32_t) value.size();
+
+    buffer.insert(buffer.end(), (const unsigned char *) &length, (const unsigned char *) &length + sizeof(length));
+    buffer.insert(buffer.end(), value.begin(), value.end());
+}
+
+//////////////////////////////////////////////////////////////
+static void writeFloats(std::vector<unsigned char> & buffer, const float * values, const size_t count)
+{
+    buffer.insert(buffer.end(), (const unsigned char *) values, (const unsigned char *)(values + count));
+}
+
+//////////////////////////////////////////////////////////////
+static bool readString(const char *& p, const char * end, std::string & value)
+{
+    uint32_t length;
+
+    if (end - p < (ptrdiff_t) sizeof(length))
+        return false;
+
+    memcpy(&length, p, sizeof(length));
+    p += sizeof(length);
+
+    if ((size_t)(end - p) < length)
+        return false;
+
+    value.assign(p, length);
+    p += length;
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////
+static bool readFloats(const char *& p, const char * end, float * values, const size_t count)
+{
+    if ((size_t)(end - p) < count * sizeof(float))
+        return false;
+
+    memcpy(values, p, count * sizeof(float));
+    p += count * sizeof(float);
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////
+static bool countFits(const uint64_t count, const uint64_t recordSize, const uint64_t sectionBegin, const uint64_t sectionEnd)
+{
+    return sectionBegin <= sectionEnd && count <= (sectionEnd - sectionBegin) / recordSize;
+}
+
+//////////////////////////////////////////////////////////////
+static bool rangesFit(const std::vector<MeshRange> & ranges, const uint64_t indexCount)
+{
+    for (const MeshRange & range : ranges)
+    {
+        if ((uint64_t) range.firstIndex + range.indexCount > indexCount)
+            return false;
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////
+template <typename Index>
+static bool indicesFit(const char * data, const size_t indexCount, const uint64_t vertexCount)
+{
+    Index largest = 0;
+
+    for (size_t count = 0; count < indexCount; ++count)
+    {
+        Index index;
+        memcpy(&index, data + count * sizeof(Index), sizeof(Index));
+
+        largest = index > largest ? index : largest;
+    }
+
+    return indexCount == 0 || largest < vertexCount;
+}
+
+//////////////////////////////////////////////////////////////
+MeshCache::MeshCache()
+    : m_header(nullptr)
+{ }
+
+//////////////////////////////////////////////////////////////
+std::string MeshCache::getCacheFilename(const std::string & filename)
+{
+    return filename + CE_MESHCACHE_EXTENSION;
+}
+
+//////////////////////////////////////////////////////////////
+uint64_t MeshCache::hashMaterialLibrary(const std::string & filename, const std::string & materialLibrary)
+{
+    if (materialLibrary == "")
+        return 0;
+
+    std::size_t endOfPath = filename.find_last_of("/") + 1;
+    MappedFile file(filename.substr(0, endOfPath) + materialLibrary);
+
+    // A missing library still hashes to something other than 0,
+    // so the mesh is cooked again once the library shows up.
+    if (!file.isOpen())
+        return 1;
+
+    return hashBytes(file.getData(), file.getSize());
+}
+
+//////////////////////////////////////////////////////////////
+bool MeshCache::open(const std::string & filename, const uint64_t sourceHash, const unsigned int flags)
+{
+    m_header = nullptr;
+
+    std::string cacheFilename = getCacheFilename(filename);
+
+    // Not having been cooked yet is the common case, so check for
+    // the file quietly before mapping it.
+    if (!std::ifstream(cacheFilename).good() || !m_file.open(cacheFilename))
+        return false;
+
+    if (m_file.getSize() < sizeof(MeshCacheHeader))
+        return false;
+
+    const MeshCacheHeader * header = (const MeshCacheHeader *) m_file.getData();
+    const uint64_t fileSize = m_file.getSize();
+
+    if (header->magic != CE_MESHCACHE_MAGIC || header->version != CE_MESHCACHE_VERSION ||
+        header->sourceHash != sourceHash || header->flags != flags || header->fileSize != fileSize ||
+        (header->vertexStride != CE_MESH_QUANTIZED_VERTEX_BYTES && header->vertexStride != CE_MESH_VERTEX_SIZE * sizeof(GLfloat)))
+        return false;
+
+    if (header->indexType != GL_UNSIGNED_SHORT && header->indexType != GL_UNSIGNED_INT)
+        return false;
+
+    // Make sure that every section lies inside of the file before
+    // anything is read from it.
+    uint64_t indexSize  = header->indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+    uint64_t vertexEnd  = header->vertexOffset + (uint64_t) header->vertexCount * header->vertexStride;
+    uint64_t indexEnd   = header->indexOffset + (uint64_t) header->indexCount * indexSize;
+
+    if (vertexEnd > fileSize || indexEnd > fileSize ||
+        header->vertexOffset > vertexEnd || header->indexOffset > indexEnd)
+        return false;
+
+    // Every record count must fit into the bytes of its section,
+    // so that nothing is sized from a count that was never written.
+    if (!countFits(header->rangeCount, sizeof(MeshCacheRange), header->rangeOffset, header->lodOffset) ||
+        !countFits(header->lodCount, CE_MESHCACHE_MIN_LOD_BYTES, header->lodOffset, header->meshletOffset) ||
+        !countFits(header->meshletCount, sizeof(MeshCacheMeshlet), header->meshletOffset, header->materialOffset) ||
+        !countFits(header->materialCount, CE_MESHCACHE_MIN_MATERIAL_BYTES, header->materialOffset, fileSize))
+        return false;
+
+    m_header = header;
+
+    if (!validate())
+    {
+        LOG("Rebuilding the corrupt mesh cache: " + cacheFilename);
+        m_header = nullptr;
+        return false;
+    }
+
+    // The materials are part of the cooked mesh, so an edited
+    // library invalidates it just like an edited OBJ file does.
+    std::string materialLibrary;
+
+    if (!readMaterials(&materialLibrary, nullptr) ||
+        hashMaterialLibrary(filename, materialLibrary) != header->materialHash)
+    {
+        m_header = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////
+bool MeshCache::write(const std::string & filename, const uint64_t sourceHash, const unsigned int flags, const std::string & materialLibrary, const MeshData & mesh)
+{
+    std::vector<unsigned char> indexData;
+    MeshBuilder::getIndexData(mesh, indexData);
+
+    std::vector<MeshCacheRange> ranges(mesh.ranges.size());
+
+    for (size_t count = 0; count < ranges.size(); ++count)
+    {
+        ranges[count].firstIndex = mesh.ranges[count].firstIndex;
+        ranges[count].indexCount = mesh.ranges[count].indexCount;
+        ranges[count].material   = mesh.ranges[count].material;
+    }
+
+    std::vector<unsigned char> lodData;
+
+    for (const MeshLodData & lod : mesh.lods)
+    {
+        uint32_t rangeCount = (uint32_t) lod.ranges.size();
+
+        writeFloats(lodData, &lod.error, 1);
+        lodData.insert(lodData.end(), (const unsigned char *) &rangeCount, (const unsigned char *) &rangeCount + sizeof(rangeCount));
+
+        for (const MeshRange & range : lod.ranges)
+        {
+            MeshCacheRange lodRange = { range.firstIndex, range.indexCount, range.material };
+            lodData.insert(lodData.end(), (const unsigned char *) &lodRange, (const unsigned char *)(&lodRange + 1));
+        }
+    }
+
+    std::vector<MeshCacheMeshlet> meshlets(mesh.meshlets.size());
+
+    for (size_t count = 0; count < meshlets.size(); ++count)
+    {
+        const Meshlet & meshlet = mesh.meshlets[count];
+
+        meshlets[count].firstIndex = meshlet.firstIndex;
+        meshlets[count].indexCount = meshlet.indexCount;
+        meshlets[count].radius     = meshlet.radius;
+        meshlets[count].coneCutoff = meshlet.coneCutoff;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            meshlets[count].center[axis]   = meshlet.center[axis];
+            meshlets[count].coneAxis[axis] = meshlet.coneAxis[axis];
+        }
+    }
+
+    std::vector<unsigned char> materialData;
+    writeString(materialData, materialLibrary);
+
+    for (const ObjMaterial & material : mesh.materials)
+    {
+        writeString(materialData, material.name);
+        writeFloats(materialData, &material.diffuse[0], 3);
+        writeFloats(materialData, &material.specular[0], 3);
+        writeFloats(materialData, &material.shininess, 1);
+        writeString(materialData, material.diffuseMap);
+    }
+
+    MeshCacheHeader header;
+    memset(&header, 0, sizeof(header));
+
+    header.magic         = CE_MESHCACHE_MAGIC;
+    header.version       = CE_MESHCACHE_VERSION;
+    header.sourceHash    = sourceHash;
+    header.flags         = flags;
+    header.materialHash  = hashMaterialLibrary(filename, materialLibrary);
+    header.vertexCount   = (uint32_t) mesh.getVertexCount();
+    header.vertexStride  = mesh.format.getStride();
+    header.indexCount    = (uint32_t) mesh.indices.size();
+    header.indexType     = mesh.getIndexType();
+    header.rangeCount    = (uint32_t) ranges.size();
+    header.materialCount = (uint32_t) mesh.materials.size();
+    header.lodCount      = (uint32_t) mesh.lods.size();
+    header.meshletCount  = (uint32_t) meshlets.size();
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        header.boundsMin[axis] = mesh.boundsMin[axis];
+        header.boundsMax[axis] = mesh.boundsMax[axis];
+        header.positionScale[axis]  = mesh.format.positionScale[axis];
+        header.positionOffset[axis] = mesh.format.positionOffset[axis];
+    }
+
+    for (int axis = 0; axis < 2; ++axis)
+    {
+        header.texCoordScale[axis]  = mesh.format.texCoordScale[axis];
+        header.texCoordOffset[axis] = mesh.format.texCoordOffset[axis];
+    }
+
+    header.vertexOffset   = alignOffset(sizeof(header));
+    header.indexOffset    = alignOffset(header.vertexOffset + mesh.getVertexDataSize());
+    header.rangeOffset    = alignOffset(header.indexOffset + indexData.size());
+    header.lodOffset      = alignOffset(header.rangeOffset + ranges.size() * sizeof(MeshCacheRange));
+    header.meshletOffset  = alignOffset(header.lodOffset + lodData.size());
+    header.materialOffset = alignOffset(header.meshletOffset + meshlets.size() * sizeof(MeshCacheMeshlet));
+    header.fileSize       = header.materialOffset + materialData.size();
+
+    struct Section
+    {
+        uint64_t     offset;
+        const void * data;
+        size_t       size;
+    };
+
+    const Section sections[] = {
+        { 0,                     &header,                                          sizeof(header) },
+        { header.vertexOffset,   mesh.getVertexData(),                              mesh.getVertexDataSize() },
+        { header.indexOffset,    indexData.empty() ? nullptr : &indexData[0],       indexData.size() },
+        { header.rangeOffset,    ranges.empty() ? nullptr : &ranges[0],             ranges.size() * sizeof(MeshCacheRange) },
+        { header.lodOffset,      lodData.empty() ? nullptr : &lodData[0],           lodData.size() },
+        { header.meshletOffset,  meshlets.empty() ? nullptr : &meshlets[0],         meshlets.size() * sizeof(MeshCacheMeshlet) },
+        { header.materialOffset, &materialData[0],                                  materialData.size() }
+    };
+
+    // Write to a temporary file first, so that a crash (or a
+    // second instance reading the cache) never sees half a file.
+    // Meshes load on several threads, which get a file each.
+    std::string cacheFilename = getCacheFilename(filename);
+    std::string tempFilename  = cacheFilename + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+    FILE * file = fopen(tempFilename.c_str(), "wb");
+
+    if (file == nullptr)
+    {
+        LOG("Could not write the mesh cache: " + cacheFilename);
+        return false;
+    }
+
+    static const unsigned char padding[CE_MESHCACHE_ALIGNMENT] = { 0 };
+    uint64_t position = 0;
+    bool written = true;
+
+    for (const Section & section : sections)
+    {
+        if (section.offset > position)
+            written = written && fwrite(padding, 1, (size_t)(section.offset - position), file) == section.offset - position;
+
+        if (section.size > 0)
+            written = written && fwrite(section.data, 1, section.size, file) == section.size;
+
+        position = section.offset + section.size;
+    }
+
+    written = (fclose(file) == 0) && written;
+
+#ifdef _WIN32
+    // rename() won't replace an existing file on Windows.
+    if (written)
+        remove(cacheFilename.c_str());
+#endif
+
+    if (!written || rename(tempFilename.c_str(), cacheFilename.c_str()) != 0)
+    {
+        LOG("Could not write the mesh cache: " + cacheFilename);
+        remove(tempFilename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////
+bool MeshCache::validate() const
+{
+    //////////////////////////////////////////
+    // Ranges, levels of detail and meshlets
+    // are drawn and walked without checking
+    // them again, and so are the indices, so
+    // a corrupt file has to be caught here.
+    //////////////////////////////////////////
+    std::vector<MeshRange> ranges;
+    std::vector<MeshLodData> lods;
+    std::vector<Meshlet> meshlets;
+
+    getRanges(ranges);
+    getMeshlets(meshlets);
+
+    if (!rangesFit(ranges, m_header->indexCount) || !getLods(lods))
+        return false;
+
+    for (const MeshLodData & lod : lods)
+    {
+        if (!rangesFit(lod.ranges, m_header->indexCount))
+            return false;
+    }
+
+    for (const Meshlet & meshlet : meshlets)
+    {
+        if ((uint64_t) meshlet.firstIndex + meshlet.indexCount > m_header->indexCount)
+            return false;
+    }
+
+    const char * indices = m_file.getData() + m_header->indexOffset;
+
+    if (m_header->indexType == GL_UNSIGNED_SHORT)
+        return indicesFit<GLushort>(indices, m_header->indexCount, m_header->vertexCount);
+
+    return indicesFit<GLuint>(indices, m_header->indexCount, m_header->vertexCount);
+}
+
+//////////////////////////////////////////////////////////////
+bool MeshCache::readMaterials(std::string * materialLibrary, std::vector<ObjMaterial> * materials) const
+{
+    const char * p   = m_file.getData() + m_header->materialOffset;
+    const char * end = m_file.getData() + m_file.getSize();
+
+    std::string library;
+
+    if (!readString(p, end, library))
+        return false;
+
+    if (materialLibrary != nullptr)
+        *materialLibrary = library;
+
+    if (materials == nullptr)
+        return true;
+
+    if (!countFits(m_header->materialCount, CE_MESHCACHE_MIN_MATERIAL_BYTES, m_header->materialOffset, m_file.getSize()))
+        return false;
+
+    materials->resize(m_header->materialCount);
+
+    for (ObjMaterial & material : *materials)
+    {
+        if (!readString(p, end, material.name) ||
+            !readFloats(p, end, &material.diffuse[0], 3) ||
+            !readFloats(p, end, &material.specular[0], 3) ||
+            !readFloats(p, end, &material.shininess, 1) ||
+            !readString(p, end, material.diffuseMap))
+        {
+            materials->clear();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////
+const GLvoid * MeshCache::getVertexData() const
+{
+    return m_file.getData() + m_header->vertexOffset;
+}
+
+//////////////////////////////////////////////////////////////
+size_t MeshCache::getVertexDataSize() const
+{
+    return (size_t) m_header->vertexCount * m_header->vertexStride;
+}
+
+//////////////////////////////////////////////////////////////
+MeshVertexFormat MeshCache::getVertexFormat() const
+{
+    MeshVertexFormat format;
+    format.quantized      = m_header->vertexStride == CE_MESH_QUANTIZED_VERTEX_BYTES;
+    format.positionScale  = glm::vec3(m_header->positionScale[0], m_header->positionScale[1], m_header->positionScale[2]);
+    format.positionOffset = glm::vec3(m_header->positionOffset[0], m_header->positionOffset[1], m_header->positionOffset[2]);
+    format.texCoordScale  = glm::vec2(m_header->texCoordScale[0], m_header->texCoordScale[1]);
+    format.texCoordOffset = glm::vec2(m_header->texCoordOffset[0], m_header->texCoordOffset[1]);
+
+    return format;
+}
+
+//////////////////////////////////////////////////////////////
+const GLvoid * MeshCache::getIndexData() const
+{
+    return m_file.getData() + m_header->indexOffset;
+}
+
+//////////////////////////////////////////////////////////////
+size_t MeshCache::getIndexDataSize() const
+{
+    return m_header->indexCount * (m_header->indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint));
+}
+
+//////////////////////////////////////////////////////////////
+size_t MeshCache::getIndexCount() const
+{
+    return m_header->indexCount;
+}
+
+//////////////////////////////////////////////////////////////
+GLenum MeshCache::getIndexType() const
+{
+    return m_header->indexType;
+}
+
+//////////////////////////////////////////////////////////////
+glm::vec3 MeshCache::getBoundsMin() const
+{
+    return glm::vec3(m_header->boundsMin[0], m_header->boundsMin[1], m_header->boundsMin[2]);
+}
+
+//////////////////////////////////////////////////////////////
+glm::vec3 MeshCache::getBoundsMax() const
+{
+    return glm::vec3(m_header->boundsMax[0], m_header->boundsMax[1], m_header->boundsMax[2]);
+}
+
+//////////////////////////////////////////////////////////////
+void MeshCache::getRanges(std::vector<MeshRange> & ranges) const
+{
+    const char * data = m_file.getData() + m_header->rangeOffset;
+    ranges.clear();
+
+    if (!countFits(m_header->rangeCount, sizeof(MeshCacheRange), m_header->rangeOffset, m_header->lodOffset))
+        return;
+
+    ranges.resize(m_header->rangeCount);
+
+    for (size_t count = 0; count < ranges.size(); ++count)
+    {
+        MeshCacheRange range;
+        memcpy(&range, data + count * sizeof(MeshCacheRange), sizeof(MeshCacheRange));
+
+        ranges[count].firstIndex = range.firstIndex;
+        ranges[count].indexCount = range.indexCount;
+        ranges[count].material   = range.material;
+    }
+}
+
+//////////////////////////////////////////////////////////////
+void MeshCache::getMeshlets(std::vector<Meshlet> & meshlets) const
+{
+    const char * data = m_file.getData() + m_header->meshletOffset;
+    meshlets.clear();
+
+    if (!countFits(m_header->meshletCount, sizeof(MeshCacheMeshlet), m_header->meshletOffset, m_header->materialOffset))
+        return;
+
+    meshlets.resize(m_header->meshletCount);
+
+    for (size_t count = 0; count < meshlets.size(); ++count)
+    {
+        MeshCacheMeshlet meshlet;
+        memcpy(&meshlet, data + count * sizeof(MeshCacheMeshlet), sizeof(MeshCacheMeshlet));
+
+        meshlets[count].firstIndex = meshlet.firstIndex;
+        meshlets[count].indexCount = meshlet.indexCount;
+        meshlets[count].center     = glm::vec3(meshlet.center[0], meshlet.center[1], meshlet.center[2]);
+        meshlets[count].radius     = meshlet.radius;
+        meshlets[count].coneAxis   = glm::vec3(meshlet.coneAxis[0], meshlet.coneAxis[1], meshlet.coneAxis[2]);
+        meshlets[count].coneCutoff = meshlet.coneCutoff;
+    }
+}
+
+//////////////////////////////////////////////////////////////
+void MeshCache::getMaterials(std::vector<ObjMaterial> & materials) const
+{
+    readMaterials(nullptr, &materials);
+}
+
+//////////////////////////////////////////////////////////////
+bool MeshCache::getLods(std::vector<MeshLodData> & lods) const
+{
+    const char * p   = m_file.getData() + m_header->lodOffset;
+    const char * end = m_file.getData() + m_header->meshletOffset;
+
+    lods.clear();
+
+    if (!countFits(m_header->lodCount, CE_MESHCACHE_MIN_LOD_BYTES, m_header->lodOffset, m_header->meshletOffset))
+        return false;
+
+    lods.resize(m_header->lodCount);
+
+    for (MeshLodData & lod : lods)
+    {
+        uint32_t rangeCount;
+
+        if (!readFloats(p, end, &lod.error, 1) || end - p < (ptrdiff_t) sizeof(rangeCount))
+        {
+            lods.clear();
+            return false;
+        }
+
+        memcpy(&rangeCount, p, sizeof(rangeCount));
+        p += sizeof(rangeCount);
+
+        if ((size_t)(end - p) / sizeof(MeshCacheRange) < rangeCount)
+        {
+            lods.clear();
+            return false;
+        }
+
+        lod.ranges.resize(rangeCount);
+
+        for (MeshRange & range : lod.ranges)
+        {
+            MeshCacheRange lodRange;
+            memcpy(&lodRange, p, sizeof(MeshCacheRange));
+            p += sizeof(MeshCacheRange);
+
+            range.firstIndex = lodRange.firstIndex;
+            range.indexCount = lodRange.indexCount;
+            range.material   = lodRange.material;
+        }
+    }
+
+    return true;
+}
+
+} // namespace ce
@@ -0,0 +1,317 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#include <atomic>
+#include <cstring>
+#include <fstream>
+
+#include "Mesh/MeshChunkFile.hpp"
+#include "Mesh/MeshLoader.hpp"
+#include "Mesh/ObjParser.hpp"
+#include "Hash.hpp"
+#include "Parallel.hpp"
+
+namespace ce
+{
+
+//////////////////////////////////////////////////////////////
+template <typename Index>
+static bool indicesFit(const char * data, const size_t indexCount, const uint64_t vertexCount)
+{
+    Index largest = 0;
+
+    for (size_t count = 0; count < indexCount; ++count)
+    {
+        Index index;
+        memcpy(&index, data + count * sizeof(Index), sizeof(Index));
+
+        largest = index > largest ? index : largest;
+    }
+
+    return indexCount == 0 || largest < vertexCount;
+}
+
+//////////////////////////////////////////////////////////////
+MeshChunkFile::MeshChunkFile()
+    : m_header(nullptr)
+{ }
+
+//////////////////////////////////////////////////////////////
+std::string MeshChunkFile::getChunkFilename(const std::string & filename)
+{
+    return filename + CE_MESHCHUNKS_EXTENSION;
+}
+
+//////////////////////////////////////////////////////////////
+bool MeshChunkFile::open(const std::string & filename)
+{
+    m_header = nullptr;
+    m_chunks.clear();
+    m_materials.clear();
+    m_imageFiles.clear();
+    m_imageHashes.clear();
+    m_materialImages.clear();
+
+    std::string chunkFilename = getChunkFilename(filename);
+
+    if (!std::ifstream(chunkFilename).good() || !m_file.open(chunkFilename))
+        return false;
+
+    const uint64_t fileSize = m_file.getSize();
+
+    if (fileSize < sizeof(MeshChunkFileHeader))
+        return false;
+
+    const MeshChunkFileHeader * header = (const MeshChunkFileHeader *) m_file.getData();
+
+    if (header->magic != CE_MESHCHUNKS_MAGIC || header->version != CE_MESHCHUNKS_VERSION || header->fileSize != fileSize ||
+        header->chunkOffset > fileSize || (fileSize - header->chunkOffset) / sizeof(MeshChunkInfo) < header->chunkCount ||
+        header->materialOffset > fileSize)
+    {
+        LOG("Invalid chunked mesh: " + chunkFilename);
+        return false;
+    }
+
+    // Without its OBJ file, the chunked mesh is the only copy left
+    // to use.
+    if (std::ifstream(filename).good())
+    {
+        MappedFile source(filename);
+
+        if (!source.isOpen() || hashBytes(source.getData(), source.getSize()) != header->sourceHash)
+        {
+            LOG("The mesh changed since it was converted, convert it again: " + filename);
+            return false;
+        }
+    }
+
+    //////////////////////////////////////////
+    // Check every chunk up front, so that the
+    // getters don't have to.
+    //////////////////////////////////////////
+    m_chunks.resize(header->chunkCount);
+
+    if (!m_chunks.empty())
+        memcpy(&m_chunks[0], m_file.getData() + header->chunkOffset, m_chunks.size() * sizeof(MeshChunkInfo));
+
+    for (const MeshChunkInfo & chunk : m_chunks)
+    {
+        uint64_t indexSize  = chunk.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+        uint64_t vertexEnd  = chunk.vertexOffset + (uint64_t) chunk.vertexCount * CE_MESH_VERTEX_SIZE * sizeof(GLfloat);
+        uint64_t indexEnd   = chunk.indexOffset + (uint64_t) chunk.indexCount * indexSize;
+        uint64_t rangeEnd   = chunk.rangeOffset + (uint64_t) chunk.rangeCount * sizeof(MeshChunkRange);
+
+        if ((chunk.indexType != GL_UNSIGNED_SHORT && chunk.indexType != GL_UNSIGNED_INT) ||
+            vertexEnd > fileSize || indexEnd > fileSize || rangeEnd > fileSize ||
+            chunk.vertexOffset > vertexEnd || chunk.indexOffset > indexEnd || chunk.rangeOffset > rangeEnd)
+        {
+            LOG("Invalid chunked mesh: " + chunkFilename);
+            m_chunks.clear();
+            return false;
+        }
+    }
+
+    if (!validate())
+    {
+        LOG("Invalid chunked mesh: " + chunkFilename);
+        m_chunks.clear();
+        return false;
+    }
+
+    //////////////////////////////////////////
+    // Read the materials the ranges refer to.
+    //////////////////////////////////////////
+    const char * p   = m_file.getData() + header->materialOffset;
+    const char * end = m_file.getData() + fileSize;
+    uint32_t length = 0;
+    bool valid = end - p >= (ptrdiff_t) sizeof(length);
+
+    if (valid)
+    {
+        memcpy(&length, p, sizeof(length));
+        p += sizeof(length);
+        valid = (size_t)(end - p) >= length;
+    }
+
+    if (!valid)
+    {
+        LOG("Invalid chunked mesh: " + chunkFilename);
+        m_chunks.clear();
+        return false;
+    }
+
+    std::string materialLibrary(p, length);
+
+    if (materialLibrary != "")
+    {
+        std::size_t endOfPath = filename.find_last_of("/") + 1;
+        ObjParser().parseMaterialFile(filename.substr(0, endOfPath) + materialLibrary, m_materials);
+    }
+
+    MeshLoader::findImages(filename, m_materials, m_imageFiles, m_materialImages);
+    m_imageHashes.resize(m_imageFiles.size());
+
+    for (size_t image = 0; image < m_imageFiles.size(); ++image)
+        m_imageHashes[image] = MeshLoader::hashImageFile(m_imageFiles[image]);
+
+    m_filename = filename;
+    m_header = header;
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////
+bool MeshChunkFile::validate() const
+{
+    std::atomic<bool> valid(true);
+
+    // Every index of the file is read, on all cores.
+    parallelFor(m_chunks.size(), [&](const size_t chunk)
+    {
+        if (!valid)
+            return;
+
+        const MeshChunkInfo & info = m_chunks[chunk];
+        std::vector<MeshRange> ranges;
+
+        getRanges(chunk, ranges);
+
+        for (const MeshRange & range : ranges)
+        {
+            if ((uint64_t) range.firstIndex + range.indexCount > info.indexCount)
+            {
+                valid = false;
+                return;
+            }
+        }
+
+        const char * indices = m_file.getData() + info.indexOffset;
+
+        if (info.indexType == GL_UNSIGNED_SHORT ? !indicesFit<GLushort>(indices, info.indexCount, info.vertexCount)
+                                                : !indicesFit<GLuint>(indices, info.indexCount, info.vertexCount))
+            valid = false;
+    });
+
+    return valid;
+}
+
+//////////////////////////////////////////////////////////////
+size_t MeshChunkFile::getChunkCount() const
+{
+    return m_chunks.size();
+}
+
+//////////////////////////////////////////////////////////////
+const MeshChunkInfo & MeshChunkFile::getChunk(const size_t & chunk) const
+{
+    return m_chunks[chunk];
+}
+
+//////////////////////////////////////////////////////////////
+const GLvoid * MeshChunkFile::getVertexData(const size_t & chunk) const
+{
+    return m_file.getData() + m_chunks[chunk].vertexOffset;
+}
+
+//////////////////////////////////////////////////////////////
+size_t MeshChunkFile::getVertexDataSize(const size_t & chunk) const
+{
+    return (size_t) m_chunks[chunk].vertexCount * CE_MESH_VERTEX_SIZE * sizeof(GLfloat);
+}
+
+//////////////////////////////////////////////////////////////
+const GLvoid * MeshChunkFile::getIndexData(const size_t & chunk) const
+{
+    return m_file.getData() + m_chunks[chunk].indexOffset;
+}
+
+//////////////////////////////////////////////////////////////
+size_t MeshChunkFile::getIndexDataSize(const size_t & chunk) const
+{
+    return (size_t) m_chunks[chunk].indexCount * (m_chunks[chunk].indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint));
+}
+
+//////////////////////////////////////////////////////////////
+void MeshChunkFile::getRanges(const size_t & chunk, std::vector<MeshRange> & ranges) const
+{
+    const char * data = m_file.getData() + m_chunks[chunk].rangeOffset;
+    ranges.resize(m_chunks[chunk].rangeCount);
+
+    for (size_t count = 0; count < ranges.size(); ++count)
+    {
+        MeshChunkRange range;
+        memcpy(&range, data + count * sizeof(MeshChunkRange), sizeof(MeshChunkRange));
+
+        ranges[count].firstIndex = range.firstIndex;
+        ranges[count].indexCount = range.indexCount;
+        ranges[count].material   = range.material;
+    }
+}
+
+//////////////////////////////////////////////////////////////
+glm::vec3 MeshChunkFile::getBoundsMin() const
+{
+    return glm::vec3(m_header->boundsMin[0], m_header->boundsMin[1], m_header->boundsMin[2]);
+}
+
+//////////////////////////////////////////////////////////////
+glm::vec3 MeshChunkFile::getBoundsMax() const
+{
+    return glm::vec3(m_header->boundsMax[0], m_header->boundsMax[1], m_header->boundsMax[2]);
+}
+
+//////////////////////////////////////////////////////////////
+const std::vector<ObjMaterial> & MeshChunkFile::getMaterials() const
+{
+    return m_materials;
+}
+
+//////////////////////////////////////////////////////////////
+const std::vector<std::string> & MeshChunkFile::getImageFiles() const
+{
+    return m_imageFiles;
+}
+
+//////////////////////////////////////////////////////////////
+const std::vector<uint64_t> & MeshChunkFile::getImageHashes() const
+{
+    return m_imageHashes;
+}
+
+//////////////////////////////////////////////////////////////
+const std::vector<int> & MeshChunkFile::getMaterialImages() const
+{
+    return m_materialImages;
+}
+
+//////////////////////////////////////////////////////////////
+const std::string & MeshChunkFile::getFilename() const
+{
+    return m_filename;
+}
+
+} // namespace ce
@@ -0,0 +1,188 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Mesh/MeshImpostor.hpp"
+
+namespace ce
+{
+
+//////////////////////////////////////////////////////////////
+static float signNotZero(const float & value)
+{
+    return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+//////////////////////////////////////////////////////////////
+glm::vec3 MeshImpostor::getViewDirection(const int & x, const int & y) const
+{
+    // The center of the cell, from -1 to 1 across the atlas.
+    glm::vec2 cell((x + 0.5f) / settings.views * 2.0f - 1.0f, (y + 0.5f) / settings.views * 2.0f - 1.0f);
+    glm::vec3 direction;
+
+    if (settings.hemisphere)
+    {
+        // The upper half of the octahedron, turned by 45 degrees
+        // to fill the whole square.
+        direction.x = (cell.x + cell.y) * 0.5f;
+        direction.z = (cell.x - cell.y) * 0.5f;
+        direction.y = 1.0f - std::fabs(direction.x) - std::fabs(direction.z);
+    }
+    else
+    {
+        direction.x = cell.x;
+        direction.z = cell.y;
+        direction.y = 1.0f - std::fabs(cell.x) - std::fabs(cell.y);
+
+        // Unfold the lower half of the octahedron.
+        if (direction.y < 0.0f)
+        {
+            direction.x = (1.0f - std::fabs(cell.y)) * signNotZero(cell.x);
+            direction.z = (1.0f - std::fabs(cell.x)) * signNotZero(cell.y);
+        }
+    }
+
+    return glm::normalize(direction);
+}
+
+//////////////////////////////////////////////////////////////
+void MeshImpostor::getView(const glm::vec3 & direction, int & x, int & y) const
+{
+    glm::vec3 view = direction;
+
+    // Views from below show the mesh from the side.
+    if (settings.hemisphere)
+        view.y = std::max(view.y, 0.0f);
+
+    float length = std::fabs(view.x) + std::fabs(view.y) + std::fabs(view.z);
+    glm::vec2 cell = length > 0.0f ? glm::vec2(view.x, view.z) / length : glm::vec2(0.0f);
+
+    if (settings.hemisphere)
+        cell = glm::vec2(cell.x + cell.y, cell.x - cell.y);
+    else if (view.y < 0.0f)
+        cell = glm::vec2((1.0f - std::fabs(cell.y)) * signNotZero(cell.x), (1.0f - std::fabs(cell.x)) * signNotZero(cell.y));
+
+    x = std::min(std::max((int)((cell.x * 0.5f + 0.5f) * settings.views), 0), settings.views - 1);
+    y = std::min(std::max((int)((cell.y * 0.5f + 0.5f) * settings.views), 0), settings.views - 1);
+}
+
+//////////////////////////////////////////////////////////////
+void MeshImpostor::getViewAxes(const glm::vec3 & direction, glm::vec3 & right, glm::vec3 & up) const
+{
+    // Up stays up, except when looking straight down (or up).
+    glm::vec3 worldUp = std::fabs(direction.y) > 0.999f ? glm::vec3(0.0f, 0.0f, -1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+    right = glm::normalize(glm::cross(-direction, worldUp));
+    up    = glm::cross(right, -direction);
+}
+
+//////////////////////////////////////////////////////////////
+glm::mat4 MeshImpostor::getViewMatrix(const glm::vec3 & direction) const
+{
+    glm::vec3 right, up;
+    getViewAxes(direction, right, up);
+
+    return glm::lookAt(center + direction * radius * 2.0f, center, up);
+}
+
+//////////////////////////////////////////////////////////////
+glm::mat4 MeshImpostor::getProjectionMatrix() const
+{
+    return glm::ortho(-radius, radius, -radius, radius, radius, radius * 3.0f);
+}
+
+//////////////////////////////////////////////////////////////
+float MeshImpostor::getScreenSize(const glm::mat4 & modelView, const glm::mat4 & projection, const float & viewportHeight) const
+{
+    float scale = glm::max(glm::length(glm::vec3(modelView[0])),
+                  glm::max(glm::length(glm::vec3(modelView[1])), glm::length(glm::vec3(modelView[2]))));
+
+    float pixelsPerUnit = projection[1][1] * viewportHeight * 0.5f;
+
+    if (projection[3][3] == 0.0f)
+    {
+        glm::vec4 viewCenter = modelView * glm::vec4(center, 1.0f);
+        float distance = -viewCenter.z;
+
+        // Too close for a quad to stand in for the mesh.
+        if (distance <= radius * scale)
+            return FLT_MAX;
+
+        pixelsPerUnit /= distance;
+    }
+
+    return radius * 2.0f * scale * pixelsPerUnit;
+}
+
+//////////////////////////////////////////////////////////////
+void ImpostorBatch::addInstance(const MeshImpostor & impostor, const glm::mat4 & model, const glm::vec3 & cameraPosition)
+{
+    const glm::vec3 axes[3] = { glm::vec3(model[0]), glm::vec3(model[1]), glm::vec3(model[2]) };
+    const glm::vec3 worldCenter = glm::vec3(model * glm::vec4(impostor.center, 1.0f));
+
+    //////////////////////////////////////////
+    // Bring the direction of the camera into
+    // object space to pick the view. Uniform
+    // scale drops out when normalizing.
+    //////////////////////////////////////////
+    glm::vec3 toCamera = cameraPosition - worldCenter;
+    glm::vec3 direction(glm::dot(axes[0], toCamera), glm::dot(axes[1], toCamera), glm::dot(axes[2], toCamera));
+
+    direction = glm::length(direction) > 0.0f ? glm::normalize(direction) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+    int x, y;
+    impostor.getView(direction, x, y);
+
+    glm::vec3 right, up;
+    impostor.getViewAxes(impostor.getViewDirection(x, y), right, up);
+
+    glm::vec3 worldRight = (axes[0] * right.x + axes[1] * right.y + axes[2] * right.z) * impostor.radius;
+    glm::vec3 worldUp    = (axes[0] * up.x + axes[1] * up.y + axes[2] * up.z) * impostor.radius;
+
+    const float cellSize = 1.0f / impostor.settings.views;
+    const glm::vec2 cell(x * cellSize, y * cellSize);
+
+    // Two triangles, counter clockwise as seen from the view.
+    static const float corners[6][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 1, 1 }, { 0, 1 } };
+
+    for (int corner = 0; corner < 6; ++corner)
+    {
+        glm::vec3 position = worldCenter + worldRight * (corners[corner][0] * 2.0f - 1.0f) + worldUp * (corners[corner][1] * 2.0f - 1.0f);
+
+        m_vertices.push_back(position.x);
+        m_vertices.push_back(position.y);
+        m_vertices.push_back(position.z);
+        m_vertices.push_back(cell.x + corners[corner][0] * cellSize);
+        m_vertices.push_back(cell.y + corners[corner][1] * cellSize);
+    }
+}
+
+} // namespace ce
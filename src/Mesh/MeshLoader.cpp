@@ -0,0 +1,559 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#include <cstring>
+#include <algorithm>
+
+#include "Mesh/MeshLoader.hpp"
+#include "Mesh/ObjParser.hpp"
+#include "Mesh/MeshBuilder.hpp"
+#include "Mesh/MeshOptimizer.hpp"
+#include "Mesh/MeshSimplifier.hpp"
+#include "Mesh/MeshQuantizer.hpp"
+#include "Mesh/MeshletBuilder.hpp"
+#include "Mesh/MeshBvh.hpp"
+#include "Mesh/TextureConverter.hpp"
+#include "Hash.hpp"
+#include "Parallel.hpp"
+
+namespace ce
+{
+
+//////////////////////////////////////////////////////////////
+static LinearArena & getImageScratch()
+{
+    // An arena isn't thread safe, so every thread that decodes
+    // images has one of its own. The loader workers and the pool
+    // threads of parallelFor live on, so their arenas are reused
+    // by every image they decode, for as many loads as they do.
+    static thread_local LinearArena scratch;
+    return scratch;
+}
+
+//////////////////////////////////////////////////////////////
+static std::string getImageFilename(const std::string & filename)
+{
+    // A QOI copy made by TextureConverter decodes faster, as long
+    // as the PNG hasn't changed since.
+    return TextureConverter::hasCurrentQoi(filename) ? TextureConverter::getQoiFilename(filename) : filename;
+}
+
+//////////////////////////////////////////////////////////////
+static void loadImageFile(const std::string & filename, Image & image, uint64_t & hash, LinearArena * scratch)
+{
+    std::string imageFilename = getImageFilename(filename);
+
+    LOG("Reading image: " + imageFilename);
+    MappedFile file(imageFilename);
+
+    hash = file.isOpen() ? hashBytes(file.getData(), file.getSize()) : 0;
+    image.loadFromMemory((const unsigned char *) file.getData(), file.getSize(), scratch);
+}
+
+//////////////////////////////////////////////////////////////
+MeshLoader::MeshLoader()
+    : m_stopping(false)
+{ }
+
+//////////////////////////////////////////////////////////////
+MeshLoader::~MeshLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_condition.notify_all();
+
+    // Workers finish the mesh they are loading, the ones still
+    // waiting are dropped.
+    for (std::thread & thread : m_threads)
+        thread.join();
+}
+
+//////////////////////////////////////////////////////////////
+std::shared_ptr<MeshLoadRequest> MeshLoader::request(const std::string & filename, const unsigned int flags)
+{
+    std::shared_ptr<MeshLoadRequest> request = std::make_shared<MeshLoadRequest>();
+    request->filename = filename;
+    request->flags    = flags;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_requests.push_back(request);
+
+        if (m_threads.empty())
+        {
+            // Leave a core to the thread that renders.
+            unsigned int threadCount = std::min<unsigned int>(std::max<unsigned int>(getThreadCount() - 1, 1), CE_MESHLOADER_MAX_THREADS);
+
+            for (unsigned int thread = 0; thread < threadCount; ++thread)
+                m_threads.emplace_back(&MeshLoader::run, this);
+        }
+    }
+
+    m_condition.notify_one();
+
+    return request;
+}
+
+//////////////////////////////////////////////////////////////
+bool MeshLoader::popLoaded(std::shared_ptr<MeshLoadRequest> & request)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_loaded.empty())
+        return false;
+
+    request = m_loaded.front();
+    m_loaded.pop_front();
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////
+void MeshLoader::run()
+{
+    // Every worker keeps its own scratch memory for the whole of
+    // its life, so loads stop allocating their temporaries once
+    // the arena has grown to fit the largest one.
+    LinearArena scratch;
+
+    for (;;)
+    {
+        std::shared_ptr<MeshLoadRequest> request;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stopping || !m_requests.empty(); });
+
+            if (m_stopping)
+                return;
+
+            request = m_requests.front();
+            m_requests.pop_front();
+        }
+
+        // Nobody is waiting on meshes whose handles are all gone.
+        if (request.use_count() == 1)
+            continue;
+
+        request->loaded = load(request->filename, request->flags, request->data, &scratch);
+        scratch.reset();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_loaded.push_back(request);
+    }
+}
+
+//////////////////////////////////////////////////////////////
+bool MeshLoader::load(const std::string & filename, const unsigned int flags, MeshLoadData & data, LinearArena * scratch)
+{
+    if (filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".glb") == 0)
+    {
+        if (!loadGltf(filename, data))
+            return false;
+
+        // glTF primitives are drawn straight from the file, so only
+        // the flags that don't change their data are applied.
+        static const struct { unsigned int flag; const char * name; } unsupported[] = {
+            { MESH_LOAD_OPTIMIZE,  "MESH_LOAD_OPTIMIZE" },
+            { MESH_LOAD_LODS,      "MESH_LOAD_LODS" },
+            { MESH_LOAD_QUANTIZE,  "MESH_LOAD_QUANTIZE" },
+            { MESH_LOAD_MESHLETS,  "MESH_LOAD_MESHLETS" },
+            { MESH_LOAD_POSITIONS, "MESH_LOAD_POSITIONS" }
+        };
+
+        for (const auto & option : unsupported)
+        {
+            if (flags & option.flag)
+                LOG(std::string(option.name) + " isn't supported for glTF meshes: " + filename);
+        }
+
+        if (flags & MESH_LOAD_BVH)
+            buildBvh(data, scratch);
+
+        return true;
+    }
+
+    MappedFile source(filename);
+
+    if (!source.isOpen())
+        return false;
+
+    uint64_t sourceHash = hashBytes(source.getData(), source.getSize());
+    Mesh & result = data.mesh;
+
+    // The position stream and the BVH are made from the vertices
+    // after loading, so they don't change the cooked mesh.
+    unsigned int cookedFlags = flags & ~(MESH_LOAD_POSITIONS | MESH_LOAD_BVH);
+
+    data.cache.reset(new MeshCache());
+
+    if (data.cache->open(filename, sourceHash, cookedFlags))
+    {
+        //////////////////////////////////////////
+        // Upload the cooked mesh straight from
+        // the mapped sidecar file.
+        //////////////////////////////////////////
+        const MeshCache & cache = *data.cache;
+
+        LOG("Reading cooked mesh: " + MeshCache::getCacheFilename(filename));
+
+        cache.getRanges(data.ranges);
+        cache.getLods(data.lods);
+        cache.getMeshlets(result.meshlets);
+        cache.getMaterials(result.materials);
+
+        result.indexCount = cache.getIndexCount();
+        result.indexType  = cache.getIndexType();
+        result.format     = cache.getVertexFormat();
+        result.boundsMin  = cache.getBoundsMin();
+        result.boundsMax  = cache.getBoundsMax();
+
+        data.vertexData     = cache.getVertexData();
+        data.vertexDataSize = cache.getVertexDataSize();
+        data.indexData      = cache.getIndexData();
+        data.indexDataSize  = cache.getIndexDataSize();
+    }
+    else
+    {
+        ObjParser parser;
+        ObjData obj(scratch);
+        MeshData & mesh = data.built;
+
+        data.cache.reset();
+
+        LOG("Reading mesh: " + filename);
+        parser.parse(source.getData(), source.getData() + source.getSize(), obj);
+
+        std::vector<ObjMaterial> materials;
+
+        if (obj.materialLibrary != "")
+        {
+            std::size_t endOfPath = filename.find_last_of("/") + 1;
+            parser.parseMaterialFile(filename.substr(0, endOfPath) + obj.materialLibrary, materials);
+        }
+
+        MeshBuilder builder;
+        builder.build(obj, materials, mesh, scratch);
+
+        if (flags & MESH_LOAD_LODS)
+            MeshSimplifier::buildLods(mesh);
+
+        if (flags & MESH_LOAD_OPTIMIZE)
+            MeshOptimizer::optimize(mesh);
+
+        if (flags & MESH_LOAD_MESHLETS)
+            MeshletBuilder::build(mesh);
+
+        if (flags & MESH_LOAD_QUANTIZE)
+            MeshQuantizer::quantize(mesh);
+
+        MeshCache::write(filename, sourceHash, cookedFlags, obj.materialLibrary, mesh);
+
+        data.ranges = mesh.ranges;
+        data.lods   = mesh.lods;
+        result.meshlets   = mesh.meshlets;
+        result.materials  = mesh.materials;
+        result.indexCount = mesh.indices.size();
+        result.indexType  = mesh.getIndexType();
+        result.format     = mesh.format;
+        result.boundsMin  = mesh.boundsMin;
+        result.boundsMax  = mesh.boundsMax;
+
+        if (!mesh.indices.empty())
+        {
+            MeshBuilder::getIndexData(mesh, data.builtIndices);
+
+            data.vertexData     = mesh.getVertexData();
+            data.vertexDataSize = mesh.getVertexDataSize();
+            data.indexData      = &data.builtIndices[0];
+            data.indexDataSize  = data.builtIndices.size();
+        }
+    }
+
+    if ((flags & MESH_LOAD_POSITIONS) && data.vertexData != nullptr)
+        extractPositions(data);
+
+    if ((flags & MESH_LOAD_BVH) && data.vertexData != nullptr)
+        buildBvh(data, scratch);
+
+    if (result.indexCount > 0)
+        loadImages(filename, result.materials, data.images, data.imageHashes, data.materialImages);
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////
+bool MeshLoader::loadGltf(const std::string & filename, MeshLoadData & data)
+{
+    GltfParser parser;
+    GltfData & gltf = data.gltfData;
+
+    data.gltf = true;
+    data.file.reset(new MappedFile(filename));
+
+    LOG("Reading mesh: " + filename);
+
+    if (!data.file->isOpen() || !parser.parse(data.file->getData(), data.file->getData() + data.file->getSize(), gltf) || gltf.primitives.empty())
+        return false;
+
+    //////////////////////////////////////////
+    // Decode the images that materials use,
+    // whether embedded or next to the file.
+    //////////////////////////////////////////
+    data.images.resize(gltf.images.size());
+    data.imageHashes.resize(gltf.images.size(), 0);
+    data.materialImages = gltf.materialImages;
+
+    std::vector<bool> decoded(gltf.images.size(), false);
+    std::vector<int> usedImages;
+
+    for (int image : gltf.materialImages)
+    {
+        if (image < 0 || decoded[image])
+            continue;
+
+        decoded[image] = true;
+        usedImages.push_back(image);
+    }
+
+    // Images are decoded on all cores, see loadImages().
+    parallelFor(usedImages.size(), [&](const size_t index)
+    {
+        const int image = usedImages[index];
+        LinearArena & imageScratch = getImageScratch();
+
+        if (gltf.images[image].bufferView >= 0)
+        {
+            const GltfBufferView & view = gltf.bufferViews[gltf.images[image].bufferView];
+            data.images[image].loadFromMemory(gltf.binary + view.byteOffset, view.byteLength, &imageScratch);
+            data.imageHashes[image] = hashBytes(gltf.binary + view.byteOffset, view.byteLength);
+        }
+        else if (gltf.images[image].uri != "")
+        {
+            std::size_t endOfPath = filename.find_last_of("/") + 1;
+            loadImageFile(filename.substr(0, endOfPath) + gltf.images[image].uri, data.images[image], data.imageHashes[image], &imageScratch);
+        }
+
+        imageScratch.reset();
+    });
+
+    data.mesh.materials = gltf.materials;
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////
+void MeshLoader::extractPositions(MeshLoadData & data)
+{
+    // Quantized positions keep the padding after them, so that
+    // every one of them stays four byte aligned.
+    size_t stride = data.mesh.format.getStride();
+    size_t positionSize = data.mesh.format.quantized ? 4 * sizeof(GLushort) : 3 * sizeof(GLfloat);
+    size_t vertexCount = data.vertexDataSize / stride;
+
+    const unsigned char * vertices = (const unsigned char *) data.vertexData;
+    data.positionData.resize(vertexCount * positionSize);
+
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+        memcpy(&data.positionData[vertex * positionSize], vertices + vertex * stride, positionSize);
+}
+
+//////////////////////////////////////////////////////////////
+static GLuint readIndex(const unsigned char * indices, const GLenum & indexType, const size_t & index)
+{
+    if (indexType == GL_UNSIGNED_BYTE)
+        return indices[index];
+
+    if (indexType == GL_UNSIGNED_SHORT)
+    {
+        GLushort value;
+        memcpy(&value, indices + index * sizeof(GLushort), sizeof(GLushort));
+        return value;
+    }
+
+    GLuint value;
+    memcpy(&value, indices + index * sizeof(GLuint), sizeof(GLuint));
+    return value;
+}
+
+//////////////////////////////////////////////////////////////
+void MeshLoader::buildBvh(MeshLoadData & data, LinearArena * scratch)
+{
+    ArenaVector<glm::vec3> corners(scratch);
+
+    if (data.gltf)
+    {
+        //////////////////////////////////////////
+        // Gather the triangles of every primitive.
+        // Those with positions that aren't floats
+        // are kept as degenerate triangles, which
+        // are never hit, to keep the numbering.
+        //////////////////////////////////////////
+        const GltfData & gltf = data.gltfData;
+        size_t cornerCount = 0;
+
+        for (const GltfPrimitive & primitive : gltf.primitives)
+            cornerCount += gltf.accessors[primitive.indices].count / 3 * 3;
+
+        corners.reserve(cornerCount);
+
+        for (const GltfPrimitive & primitive : gltf.primitives)
+        {
+            const GltfAccessor & positions = gltf.accessors[primitive.position];
+            const GltfAccessor & indices   = gltf.accessors[primitive.indices];
+
+            const unsigned char * positionData = gltf.binary + gltf.bufferViews[positions.bufferView].byteOffset + positions.byteOffset;
+            const unsigned char * indexData    = gltf.binary + gltf.bufferViews[indices.bufferView].byteOffset + indices.byteOffset;
+            size_t stride = GltfParser::getStride(gltf, positions);
+            bool readable = positions.componentType == GL_FLOAT && positions.componentCount == 3;
+
+            for (size_t corner = 0; corner < indices.count / 3 * 3; ++corner)
+            {
+                GLuint index = readIndex(indexData, indices.componentType, corner);
+                glm::vec3 position(0.0f);
+
+                if (readable && index < positions.count)
+                    memcpy(&position, positionData + index * stride, sizeof(glm::vec3));
+
+                corners.push_back(position);
+            }
+        }
+    }
+    else
+    {
+        //////////////////////////////////////////
+        // The full level of detail comes first in
+        // the element buffer, with the simplified
+        // ones after it.
+        //////////////////////////////////////////
+        const MeshVertexFormat & format = data.mesh.format;
+        const unsigned char * vertices = (const unsigned char *) data.vertexData;
+        const unsigned char * indices  = (const unsigned char *) data.indexData;
+        size_t stride = format.getStride();
+        size_t vertexCount = data.vertexDataSize / stride;
+        size_t cornerCount = 0;
+
+        for (const MeshRange & range : data.ranges)
+            cornerCount = std::max<size_t>(cornerCount, range.firstIndex + range.indexCount);
+
+        corners.resize(cornerCount / 3 * 3, glm::vec3(0.0f));
+
+        for (size_t corner = 0; corner < corners.size(); ++corner)
+        {
+            GLuint index = readIndex(indices, data.mesh.indexType, corner);
+
+            if (index >= vertexCount)
+                continue;
+
+            if (format.quantized)
+            {
+                GLushort position[3];
+                memcpy(position, vertices + index * stride, sizeof(position));
+
+                corners[corner] = glm::vec3(position[0], position[1], position[2]) / 65535.0f * format.positionScale + format.positionOffset;
+            }
+            else
+                memcpy(&corners[corner], vertices + index * stride, sizeof(glm::vec3));
+        }
+    }
+
+    if (corners.empty())
+        return;
+
+    std::shared_ptr<MeshBvh> bvh = std::make_shared<MeshBvh>();
+    bvh->build(&corners[0], corners.size() / 3, scratch);
+
+    data.mesh.bvh = bvh;
+}
+
+//////////////////////////////////////////////////////////////
+void MeshLoader::loadImages(const std::string & filename, const std::vector<ObjMaterial> & materials, std::vector<Image> & images, std::vector<uint64_t> & imageHashes, std::vector<int> & materialImages)
+{
+    std::vector<std::string> imageFiles;
+
+    findImages(filename, materials, imageFiles, materialImages);
+    loadImageFiles(imageFiles, images, imageHashes);
+}
+
+//////////////////////////////////////////////////////////////
+void MeshLoader::findImages(const std::string & filename, const std::vector<ObjMaterial> & materials, std::vector<std::string> & imageFiles, std::vector<int> & materialImages)
+{
+    std::size_t endOfPath = filename.find_last_of("/") + 1;
+    std::string pathToModel = filename.substr(0, endOfPath);
+
+    // Materials that share a diffuse map share its image.
+    imageFiles.clear();
+    materialImages.assign(materials.size(), -1);
+
+    for (size_t material = 0; material < materials.size(); ++material)
+    {
+        if (materials[material].diffuseMap == "")
+            continue;
+
+        std::string imageFile = pathToModel + materials[material].diffuseMap;
+        size_t imageIndex = std::find(imageFiles.begin(), imageFiles.end(), imageFile) - imageFiles.begin();
+
+        if (imageIndex == imageFiles.size())
+            imageFiles.push_back(imageFile);
+
+        materialImages[material] = (int) imageIndex;
+    }
+}
+
+//////////////////////////////////////////////////////////////
+void MeshLoader::loadImageFiles(const std::vector<std::string> & imageFiles, std::vector<Image> & images, std::vector<uint64_t> & imageHashes)
+{
+    //////////////////////////////////////////
+    // Decode the texture files on all
+    // cores. The images stay in the order of
+    // their files, for uploading.
+    //////////////////////////////////////////
+    images.clear();
+    images.resize(imageFiles.size());
+    imageHashes.assign(imageFiles.size(), 0);
+
+    parallelFor(imageFiles.size(), [&](const size_t index)
+    {
+        LinearArena & imageScratch = getImageScratch();
+
+        loadImageFile(imageFiles[index], images[index], imageHashes[index], &imageScratch);
+        imageScratch.reset();
+    });
+}
+
+//////////////////////////////////////////////////////////////
+uint64_t MeshLoader::hashImageFile(const std::string & filename)
+{
+    MappedFile file(getImageFilename(filename));
+
+    return file.isOpen() ? hashBytes(file.getData(), file.getSize()) : 0;
+}
+
+} // namespace ce
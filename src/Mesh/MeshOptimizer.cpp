@@ -0,0 +1,406 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <algorithm>
+
+#include "Mesh/MeshOptimizer.hpp"
+
+#define CE_MESHOPTIMIZER_UNUSED 0xFFFFFFFF
+
+namespace ce
+{
+
+//////////////////////////////////////////////////////////////
+// Scoring constants from Forsyth's article.
+//////////////////////////////////////////////////////////////
+static const float CacheDecayPower   = 1.5f;
+static const float LastTriangleScore = 0.75f;
+static const float ValenceBoostScale = 2.0f;
+static const float ValenceBoostPower = 0.5f;
+
+//////////////////////////////////////////////////////////////
+static float getVertexScore(const int cachePosition, const unsigned int remainingTriangles)
+{
+    // Vertices without triangles left don't matter any more.
+    if (remainingTriangles == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+
+    if (cachePosition >= 0)
+    {
+        // The vertices of the last triangle get a fixed score, so
+        // that the next triangle doesn't just reuse its edge.
+        if (cachePosition < 3)
+            score = LastTriangleScore;
+        else
+        {
+            const float scale = 1.0f / (CE_MESHOPTIMIZER_CACHE_SIZE - 3);
+            score = powf(1.0f - (cachePosition - 3) * scale, CacheDecayPower);
+        }
+    }
+
+    // Prefer vertices with few triangles left, so that they are
+    // finished off instead of leaving lone triangles behind.
+    return score + ValenceBoostScale * powf((float) remainingTriangles, -ValenceBoostPower);
+}
+
+//////////////////////////////////////////////////////////////
+static void getTrianglePositions(const GLuint * triangle, const std::vector<GLfloat> & vertices, glm::vec3 positions[3])
+{
+    for (int corner = 0; corner < 3; ++corner)
+    {
+        const GLfloat * vertex = &vertices[triangle[corner] * CE_MESH_VERTEX_SIZE];
+        positions[corner] = glm::vec3(vertex[0], vertex[1], vertex[2]);
+    }
+}
+
+//////////////////////////////////////////////////////////////
+void MeshOptimizer::optimize(MeshData & mesh)
+{
+    if (mesh.indices.empty())
+        return;
+
+    const size_t vertexCount = mesh.getVertexCount();
+    // The levels of detail come after the full detail triangles,
+    // which are the ones the ACMR is reported for.
+    size_t fullIndexCount = 0;
+
+    for (const MeshRange & range : mesh.ranges)
+        fullIndexCount = std::max(fullIndexCount, (size_t) range.firstIndex + range.indexCount);
+
+    float acmrBefore = getACMR(&mesh.indices[0], fullIndexCount, vertexCount);
+
+    std::vector<MeshRange> ranges = mesh.ranges;
+
+    for (const MeshLodData & lod : mesh.lods)
+        ranges.insert(ranges.end(), lod.ranges.begin(), lod.ranges.end());
+
+    for (const MeshRange & range : ranges)
+    {
+        optimizeVertexCache(&mesh.indices[range.firstIndex], range.indexCount, vertexCount);
+        optimizeOverdraw(&mesh.indices[range.firstIndex], range.indexCount, mesh.vertices);
+    }
+
+    optimizeVertexFetch(mesh);
+
+    float acmrAfter = getACMR(&mesh.indices[0], fullIndexCount, vertexCount);
+
+    LOG("Optimized mesh, ACMR " + std::to_string(acmrBefore) + " -> " + std::to_string(acmrAfter));
+}
+
+//////////////////////////////////////////////////////////////
+void MeshOptimizer::optimizeVertexCache(GLuint * indices, const size_t indexCount, const size_t vertexCount)
+{
+    const size_t triangleCount = indexCount / 3;
+
+    if (triangleCount == 0)
+        return;
+
+    //////////////////////////////////////////
+    // Build the list of triangles that use each
+    // vertex.
+    //////////////////////////////////////////
+    std::vector<unsigned int> remainingTriangles(vertexCount, 0);
+    std::vector<unsigned int> firstTriangle(vertexCount + 1, 0);
+
+    for (size_t count = 0; count < triangleCount * 3; ++count)
+        ++remainingTriangles[indices[count]];
+
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+        firstTriangle[vertex + 1] = firstTriangle[vertex] + remainingTriangles[vertex];
+
+    std::vector<unsigned int> vertexTriangles(triangleCount * 3);
+    std::vector<unsigned int> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+
+    for (size_t count = 0; count < triangleCount * 3; ++count)
+        vertexTriangles[fill[indices[count]]++] = (unsigned int)(count / 3);
+
+    //////////////////////////////////////////
+    // Score every vertex and triangle.
+    //////////////////////////////////////////
+    std::vector<int>   cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    std::vector<float> triangleScore(triangleCount, 0.0f);
+    std::vector<bool>  emitted(triangleCount, false);
+
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+        vertexScore[vertex] = getVertexScore(-1, remainingTriangles[vertex]);
+
+    for (size_t count = 0; count < triangleCount * 3; ++count)
+        triangleScore[count / 3] += vertexScore[indices[count]];
+
+    int bestTriangle = (int)(std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin());
+
+    std::vector<GLuint> output;
+    output.reserve(triangleCount * 3);
+
+    GLuint cache[CE_MESHOPTIMIZER_CACHE_SIZE + 3];
+    GLuint nextCache[CE_MESHOPTIMIZER_CACHE_SIZE + 3];
+    size_t cacheCount = 0;
+    size_t scanPosition = 0;
+
+    while (output.size() < triangleCount * 3)
+    {
+        // When nothing in the cache has triangles left, carry on
+        // with the next triangle that hasn't been drawn yet.
+        if (bestTriangle < 0)
+        {
+            while (emitted[scanPosition])
+                ++scanPosition;
+
+            bestTriangle = (int) scanPosition;
+        }
+
+        const GLuint * triangle = &indices[bestTriangle * 3];
+        emitted[bestTriangle] = true;
+        output.insert(output.end(), triangle, triangle + 3);
+
+        //////////////////////////////////////////
+        // Remove the triangle from its vertices and
+        // move them to the front of the cache.
+        //////////////////////////////////////////
+        size_t nextCount = 0;
+
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            GLuint vertex = triangle[corner];
+            unsigned int * triangles = &vertexTriangles[firstTriangle[vertex]];
+            unsigned int * last = triangles + remainingTriangles[vertex] - 1;
+
+            *std::find(triangles, last + 1, (unsigned int) bestTriangle) = *last;
+            --remainingTriangles[vertex];
+
+            if (std::find(nextCache, nextCache + nextCount, vertex) == nextCache + nextCount)
+                nextCache[nextCount++] = vertex;
+        }
+
+        for (size_t entry = 0; entry < cacheCount; ++entry)
+        {
+            if (cache[entry] != triangle[0] && cache[entry] != triangle[1] && cache[entry] != triangle[2])
+                nextCache[nextCount++] = cache[entry];
+        }
+
+        //////////////////////////////////////////
+        // Rescore the vertices that moved (or fell
+        // out of the cache) and their triangles,
+        // and pick the best one of those.
+        //////////////////////////////////////////
+        bestTriangle = -1;
+        float bestScore = -1.0f;
+
+        for (size_t entry = 0; entry < nextCount; ++entry)
+        {
+            GLuint vertex = nextCache[entry];
+            cachePosition[vertex] = entry < CE_MESHOPTIMIZER_CACHE_SIZE ? (int) entry : -1;
+
+            float score = getVertexScore(cachePosition[vertex], remainingTriangles[vertex]);
+            float delta = score - vertexScore[vertex];
+            vertexScore[vertex] = score;
+
+            for (unsigned int count = 0; count < remainingTriangles[vertex]; ++count)
+            {
+                unsigned int adjacent = vertexTriangles[firstTriangle[vertex] + count];
+                triangleScore[adjacent] += delta;
+
+                if (triangleScore[adjacent] > bestScore)
+                {
+                    bestScore = triangleScore[adjacent];
+                    bestTriangle = (int) adjacent;
+                }
+            }
+        }
+
+        cacheCount = std::min(nextCount, (size_t) CE_MESHOPTIMIZER_CACHE_SIZE);
+        std::copy(nextCache, nextCache + cacheCount, cache);
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+//////////////////////////////////////////////////////////////
+void MeshOptimizer::optimizeOverdraw(GLuint * indices, const size_t indexCount, const std::vector<GLfloat> & vertices)
+{
+    const size_t triangleCount = indexCount / 3;
+
+    if (triangleCount < 2)
+        return;
+
+    //////////////////////////////////////////
+    // Start a new cluster wherever a triangle
+    // misses the cache with all of its
+    // vertices. Reordering at those points
+    // costs (almost) no cache reuse.
+    //////////////////////////////////////////
+    std::vector<size_t> clusterStarts;
+    std::vector<size_t> cacheTime(vertices.size() / CE_MESH_VERTEX_SIZE, 0);
+    size_t time = CE_MESHOPTIMIZER_FIFO_SIZE + 1;
+
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+    {
+        int misses = 0;
+
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            GLuint vertex = indices[triangle * 3 + corner];
+
+            if (time - cacheTime[vertex] > CE_MESHOPTIMIZER_FIFO_SIZE)
+            {
+                cacheTime[vertex] = time++;
+                ++misses;
+            }
+        }
+
+        if (triangle == 0 || misses == 3)
+            clusterStarts.push_back(triangle);
+    }
+
+    clusterStarts.push_back(triangleCount);
+
+    const size_t clusterCount = clusterStarts.size() - 1;
+
+    if (clusterCount < 2)
+        return;
+
+    //////////////////////////////////////////
+    // Find the area weighted centroid and
+    // normal of every cluster.
+    //////////////////////////////////////////
+    std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3(0.0f));
+    std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3(0.0f));
+
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+
+    for (size_t cluster = 0; cluster < clusterCount; ++cluster)
+    {
+        float clusterArea = 0.0f;
+
+        for (size_t triangle = clusterStarts[cluster]; triangle < clusterStarts[cluster + 1]; ++triangle)
+        {
+            glm::vec3 positions[3];
+            getTrianglePositions(&indices[triangle * 3], vertices, positions);
+
+            glm::vec3 normal = glm::cross(positions[1] - positions[0], positions[2] - positions[0]);
+            float area = glm::length(normal);
+
+            clusterCentroids[cluster] += (positions[0] + positions[1] + positions[2]) * (area / 3.0f);
+            clusterNormals[cluster] += normal;
+            clusterArea += area;
+        }
+
+        meshCentroid += clusterCentroids[cluster];
+        meshArea += clusterArea;
+
+        if (clusterArea > 0.0f)
+            clusterCentroids[cluster] /= clusterArea;
+    }
+
+    if (meshArea > 0.0f)
+        meshCentroid /= meshArea;
+
+    //////////////////////////////////////////
+    // Draw the clusters that face away from the
+    // middle of the mesh (and so tend to occlude
+    // the others) first.
+    //////////////////////////////////////////
+    std::vector<float> sortKeys(clusterCount);
+    std::vector<size_t> clusterOrder(clusterCount);
+
+    for (size_t cluster = 0; cluster < clusterCount; ++cluster)
+    {
+        float length = glm::length(clusterNormals[cluster]);
+        glm::vec3 normal = length > 0.0f ? clusterNormals[cluster] / length : glm::vec3(0.0f);
+
+        sortKeys[cluster] = glm::dot(clusterCentroids[cluster] - meshCentroid, normal);
+        clusterOrder[cluster] = cluster;
+    }
+
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(),
+        [&sortKeys](const size_t left, const size_t right) { return sortKeys[left] > sortKeys[right]; });
+
+    std::vector<GLuint> output;
+    output.reserve(triangleCount * 3);
+
+    for (size_t cluster : clusterOrder)
+        output.insert(output.end(), indices + clusterStarts[cluster] * 3, indices + clusterStarts[cluster + 1] * 3);
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+//////////////////////////////////////////////////////////////
+void MeshOptimizer::optimizeVertexFetch(MeshData & mesh)
+{
+    const size_t vertexCount = mesh.getVertexCount();
+
+    std::vector<GLuint>  remap(vertexCount, CE_MESHOPTIMIZER_UNUSED);
+    std::vector<GLfloat> vertices;
+    vertices.reserve(mesh.vertices.size());
+
+    // Vertices that no triangle uses are dropped along the way.
+    for (GLuint & index : mesh.indices)
+    {
+        if (remap[index] == CE_MESHOPTIMIZER_UNUSED)
+        {
+            remap[index] = (GLuint)(vertices.size() / CE_MESH_VERTEX_SIZE);
+
+            const GLfloat * vertex = &mesh.vertices[index * CE_MESH_VERTEX_SIZE];
+            vertices.insert(vertices.end(), vertex, vertex + CE_MESH_VERTEX_SIZE);
+        }
+
+        index = remap[index];
+    }
+
+    mesh.vertices.swap(vertices);
+}
+
+//////////////////////////////////////////////////////////////
+float MeshOptimizer::getACMR(const GLuint * indices, const size_t indexCount, const size_t vertexCount)
+{
+    if (indexCount < 3)
+        return 0.0f;
+
+    // A vertex is still in the FIFO if fewer than its size misses
+    // have happened since it was loaded.
+    std::vector<size_t> cacheTime(vertexCount, 0);
+    size_t time = CE_MESHOPTIMIZER_FIFO_SIZE + 1;
+    size_t misses = 0;
+
+    for (size_t count = 0; count < indexCount; ++count)
+    {
+        if (time - cacheTime[indices[count]] > CE_MESHOPTIMIZER_FIFO_SIZE)
+        {
+            cacheTime[indices[count]] = time++;
+            ++misses;
+        }
+    }
+
+    return (float) misses / (float)(indexCount / 3);
+}
+
+} // namespace ce
@@ -0,0 +1,161 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <cstring>
+
+#include "Mesh/MeshQuantizer.hpp"
+
+namespace ce
+{
+
+//////////////////////////////////////////////////////////////
+static inline GLushort quantizeUnorm(const float value, const float offset, const float scale)
+{
+    float normalized = scale > 0.0f ? (value - offset) / scale : 0.0f;
+    return (GLushort)(glm::clamp(normalized, 0.0f, 1.0f) * 65535.0f + 0.5f);
+}
+
+//////////////////////////////////////////////////////////////
+static inline float decodeSnorm(const GLbyte value)
+{
+    return glm::max(value / 127.0f, -1.0f);
+}
+
+//////////////////////////////////////////////////////////////
+void MeshQuantizer::quantize(MeshData & mesh)
+{
+    const size_t vertexCount = mesh.getVertexCount();
+
+    //////////////////////////////////////////
+    // Find the ranges to map onto the 16 bit
+    // values.
+    //////////////////////////////////////////
+    glm::vec2 texCoordMin(0.0f), texCoordMax(0.0f);
+
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        const GLfloat * texCoord = &mesh.vertices[vertex * CE_MESH_VERTEX_SIZE + 3];
+
+        texCoordMin = vertex > 0 ? glm::min(texCoordMin, glm::vec2(texCoord[0], texCoord[1])) : glm::vec2(texCoord[0], texCoord[1]);
+        texCoordMax = vertex > 0 ? glm::max(texCoordMax, glm::vec2(texCoord[0], texCoord[1])) : glm::vec2(texCoord[0], texCoord[1]);
+    }
+
+    MeshVertexFormat & format = mesh.format;
+    format.quantized      = true;
+    format.positionOffset = mesh.boundsMin;
+    format.positionScale  = mesh.boundsMax - mesh.boundsMin;
+    format.texCoordOffset = texCoordMin;
+    format.texCoordScale  = texCoordMax - texCoordMin;
+
+    //////////////////////////////////////////
+    // Pack the vertices.
+    //////////////////////////////////////////
+    mesh.quantizedVertices.assign(vertexCount * CE_MESH_QUANTIZED_VERTEX_BYTES, 0);
+
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        const GLfloat * source = &mesh.vertices[vertex * CE_MESH_VERTEX_SIZE];
+        unsigned char * target = &mesh.quantizedVertices[vertex * CE_MESH_QUANTIZED_VERTEX_BYTES];
+
+        GLushort position[3];
+        GLushort texCoord[2];
+        GLbyte   normal[2];
+
+        for (int axis = 0; axis < 3; ++axis)
+            position[axis] = quantizeUnorm(source[axis], format.positionOffset[axis], format.positionScale[axis]);
+
+        for (int axis = 0; axis < 2; ++axis)
+            texCoord[axis] = quantizeUnorm(source[3 + axis], format.texCoordOffset[axis], format.texCoordScale[axis]);
+
+        encodeOctahedral(glm::vec3(source[5], source[6], source[7]), normal);
+
+        memcpy(target, position, sizeof(position));
+        memcpy(target + 8, texCoord, sizeof(texCoord));
+        memcpy(target + 12, normal, sizeof(normal));
+    }
+}
+
+//////////////////////////////////////////////////////////////
+void MeshQuantizer::encodeOctahedral(const glm::vec3 & normal, GLbyte encoded[2])
+{
+    float length = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+
+    if (length == 0.0f)
+    {
+        encoded[0] = encoded[1] = 0;
+        return;
+    }
+
+    // Project onto the octahedron, and fold its lower half over
+    // the upper one.
+    glm::vec2 projected(normal.x / length, normal.y / length);
+
+    if (normal.z < 0.0f)
+    {
+        projected = glm::vec2((1.0f - fabsf(projected.y)) * (projected.x >= 0.0f ? 1.0f : -1.0f),
+                              (1.0f - fabsf(projected.x)) * (projected.y >= 0.0f ? 1.0f : -1.0f));
+    }
+
+    // Rounding each axis separately isn't always the closest
+    // encoding, so try the four neighbours.
+    glm::vec3 unitNormal = normal / glm::length(normal);
+    float bestDot = -2.0f;
+
+    for (int candidate = 0; candidate < 4; ++candidate)
+    {
+        GLbyte trial[2] = {
+            (GLbyte) glm::clamp((candidate & 1 ? ceilf : floorf)(projected.x * 127.0f), -127.0f, 127.0f),
+            (GLbyte) glm::clamp((candidate & 2 ? ceilf : floorf)(projected.y * 127.0f), -127.0f, 127.0f)
+        };
+
+        float dot = glm::dot(decodeOctahedral(trial), unitNormal);
+
+        if (dot > bestDot)
+        {
+            bestDot = dot;
+            encoded[0] = trial[0];
+            encoded[1] = trial[1];
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////
+glm::vec3 MeshQuantizer::decodeOctahedral(const GLbyte encoded[2])
+{
+    // This matches the decode in the entity_quantized shader.
+    glm::vec3 normal(decodeSnorm(encoded[0]), decodeSnorm(encoded[1]), 0.0f);
+    normal.z = 1.0f - fabsf(normal.x) - fabsf(normal.y);
+
+    float fold = glm::max(-normal.z, 0.0f);
+    normal.x += normal.x >= 0.0f ? -fold : fold;
+    normal.y += normal.y >= 0.0f ? -fold : fold;
+
+    return normal / glm::length(normal);
+}
+
+} // namespace ce
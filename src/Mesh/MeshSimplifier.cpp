@@ -0,0 +1,627 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "Hash.hpp"
+#include "Mesh/MeshSimplifier.hpp"
+
+#define CE_MESHSIMPLIFIER_EMPTY_SLOT 0xFFFFFFFF
+
+namespace ce
+{
+
+//////////////////////////////////////////////////////////////
+// How much harder open borders hold on to their shape than the
+// surface does.
+//////////////////////////////////////////////////////////////
+static const double BorderWeight = 10.0;
+
+//////////////////////////////////////////////////////////////
+// Triangles whose normal would turn further than this (as the
+// cosine of the angle) are not collapsed.
+//////////////////////////////////////////////////////////////
+static const double MaxNormalTurn = 0.2;
+
+//////////////////////////////////////////////////////////////
+enum VertexKind
+{
+    Manifold, // Free to collapse into any neighbour
+    Seam,     // Only collapses into other seam vertices
+    Border,   // Only collapses along its border
+    Locked    // Never moves
+};
+
+////////////////////////////////////////////////////////////////
+// \brief The symmetric 4x4 matrix of a sum of squared plane
+// distances, together with the total weight of its planes.
+//
+////////////////////////////////////////////////////////////////
+struct Quadric
+{
+    double a00, a11, a22, a01, a02, a12;
+    double b0, b1, b2;
+    double c;
+    double weight;
+};
+
+////////////////////////////////////////////////////////////////
+struct Collapse
+{
+    GLuint from;
+    GLuint to;
+    double cost;
+};
+
+//////////////////////////////////////////////////////////////
+static void addPlane(Quadric & quadric, const glm::dvec3 & normal, const double distance, const double weight)
+{
+    quadric.a00 += weight * normal.x * normal.x;
+    quadric.a11 += weight * normal.y * normal.y;
+    quadric.a22 += weight * normal.z * normal.z;
+    quadric.a01 += weight * normal.x * normal.y;
+    quadric.a02 += weight * normal.x * normal.z;
+    quadric.a12 += weight * normal.y * normal.z;
+    quadric.b0  += weight * normal.x * distance;
+    quadric.b1  += weight * normal.y * distance;
+    quadric.b2  += weight * normal.z * distance;
+    quadric.c   += weight * distance * distance;
+    quadric.weight += weight;
+}
+
+//////////////////////////////////////////////////////////////
+static void addQuadric(Quadric & quadric, const Quadric & other)
+{
+    quadric.a00 += other.a00;
+    quadric.a11 += other.a11;
+    quadric.a22 += other.a22;
+    quadric.a01 += other.a01;
+    quadric.a02 += other.a02;
+    quadric.a12 += other.a12;
+    quadric.b0  += other.b0;
+    quadric.b1  += other.b1;
+    quadric.b2  += other.b2;
+    quadric.c   += other.c;
+    quadric.weight += other.weight;
+}
+
+//////////////////////////////////////////////////////////////
+static double getError(const Quadric & quadric, const glm::dvec3 & p)
+{
+    double error = quadric.a00 * p.x * p.x + quadric.a11 * p.y * p.y + quadric.a22 * p.z * p.z +
+                   2.0 * (quadric.a01 * p.x * p.y + quadric.a02 * p.x * p.z + quadric.a12 * p.y * p.z) +
+                   2.0 * (quadric.b0 * p.x + quadric.b1 * p.y + quadric.b2 * p.z) + quadric.c;
+
+    // Dividing by the weight makes this the mean squared distance
+    // to the planes, so it doesn't grow with the area.
+    return quadric.weight > 0.0 ? fabs(error) / quadric.weight : 0.0;
+}
+
+//////////////////////////////////////////////////////////////
+static inline uint64_t getEdgeKey(const GLuint a, const GLuint b)
+{
+    return a < b ? ((uint64_t) a << 32) | b : ((uint64_t) b << 32) | a;
+}
+
+//////////////////////////////////////////////////////////////
+static bool canCollapse(const VertexKind from, const VertexKind to, const bool borderEdge)
+{
+    switch (from)
+    {
+        case Manifold: return true;
+        case Seam:     return to == Seam || to == Locked;
+        case Border:   return (to == Border || to == Locked) && borderEdge;
+        default:       return false;
+    }
+}
+
+//////////////////////////////////////////////////////////////
+float MeshSimplifier::simplify(const std::vector<GLfloat> & vertices, const GLuint * indices, const size_t indexCount,
+                               const size_t targetIndexCount, const float maxError, std::vector<GLuint> & result)
+{
+    result.assign(indices, indices + indexCount);
+
+    if (indexCount <= targetIndexCount)
+        return 0.0f;
+
+    //////////////////////////////////////////
+    // Work on the vertices this range uses
+    // only, numbered from 0.
+    //////////////////////////////////////////
+    std::vector<GLuint> localIndex(vertices.size() / CE_MESH_VERTEX_SIZE, CE_MESHSIMPLIFIER_EMPTY_SLOT);
+    std::vector<GLuint> globalIndex;
+    std::vector<GLuint> triangles(indexCount);
+
+    for (size_t count = 0; count < indexCount; ++count)
+    {
+        GLuint vertex = indices[count];
+
+        if (localIndex[vertex] == CE_MESHSIMPLIFIER_EMPTY_SLOT)
+        {
+            localIndex[vertex] = (GLuint) globalIndex.size();
+            globalIndex.push_back(vertex);
+        }
+
+        triangles[count] = localIndex[vertex];
+    }
+
+    const size_t vertexCount = globalIndex.size();
+
+    //////////////////////////////////////////
+    // Vertices that only differ in texture
+    // coordinates or normals share a position,
+    // and edges are collapsed between those.
+    //////////////////////////////////////////
+    size_t tableSize = 16;
+    while (tableSize < vertexCount * 2)
+        tableSize <<= 1;
+
+    std::vector<GLuint> table(tableSize, CE_MESHSIMPLIFIER_EMPTY_SLOT);
+    std::vector<GLuint> positionOf(vertexCount);
+    std::vector<GLuint> positionVertex;
+
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        const GLfloat * position = &vertices[globalIndex[vertex] * CE_MESH_VERTEX_SIZE];
+        size_t slot = (size_t) hashBytes(position, 3 * sizeof(GLfloat)) & (tableSize - 1);
+
+        while (table[slot] != CE_MESHSIMPLIFIER_EMPTY_SLOT &&
+               memcmp(&vertices[globalIndex[positionVertex[table[slot]]] * CE_MESH_VERTEX_SIZE], position, 3 * sizeof(GLfloat)) != 0)
+            slot = (slot + 1) & (tableSize - 1);
+
+        if (table[slot] == CE_MESHSIMPLIFIER_EMPTY_SLOT)
+        {
+            table[slot] = (GLuint) positionVertex.size();
+            positionVertex.push_back((GLuint) vertex);
+        }
+
+        positionOf[vertex] = table[slot];
+    }
+
+    const size_t positionCount = positionVertex.size();
+
+    // The vertices at every position, so that corners can pick the
+    // best match at the position they are collapsed into.
+    std::vector<GLuint> firstWedge(positionCount + 1, 0);
+    std::vector<GLuint> wedges(vertexCount);
+
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+        ++firstWedge[positionOf[vertex] + 1];
+
+    for (size_t position = 0; position < positionCount; ++position)
+        firstWedge[position + 1] += firstWedge[position];
+
+    std::vector<GLuint> fill(firstWedge.begin(), firstWedge.end() - 1);
+
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+        wedges[fill[positionOf[vertex]]++] = (GLuint) vertex;
+
+    //////////////////////////////////////////
+    // Scale the whole mesh (not just this
+    // range) into the unit cube, so that errors
+    // are relative to its size.
+    //////////////////////////////////////////
+    glm::dvec3 boundsMin(HUGE_VAL), boundsMax(-HUGE_VAL);
+
+    for (size_t vertex = 0; vertex < vertices.size(); vertex += CE_MESH_VERTEX_SIZE)
+    {
+        glm::dvec3 position(vertices[vertex], vertices[vertex + 1], vertices[vertex + 2]);
+
+        boundsMin = glm::min(boundsMin, position);
+        boundsMax = glm::max(boundsMax, position);
+    }
+
+    glm::dvec3 size = boundsMax - boundsMin;
+    double extent = std::max(size.x, std::max(size.y, size.z));
+    double scale = extent > 0.0 ? 1.0 / extent : 1.0;
+
+    std::vector<glm::dvec3> points(positionCount);
+
+    for (size_t position = 0; position < positionCount; ++position)
+    {
+        const GLfloat * vertex = &vertices[globalIndex[positionVertex[position]] * CE_MESH_VERTEX_SIZE];
+        points[position] = (glm::dvec3(vertex[0], vertex[1], vertex[2]) - boundsMin) * scale;
+    }
+
+    //////////////////////////////////////////
+    // Find the open borders and classify the
+    // positions.
+    //////////////////////////////////////////
+    std::vector<uint64_t> edges;
+    edges.reserve(indexCount);
+
+    for (size_t count = 0; count < indexCount; count += 3)
+    {
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            GLuint a = positionOf[triangles[count + corner]];
+            GLuint b = positionOf[triangles[count + (corner + 1) % 3]];
+
+            if (a != b)
+                edges.push_back(getEdgeKey(a, b));
+        }
+    }
+
+    std::sort(edges.begin(), edges.end());
+
+    std::vector<VertexKind> kinds(positionCount, Manifold);
+    std::vector<uint64_t> borderEdges;
+
+    for (size_t position = 0; position < positionCount; ++position)
+    {
+        if (firstWedge[position + 1] - firstWedge[position] > 1)
+            kinds[position] = Seam;
+    }
+
+    for (size_t count = 0; count < edges.size(); )
+    {
+        size_t end = count + 1;
+        while (end < edges.size() && edges[end] == edges[count])
+            ++end;
+
+        // Edges that aren't shared by exactly two triangles are on a
+        // border (or are non-manifold, which is treated the same).
+        if (end - count != 2)
+        {
+            borderEdges.push_back(edges[count]);
+
+            GLuint ends[2] = { (GLuint)(edges[count] >> 32), (GLuint)(edges[count] & 0xFFFFFFFF) };
+
+            for (GLuint position : ends)
+                kinds[position] = (kinds[position] == Seam || kinds[position] == Locked) ? Locked : Border;
+        }
+
+        count = end;
+    }
+
+    //////////////////////////////////////////
+    // Sum up the planes around every position,
+    // with extra planes along the borders that
+    // keep them from shrinking.
+    //////////////////////////////////////////
+    std::vector<Quadric> quadrics(positionCount);
+    memset(&quadrics[0], 0, quadrics.size() * sizeof(Quadric));
+
+    for (size_t count = 0; count < indexCount; count += 3)
+    {
+        GLuint corners[3] = { positionOf[triangles[count]], positionOf[triangles[count + 1]], positionOf[triangles[count + 2]] };
+
+        glm::dvec3 normal = glm::cross(points[corners[1]] - points[corners[0]], points[corners[2]] - points[corners[0]]);
+        double length = glm::length(normal);
+
+        if (length == 0.0)
+            continue;
+
+        normal /= length;
+        double distance = -glm::dot(normal, points[corners[0]]);
+
+        for (int corner = 0; corner < 3; ++corner)
+            addPlane(quadrics[corners[corner]], normal, distance, length * 0.5);
+
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            GLuint a = corners[corner];
+            GLuint b = corners[(corner + 1) % 3];
+
+            if (!std::binary_search(borderEdges.begin(), borderEdges.end(), getEdgeKey(a, b)))
+                continue;
+
+            glm::dvec3 edge = points[b] - points[a];
+            glm::dvec3 borderNormal = glm::cross(edge, normal);
+            double borderLength = glm::length(borderNormal);
+
+            if (borderLength == 0.0)
+                continue;
+
+            borderNormal /= borderLength;
+            double borderDistance = -glm::dot(borderNormal, points[a]);
+            double weight = glm::dot(edge, edge) * BorderWeight;
+
+            addPlane(quadrics[a], borderNormal, borderDistance, weight);
+            addPlane(quadrics[b], borderNormal, borderDistance, weight);
+        }
+    }
+
+    //////////////////////////////////////////
+    // Collapse the cheapest edges in passes,
+    // never touching a triangle twice in one
+    // pass, until the target is reached.
+    //////////////////////////////////////////
+    const size_t targetTriangleCount = targetIndexCount / 3;
+    const double maxCost = (double) maxError * maxError;
+
+    std::vector<GLuint> remap(positionCount);
+    std::vector<bool>   touched(positionCount);
+    std::vector<GLuint> firstAdjacent(positionCount + 1);
+    std::vector<GLuint> adjacent;
+    std::vector<Collapse> collapses;
+
+    double resultError = 0.0;
+
+    while (triangles.size() / 3 > targetTriangleCount)
+    {
+        const size_t triangleCount = triangles.size() / 3;
+
+        // The edges of the current triangles (and which of them are
+        // borders) change with every pass.
+        edges.clear();
+
+        for (size_t count = 0; count < triangles.size(); count += 3)
+        {
+            for (int corner = 0; corner < 3; ++corner)
+                edges.push_back(getEdgeKey(positionOf[triangles[count + corner]], positionOf[triangles[count + (corner + 1) % 3]]));
+        }
+
+        std::sort(edges.begin(), edges.end());
+        collapses.clear();
+
+        for (size_t count = 0; count < edges.size(); )
+        {
+            size_t end = count + 1;
+            while (end < edges.size() && edges[end] == edges[count])
+                ++end;
+
+            GLuint a = (GLuint)(edges[count] >> 32);
+            GLuint b = (GLuint)(edges[count] & 0xFFFFFFFF);
+            bool borderEdge = end - count == 1;
+
+            Collapse collapse = { a, b, HUGE_VAL };
+
+            if (canCollapse(kinds[a], kinds[b], borderEdge))
+                collapse.cost = getError(quadrics[a], points[b]);
+
+            if (canCollapse(kinds[b], kinds[a], borderEdge))
+            {
+                double cost = getError(quadrics[b], points[a]);
+
+                if (cost < collapse.cost)
+                {
+                    collapse.from = b;
+                    collapse.to   = a;
+                    collapse.cost = cost;
+                }
+            }
+
+            if (collapse.cost <= maxCost)
+                collapses.push_back(collapse);
+
+            count = end;
+        }
+
+        std::sort(collapses.begin(), collapses.end(),
+            [](const Collapse & left, const Collapse & right) { return left.cost < right.cost; });
+
+        // The triangles around every position.
+        std::fill(firstAdjacent.begin(), firstAdjacent.end(), 0);
+        adjacent.resize(triangles.size());
+
+        for (GLuint vertex : triangles)
+            ++firstAdjacent[positionOf[vertex] + 1];
+
+        for (size_t position = 0; position < positionCount; ++position)
+            firstAdjacent[position + 1] += firstAdjacent[position];
+
+        fill.assign(firstAdjacent.begin(), firstAdjacent.end() - 1);
+
+        for (size_t count = 0; count < triangles.size(); ++count)
+            adjacent[fill[positionOf[triangles[count]]]++] = (GLuint)(count / 3);
+
+        for (size_t position = 0; position < positionCount; ++position)
+            remap[position] = (GLuint) position;
+
+        std::fill(touched.begin(), touched.end(), false);
+
+        // Every collapse removes about two triangles.
+        size_t collapseLimit = (triangleCount - targetTriangleCount + 1) / 2;
+        size_t collapseCount = 0;
+
+        for (const Collapse & collapse : collapses)
+        {
+            if (collapseCount >= collapseLimit)
+                break;
+
+            if (touched[collapse.from] || touched[collapse.to])
+                continue;
+
+            // Don't collapse edges that would flip (or nearly flip)
+            // one of the remaining triangles.
+            bool flips = false;
+
+            for (GLuint index = firstAdjacent[collapse.from]; index < firstAdjacent[collapse.from + 1] && !flips; ++index)
+            {
+                const GLuint * triangle = &triangles[adjacent[index] * 3];
+                GLuint corners[3] = { positionOf[triangle[0]], positionOf[triangle[1]], positionOf[triangle[2]] };
+
+                if (corners[0] == collapse.to || corners[1] == collapse.to || corners[2] == collapse.to)
+                    continue;
+
+                glm::dvec3 before = glm::cross(points[corners[1]] - points[corners[0]], points[corners[2]] - points[corners[0]]);
+
+                for (GLuint & corner : corners)
+                {
+                    if (corner == collapse.from)
+                        corner = collapse.to;
+                }
+
+                glm::dvec3 after = glm::cross(points[corners[1]] - points[corners[0]], points[corners[2]] - points[corners[0]]);
+
+                flips = glm::dot(before, after) <= MaxNormalTurn * glm::length(before) * glm::length(after);
+            }
+
+            if (flips)
+                continue;
+
+            remap[collapse.from] = collapse.to;
+            addQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+            resultError = std::max(resultError, collapse.cost);
+
+            for (GLuint index = firstAdjacent[collapse.from]; index < firstAdjacent[collapse.from + 1]; ++index)
+            {
+                const GLuint * triangle = &triangles[adjacent[index] * 3];
+
+                for (int corner = 0; corner < 3; ++corner)
+                    touched[positionOf[triangle[corner]]] = true;
+            }
+
+            ++collapseCount;
+        }
+
+        if (collapseCount == 0)
+            break;
+
+        //////////////////////////////////////////
+        // Move the corners of collapsed positions
+        // to the closest matching vertex at their
+        // new position, and drop the triangles
+        // that have become degenerate.
+        //////////////////////////////////////////
+        size_t kept = 0;
+
+        for (size_t count = 0; count < triangles.size(); count += 3)
+        {
+            GLuint triangle[3];
+
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                GLuint vertex = triangles[count + corner];
+                GLuint position = remap[positionOf[vertex]];
+
+                if (position != positionOf[vertex])
+                {
+                    const GLfloat * attributes = &vertices[globalIndex[vertex] * CE_MESH_VERTEX_SIZE];
+                    float bestDistance = HUGE_VALF;
+
+                    for (GLuint wedge = firstWedge[position]; wedge < firstWedge[position + 1]; ++wedge)
+                    {
+                        const GLfloat * candidate = &vertices[globalIndex[wedges[wedge]] * CE_MESH_VERTEX_SIZE];
+                        float distance = 0.0f;
+
+                        for (int attribute = 3; attribute < CE_MESH_VERTEX_SIZE; ++attribute)
+                            distance += (candidate[attribute] - attributes[attribute]) * (candidate[attribute] - attributes[attribute]);
+
+                        if (distance < bestDistance)
+                        {
+                            bestDistance = distance;
+                            vertex = wedges[wedge];
+                        }
+                    }
+                }
+
+                triangle[corner] = vertex;
+            }
+
+            if (positionOf[triangle[0]] != positionOf[triangle[1]] &&
+                positionOf[triangle[1]] != positionOf[triangle[2]] &&
+                positionOf[triangle[2]] != positionOf[triangle[0]])
+            {
+                std::copy(triangle, triangle + 3, &triangles[kept]);
+                kept += 3;
+            }
+        }
+
+        triangles.resize(kept);
+    }
+
+    result.resize(triangles.size());
+
+    for (size_t count = 0; count < triangles.size(); ++count)
+        result[count] = globalIndex[triangles[count]];
+
+    return (float) sqrt(resultError);
+}
+
+//////////////////////////////////////////////////////////////
+void MeshSimplifier::buildLods(MeshData & mesh)
+{
+    mesh.lods.clear();
+
+    std::vector<MeshRange> sourceRanges = mesh.ranges;
+    size_t sourceIndexCount = mesh.indices.size();
+    float sourceError = 0.0f;
+
+    std::vector<GLuint> source;
+    std::vector<GLuint> result;
+
+    for (int level = 1; level <= CE_MESHSIMPLIFIER_MAX_LODS; ++level)
+    {
+        // Every level starts from the one before it, so the errors
+        // add up and are kept within one budget.
+        float maxError = CE_MESHSIMPLIFIER_MAX_ERROR - sourceError;
+
+        if (maxError <= 0.0f)
+            break;
+
+        MeshLodData lod;
+        lod.error = sourceError;
+
+        const size_t firstIndex = mesh.indices.size();
+        size_t lodIndexCount = 0;
+
+        for (const MeshRange & range : sourceRanges)
+        {
+            // A range without a whole triangle has nothing to simplify.
+            if (range.indexCount < 3)
+                continue;
+
+            source.assign(mesh.indices.begin() + range.firstIndex, mesh.indices.begin() + range.firstIndex + range.indexCount);
+
+            float error = simplify(mesh.vertices, &source[0], source.size(), (range.indexCount / 6) * 3, maxError, result);
+            lod.error = std::max(lod.error, sourceError + error);
+
+            if (result.empty())
+                continue;
+
+            MeshRange lodRange;
+            lodRange.firstIndex = (GLuint) mesh.indices.size();
+            lodRange.indexCount = (GLuint) result.size();
+            lodRange.material   = range.material;
+
+            mesh.indices.insert(mesh.indices.end(), result.begin(), result.end());
+            lod.ranges.push_back(lodRange);
+            lodIndexCount += result.size();
+        }
+
+        if (lodIndexCount == 0 || lodIndexCount > sourceIndexCount * CE_MESHSIMPLIFIER_MIN_REDUCTION)
+        {
+            mesh.indices.resize(firstIndex);
+            break;
+        }
+
+        LOG("Built LOD " + std::to_string(level) + " with " + std::to_string(lodIndexCount / 3) +
+            " triangles, error " + std::to_string(lod.error));
+
+        mesh.lods.push_back(lod);
+
+        sourceRanges = lod.ranges;
+        sourceIndexCount = lodIndexCount;
+        sourceError = lod.error;
+    }
+}
+
+} // namespace ce
@@ -0,0 +1,265 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+#include "Mesh/MeshletBuilder.hpp"
+
+#define CE_MESHLETBUILDER_EMPTY_SLOT    0xFFFFFFFF
+#define CE_MESHLETBUILDER_SEARCH_WINDOW 64
+
+namespace ce
+{
+
+//////////////////////////////////////////////////////////////
+static inline glm::vec3 getPosition(const MeshData & mesh, const GLuint vertex)
+{
+    const GLfloat * position = &mesh.vertices[vertex * CE_MESH_VERTEX_SIZE];
+    return glm::vec3(position[0], position[1], position[2]);
+}
+
+//////////////////////////////////////////////////////////////
+static glm::vec3 getTriangleNormal(const MeshData & mesh, const GLuint * triangle)
+{
+    glm::vec3 a = getPosition(mesh, triangle[0]);
+    glm::vec3 normal = glm::cross(getPosition(mesh, triangle[1]) - a, getPosition(mesh, triangle[2]) - a);
+    float length = glm::length(normal);
+
+    return length > 0.0f ? normal / length : glm::vec3(0.0f);
+}
+
+//////////////////////////////////////////////////////////////
+void MeshletBuilder::build(MeshData & mesh)
+{
+    mesh.meshlets.clear();
+
+    for (const MeshRange & range : mesh.ranges)
+        buildRange(mesh, range);
+
+    for (const MeshLodData & lod : mesh.lods)
+    {
+        for (const MeshRange & range : lod.ranges)
+            buildRange(mesh, range);
+    }
+
+    std::sort(mesh.meshlets.begin(), mesh.meshlets.end(),
+        [](const Meshlet & left, const Meshlet & right) { return left.firstIndex < right.firstIndex; });
+
+    LOG("Built " + std::to_string(mesh.meshlets.size()) + " meshlets.");
+}
+
+//////////////////////////////////////////////////////////////
+void MeshletBuilder::buildRange(MeshData & mesh, const MeshRange & range)
+{
+    const size_t triangleCount = range.indexCount / 3;
+    const size_t vertexCount = mesh.getVertexCount();
+    GLuint * indices = &mesh.indices[range.firstIndex];
+
+    //////////////////////////////////////////
+    // Build the list of triangles that use each
+    // vertex.
+    //////////////////////////////////////////
+    std::vector<GLuint> firstTriangle(vertexCount + 1, 0);
+    std::vector<GLuint> vertexTriangles(triangleCount * 3);
+    std::vector<glm::vec3> triangleNormals(triangleCount);
+
+    for (size_t count = 0; count < triangleCount * 3; ++count)
+        ++firstTriangle[indices[count] + 1];
+
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+        firstTriangle[vertex + 1] += firstTriangle[vertex];
+
+    std::vector<GLuint> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+
+    for (size_t count = 0; count < triangleCount * 3; ++count)
+        vertexTriangles[fill[indices[count]]++] = (GLuint)(count / 3);
+
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+        triangleNormals[triangle] = getTriangleNormal(mesh, &indices[triangle * 3]);
+
+    //////////////////////////////////////////
+    // Grow the meshlets.
+    //////////////////////////////////////////
+    std::vector<bool>   used(triangleCount, false);
+    std::vector<GLuint> vertexMeshlet(vertexCount, CE_MESHLETBUILDER_EMPTY_SLOT);
+    std::vector<GLuint> output;
+    std::vector<GLuint> meshletVertices;
+    std::vector<GLuint> meshletTriangles;
+
+    output.reserve(triangleCount * 3);
+
+    size_t seed = 0;
+
+    while (output.size() < triangleCount * 3)
+    {
+        while (used[seed])
+            ++seed;
+
+        const GLuint meshletId = (GLuint) mesh.meshlets.size();
+        glm::vec3 normalSum(0.0f);
+        glm::vec3 centroidSum(0.0f);
+
+        meshletVertices.clear();
+        meshletTriangles.clear();
+
+        GLuint next = (GLuint) seed;
+
+        while (next != CE_MESHLETBUILDER_EMPTY_SLOT)
+        {
+            used[next] = true;
+            meshletTriangles.push_back(next);
+            normalSum += triangleNormals[next];
+            centroidSum += getPosition(mesh, indices[next * 3]) + getPosition(mesh, indices[next * 3 + 1]) + getPosition(mesh, indices[next * 3 + 2]);
+
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                GLuint vertex = indices[next * 3 + corner];
+
+                if (vertexMeshlet[vertex] != meshletId)
+                {
+                    vertexMeshlet[vertex] = meshletId;
+                    meshletVertices.push_back(vertex);
+                }
+            }
+
+            if (meshletTriangles.size() >= CE_MESHLET_MAX_TRIANGLES)
+                break;
+
+            // Pick the neighbour that adds the fewest vertices, and
+            // among those the one facing the most like the rest.
+            float axisLength = glm::length(normalSum);
+            glm::vec3 axis = axisLength > 0.0f ? normalSum / axisLength : glm::vec3(0.0f);
+
+            float bestScore = FLT_MAX;
+            next = CE_MESHLETBUILDER_EMPTY_SLOT;
+
+            for (GLuint vertex : meshletVertices)
+            {
+                for (GLuint index = firstTriangle[vertex]; index < firstTriangle[vertex + 1]; ++index)
+                {
+                    GLuint candidate = vertexTriangles[index];
+
+                    if (used[candidate])
+                        continue;
+
+                    int newVertices = 0;
+
+                    for (int corner = 0; corner < 3; ++corner)
+                        newVertices += vertexMeshlet[indices[candidate * 3 + corner]] != meshletId;
+
+                    if (meshletVertices.size() + newVertices > CE_MESHLET_MAX_VERTICES)
+                        continue;
+
+                    float score = newVertices + (1.0f - glm::dot(triangleNormals[candidate], axis)) * 0.5f;
+
+                    if (score < bestScore)
+                    {
+                        bestScore = score;
+                        next = candidate;
+                    }
+                }
+            }
+
+            // Without a neighbour left (at the edge of a small,
+            // disconnected piece), carry on with the closest of the
+            // next few triangles rather than ending up with lots of
+            // tiny meshlets.
+            if (next == CE_MESHLETBUILDER_EMPTY_SLOT && meshletVertices.size() + 3 <= CE_MESHLET_MAX_VERTICES)
+            {
+                glm::vec3 centroid = centroidSum / (3.0f * meshletTriangles.size());
+                float bestDistance = FLT_MAX;
+                size_t searched = 0;
+
+                for (size_t candidate = seed; candidate < triangleCount && searched < CE_MESHLETBUILDER_SEARCH_WINDOW; ++candidate)
+                {
+                    if (used[candidate])
+                        continue;
+
+                    glm::vec3 candidateCentroid = (getPosition(mesh, indices[candidate * 3]) + getPosition(mesh, indices[candidate * 3 + 1]) + getPosition(mesh, indices[candidate * 3 + 2])) / 3.0f;
+                    float distance = glm::length(candidateCentroid - centroid);
+
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        next = (GLuint) candidate;
+                    }
+
+                    ++searched;
+                }
+            }
+        }
+
+        //////////////////////////////////////////
+        // Move the triangles together and find
+        // the bounds of the meshlet.
+        //////////////////////////////////////////
+        std::sort(meshletTriangles.begin(), meshletTriangles.end());
+
+        Meshlet meshlet;
+        meshlet.firstIndex = (GLuint)(range.firstIndex + output.size());
+        meshlet.indexCount = (GLuint)(meshletTriangles.size() * 3);
+
+        for (GLuint triangle : meshletTriangles)
+            output.insert(output.end(), &indices[triangle * 3], &indices[triangle * 3 + 3]);
+
+        glm::vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+
+        for (GLuint vertex : meshletVertices)
+        {
+            boundsMin = glm::min(boundsMin, getPosition(mesh, vertex));
+            boundsMax = glm::max(boundsMax, getPosition(mesh, vertex));
+        }
+
+        meshlet.center = (boundsMin + boundsMax) * 0.5f;
+        meshlet.radius = 0.0f;
+
+        for (GLuint vertex : meshletVertices)
+            meshlet.radius = glm::max(meshlet.radius, glm::length(getPosition(mesh, vertex) - meshlet.center));
+
+        float axisLength = glm::length(normalSum);
+        meshlet.coneAxis = axisLength > 0.0f ? normalSum / axisLength : glm::vec3(0.0f, 0.0f, 1.0f);
+
+        float minDot = axisLength > 0.0f ? 1.0f : -1.0f;
+
+        for (GLuint triangle : meshletTriangles)
+        {
+            if (triangleNormals[triangle] != glm::vec3(0.0f))
+                minDot = glm::min(minDot, glm::dot(triangleNormals[triangle], meshlet.coneAxis));
+        }
+
+        // Cones that open up to a half space or more face every way.
+        meshlet.coneCutoff = minDot <= 0.0f ? 1.0f : sqrtf(1.0f - minDot * minDot);
+
+        mesh.meshlets.push_back(meshlet);
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+} // namespace ce
@@ -0,0 +1,132 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <algorithm>
+
+#include "Mesh/MeshletCuller.hpp"
+
+namespace ce
+{
+
+//////////////////////////////////////////////////////////////
+static void addDraw(const Submesh & submesh, const GLuint & firstIndex, const GLuint & indexCount, MeshDrawList & drawList)
+{
+    const GLvoid * offset = (const GLvoid *)(firstIndex * submesh.getIndexSize());
+
+    if (drawList.batches.empty() || drawList.batches.back().texture != submesh.texture || drawList.batches.back().vao != submesh.vao)
+        drawList.batches.push_back({ submesh.vao, submesh.indexType, submesh.texture, drawList.counts.size(), 0 });
+
+    // Merge with the previous draw when the indices follow on.
+    if (drawList.batches.back().count > 0 &&
+        (const char *) drawList.offsets.back() + drawList.counts.back() * submesh.getIndexSize() == (const char *) offset)
+    {
+        drawList.counts.back() += indexCount;
+        return;
+    }
+
+    drawList.counts.push_back(indexCount);
+    drawList.offsets.push_back(offset);
+    ++drawList.batches.back().count;
+}
+
+//////////////////////////////////////////////////////////////
+void MeshletCuller::getFrustumPlanes(const glm::mat4 & clip, glm::vec4 planes[6])
+{
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        for (int side = 0; side < 2; ++side)
+        {
+            glm::vec4 & plane = planes[axis * 2 + side];
+            float sign = side == 0 ? 1.0f : -1.0f;
+
+            for (int column = 0; column < 4; ++column)
+                plane[column] = clip[column][3] + sign * clip[column][axis];
+
+            plane /= glm::length(glm::vec3(plane));
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////
+void MeshletCuller::cull(const Mesh & mesh, const size_t & lod, const glm::mat4 & model, const glm::mat4 & view, const glm::mat4 & projection, MeshDrawList & drawList)
+{
+    drawList.clear();
+
+    //////////////////////////////////////////
+    // Everything is tested in model space, so
+    // the meshlet bounds don't need to be
+    // transformed.
+    //////////////////////////////////////////
+    glm::mat4 modelView = view * model;
+    glm::vec4 planes[6];
+    getFrustumPlanes(projection * modelView, planes);
+
+    glm::mat4 inverseModelView = glm::inverse(modelView);
+    bool perspective = projection[3][3] == 0.0f;
+    glm::vec3 cameraPosition = glm::vec3(inverseModelView[3]);
+    glm::vec3 viewDirection = glm::normalize(glm::vec3(inverseModelView * glm::vec4(0.0f, 0.0f, -1.0f, 0.0f)));
+
+    for (const Submesh & submesh : mesh.getSubmeshes(lod))
+    {
+        if (submesh.meshletCount == 0)
+        {
+            addDraw(submesh, submesh.firstIndex, submesh.indexCount, drawList);
+            continue;
+        }
+
+        for (GLuint index = submesh.firstMeshlet; index < submesh.firstMeshlet + submesh.meshletCount; ++index)
+        {
+            const Meshlet & meshlet = mesh.meshlets[index];
+            bool visible = true;
+
+            for (int plane = 0; plane < 6 && visible; ++plane)
+                visible = glm::dot(glm::vec3(planes[plane]), meshlet.center) + planes[plane].w >= -meshlet.radius;
+
+            if (!visible)
+                continue;
+
+            // Every triangle faces away when the whole sphere lies
+            // inside of the cone behind the meshlet.
+            if (perspective)
+            {
+                glm::vec3 toMeshlet = meshlet.center - cameraPosition;
+
+                if (glm::dot(toMeshlet, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(toMeshlet) + meshlet.radius)
+                    continue;
+            }
+            else if (meshlet.coneCutoff < 1.0f && glm::dot(viewDirection, meshlet.coneAxis) >= meshlet.coneCutoff)
+            {
+                continue;
+            }
+
+            addDraw(submesh, meshlet.firstIndex, meshlet.indexCount, drawList);
+        }
+    }
+}
+
+} // namespace ce
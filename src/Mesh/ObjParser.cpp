@@ -0,0 +1,456 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#include <cstdlib>
+#include <cstring>
+
+#include "Mesh/ObjParser.hpp"
+#include "NumberParser.hpp"
+#include "Parallel.hpp"
+
+namespace ce
+{
+
+//////////////////////////////////////////////////////////////
+// \brief A slice of an OBJ file that is parsed on its own
+// thread, along with where its elements end up once all of
+// the chunks are merged back together.
+//////////////////////////////////////////////////////////////
+struct ObjChunk
+{
+    const char *        begin;
+    const char *        end;
+
+    ObjData             data;
+
+    // Negative (relative) indices can only be resolved against the
+    // elements read so far in this chunk, so they're recorded here
+    // as (corner * 3 + attribute) to be offset during the merge.
+    std::vector<size_t> relativeIndices;
+
+    size_t              positionBase;
+    size_t              texCoordBase;
+    size_t              normalBase;
+    size_t              cornerBase;
+};
+
+//////////////////////////////////////////////////////////////
+// Lexer helpers. Every helper takes the current position and
+// the end of the mapped file and never reads past the end.
+//////////////////////////////////////////////////////////////
+static inline bool isBlank(const char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+//////////////////////////////////////////////////////////////
+static inline bool isDigit(const char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+//////////////////////////////////////////////////////////////
+static inline const char * skipBlanks(const char * p, const char * end)
+{
+    while (p < end && isBlank(*p))
+        ++p;
+
+    return p;
+}
+
+//////////////////////////////////////////////////////////////
+static inline const char * findLineEnd(const char * p, const char * end)
+{
+    if (p >= end)
+        return end;
+
+    const char * newLine = (const char *) memchr(p, '\n', end - p);
+    return newLine != nullptr ? newLine : end;
+}
+
+//////////////////////////////////////////////////////////////
+static inline const char * skipLine(const char * p, const char * end)
+{
+    p = findLineEnd(p, end);
+    return p < end ? p + 1 : end;
+}
+
+//////////////////////////////////////////////////////////////
+static inline bool matchKeyword(const char * p, const char * end, const char * keyword, const size_t length)
+{
+    return (size_t)(end - p) > length && memcmp(p, keyword, length) == 0 && isBlank(p[length]);
+}
+
+//////////////////////////////////////////////////////////////
+static inline const char * readRestOfLine(const char * p, const char * end, std::string & value)
+{
+    p = skipBlanks(p, end);
+
+    const char * lineEnd  = findLineEnd(p, end);
+    const char * valueEnd = lineEnd;
+    while (valueEnd > p && isBlank(valueEnd[-1]))
+        --valueEnd;
+
+    value.assign(p, valueEnd - p);
+    return lineEnd;
+}
+
+//////////////////////////////////////////////////////////////
+static inline const char * parseFloat(const char * p, const char * end, float & value)
+{
+    return NumberParser::parseFloat(skipBlanks(p, end), end, value);
+}
+
+//////////////////////////////////////////////////////////////
+static inline const char * parseIndex(const char * p, const char * end, const size_t count, int & index, bool & relative)
+{
+    long value;
+    p = NumberParser::parseInt(p, end, value);
+
+    // OBJ indices are one based, and negative indices count
+    // backwards from the most recently read element.
+    relative = value < 0;
+
+    if (value == 0)
+        index = -1;
+    else if (relative)
+        index = (int)((long)count + value);
+    else
+        index = (int)(value - 1);
+
+    return p;
+}
+
+//////////////////////////////////////////////////////////////
+static inline const char * parseFace(const char * p, const char * end, ObjData & data, std::vector<size_t> & relativeIndices)
+{
+    ObjIndex first, previous, corner;
+    bool relative[3];
+    unsigned int cornerCount = 0;
+    unsigned int firstRelative = 0, previousRelative = 0;
+
+    for (;;)
+    {
+        p = skipBlanks(p, end);
+        if (p == end || !(isDigit(*p) || *p == '-' || *p == '+'))
+            break;
+
+        corner.texCoord = -1;
+        corner.normal   = -1;
+        relative[0] = relative[1] = relative[2] = false;
+
+        p = parseIndex(p, end, data.positions.size(), corner.position, relative[0]);
+        if (p < end && *p == '/')
+        {
+            ++p;
+            if (p < end && *p != '/')
+                p = parseIndex(p, end, data.texCoords.size(), corner.texCoord, relative[1]);
+
+            if (p < end && *p == '/')
+                p = parseIndex(p + 1, end, data.normals.size(), corner.normal, relative[2]);
+        }
+
+        unsigned int cornerRelative = relative[0] | (relative[1] << 1) | (relative[2] << 2);
+
+        // Triangulate polygons as a fan around the first corner.
+        if (cornerCount == 0)
+        {
+            first = corner;
+            firstRelative = cornerRelative;
+        }
+        else if (cornerCount >= 2)
+        {
+            const ObjIndex     triangle[3]         = { first, previous, corner };
+            const unsigned int triangleRelative[3] = { firstRelative, previousRelative, cornerRelative };
+
+            for (unsigned int count = 0; count < 3; ++count)
+            {
+                for (unsigned int attribute = 0; attribute < 3; ++attribute)
+                {
+                    if (triangleRelative[count] & (1 << attribute))
+                        relativeIndices.push_back(data.corners.size() * 3 + attribute);
+                }
+
+                data.corners.push_back(triangle[count]);
+            }
+        }
+
+        previous = corner;
+        previousRelative = cornerRelative;
+        ++cornerCount;
+    }
+
+    return p;
+}
+
+//////////////////////////////////////////////////////////////
+bool ObjParser::parseFile(const std::string & filename, ObjData & data)
+{
+    LOG("Reading mesh: " + filename);
+    MappedFile file(filename);
+
+    if (!file.isOpen())
+        return false;
+
+    parse(file.getData(), file.getData() + file.getSize(), data);
+    return true;
+}
+
+//////////////////////////////////////////////////////////////
+static void parseChunk(const char * begin, const char * end, ObjData & data, std::vector<size_t> & relativeIndices)
+{
+    const char * p = begin;
+
+    while (p < end)
+    {
+        p = skipBlanks(p, end);
+        if (p == end)
+            break;
+
+        if (p[0] == 'v' && p + 1 < end)
+        {
+            if (isBlank(p[1]))
+            {
+                glm::vec3 position;
+                p = parseFloat(p + 1, end, position.x);
+                p = parseFloat(p, end, position.y);
+                p = parseFloat(p, end, position.z);
+                data.positions.push_back(position);
+            }
+            else if (p[1] == 't' && p + 2 < end && isBlank(p[2]))
+            {
+                glm::vec2 texCoord;
+                p = parseFloat(p + 2, end, texCoord.x);
+                p = parseFloat(p, end, texCoord.y);
+                data.texCoords.push_back(texCoord);
+            }
+            else if (p[1] == 'n' && p + 2 < end && isBlank(p[2]))
+            {
+                glm::vec3 normal;
+                p = parseFloat(p + 2, end, normal.x);
+                p = parseFloat(p, end, normal.y);
+                p = parseFloat(p, end, normal.z);
+                data.normals.push_back(normal);
+            }
+        }
+        else if (p[0] == 'f' && p + 1 < end && isBlank(p[1]))
+        {
+            p = parseFace(p + 1, end, data, relativeIndices);
+        }
+        else if (matchKeyword(p, end, "usemtl", 6))
+        {
+            ObjMaterialGroup group;
+            group.firstTriangle = data.corners.size() / 3;
+            p = readRestOfLine(p + 6, end, group.name);
+            data.materialGroups.push_back(group);
+        }
+        else if (matchKeyword(p, end, "mtllib", 6))
+        {
+            p = readRestOfLine(p + 6, end, data.materialLibrary);
+        }
+
+        p = skipLine(p, end);
+    }
+}
+
+//////////////////////////////////////////////////////////////
+static inline int offsetIndex(const int index, const size_t base)
+{
+    return (int)(index + (long)base);
+}
+
+//////////////////////////////////////////////////////////////
+void ObjParser::parse(const char * begin, const char * end, ObjData & data, std::vector<size_t> * relativeIndices)
+{
+    //////////////////////////////////////////
+    // Small files are parsed in less time than
+    // it takes to start the threads.
+    //////////////////////////////////////////
+    size_t chunkCount = std::min<size_t>(getThreadCount(), (end - begin) / CE_OBJPARSER_MIN_CHUNK_SIZE);
+
+    if (chunkCount <= 1)
+    {
+        std::vector<size_t> chunkRelativeIndices;
+        parseChunk(begin, end, data, relativeIndices != nullptr ? *relativeIndices : chunkRelativeIndices);
+        return;
+    }
+
+    //////////////////////////////////////////
+    // Split the file at line boundaries and
+    // parse every chunk on its own thread.
+    //////////////////////////////////////////
+    std::vector<ObjChunk> chunks(chunkCount);
+    const size_t chunkSize = (end - begin) / chunkCount;
+    const char * chunkBegin = begin;
+
+    for (size_t index = 0; index < chunkCount; ++index)
+    {
+        const char * chunkEnd = (index + 1 == chunkCount) ? end : skipLine(std::max(chunkBegin, begin + (index + 1) * chunkSize), end);
+
+        chunks[index].begin = chunkBegin;
+        chunks[index].end   = chunkEnd;
+        chunkBegin = chunkEnd;
+    }
+
+    parallelFor(chunkCount, [&](const size_t index)
+    {
+        ObjChunk & chunk = chunks[index];
+        parseChunk(chunk.begin, chunk.end, chunk.data, chunk.relativeIndices);
+    });
+
+    //////////////////////////////////////////
+    // Prefix sum the element counts to find
+    // where every chunk lands in the result.
+    //////////////////////////////////////////
+    size_t positionCount = data.positions.size();
+    size_t texCoordCount = data.texCoords.size();
+    size_t normalCount   = data.normals.size();
+    size_t cornerCount   = data.corners.size();
+
+    for (ObjChunk & chunk : chunks)
+    {
+        chunk.positionBase = positionCount;
+        chunk.texCoordBase = texCoordCount;
+        chunk.normalBase   = normalCount;
+        chunk.cornerBase   = cornerCount;
+
+        positionCount += chunk.data.positions.size();
+        texCoordCount += chunk.data.texCoords.size();
+        normalCount   += chunk.data.normals.size();
+        cornerCount   += chunk.data.corners.size();
+
+        for (ObjMaterialGroup & group : chunk.data.materialGroups)
+        {
+            group.firstTriangle += chunk.cornerBase / 3;
+            data.materialGroups.push_back(group);
+        }
+
+        if (data.materialLibrary == "")
+            data.materialLibrary = chunk.data.materialLibrary;
+    }
+
+    data.positions.resize(positionCount);
+    data.texCoords.resize(texCoordCount);
+    data.normals.resize(normalCount);
+    data.corners.resize(cornerCount);
+
+    //////////////////////////////////////////
+    // Fix up the relative indices and copy the
+    // chunks into place, again in parallel.
+    //////////////////////////////////////////
+    parallelFor(chunkCount, [&](const size_t index)
+    {
+        ObjChunk & chunk = chunks[index];
+
+        for (const size_t relativeIndex : chunk.relativeIndices)
+        {
+            ObjIndex & corner = chunk.data.corners[relativeIndex / 3];
+
+            switch (relativeIndex % 3)
+            {
+                case 0: corner.position = offsetIndex(corner.position, chunk.positionBase); break;
+                case 1: corner.texCoord = offsetIndex(corner.texCoord, chunk.texCoordBase); break;
+                case 2: corner.normal   = offsetIndex(corner.normal,   chunk.normalBase);   break;
+            }
+        }
+
+        std::copy(chunk.data.positions.begin(), chunk.data.positions.end(), data.positions.begin() + chunk.positionBase);
+        std::copy(chunk.data.texCoords.begin(), chunk.data.texCoords.end(), data.texCoords.begin() + chunk.texCoordBase);
+        std::copy(chunk.data.normals.begin(),   chunk.data.normals.end(),   data.normals.begin()   + chunk.normalBase);
+        std::copy(chunk.data.corners.begin(),   chunk.data.corners.end(),   data.corners.begin()   + chunk.cornerBase);
+    });
+
+    if (relativeIndices != nullptr)
+    {
+        for (const ObjChunk & chunk : chunks)
+        {
+            for (const size_t relativeIndex : chunk.relativeIndices)
+                relativeIndices->push_back(chunk.cornerBase * 3 + relativeIndex);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////
+bool ObjParser::parseMaterialFile(const std::string & filename, std::vector<ObjMaterial> & materials)
+{
+    LOG("Reading materials: " + filename);
+    MappedFile file(filename);
+
+    if (!file.isOpen())
+        return false;
+
+    parseMaterials(file.getData(), file.getData() + file.getSize(), materials);
+    return true;
+}
+
+//////////////////////////////////////////////////////////////
+void ObjParser::parseMaterials(const char * begin, const char * end, std::vector<ObjMaterial> & materials)
+{
+    const char * p = begin;
+
+    while (p < end)
+    {
+        p = skipBlanks(p, end);
+        if (p == end)
+            break;
+
+        if (matchKeyword(p, end, "newmtl", 6))
+        {
+            materials.push_back(ObjMaterial());
+            p = readRestOfLine(p + 6, end, materials.back().name);
+        }
+        else if (!materials.empty())
+        {
+            ObjMaterial & material = materials.back();
+
+            if (matchKeyword(p, end, "Kd", 2))
+            {
+                p = parseFloat(p + 2, end, material.diffuse.x);
+                p = parseFloat(p, end, material.diffuse.y);
+                p = parseFloat(p, end, material.diffuse.z);
+            }
+            else if (matchKeyword(p, end, "Ks", 2))
+            {
+                p = parseFloat(p + 2, end, material.specular.x);
+                p = parseFloat(p, end, material.specular.y);
+                p = parseFloat(p, end, material.specular.z);
+            }
+            else if (matchKeyword(p, end, "Ns", 2))
+            {
+                p = parseFloat(p + 2, end, material.shininess);
+            }
+            else if (matchKeyword(p, end, "map_Kd", 6))
+            {
+                p = readRestOfLine(p + 6, end, material.diffuseMap);
+            }
+        }
+
+        p = skipLine(p, end);
+    }
+}
+
+} // namespace ce
@@ -0,0 +1,708 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <cstring>
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+#include <unordered_map>
+
+#include "Mesh/ObjStreamConverter.hpp"
+#include "Mesh/ObjParser.hpp"
+#include "Hash.hpp"
+
+namespace ce
+{
+
+////////////////////////////////////////////////////////////////
+// \brief A triangle as it's kept in the temporary files, with
+// indices into the whole file's attributes and the index of its
+// material name (or -1 for none).
+//
+////////////////////////////////////////////////////////////////
+struct ObjStreamTriangle
+{
+    ObjIndex corners[3];
+    int32_t  material;
+};
+
+////////////////////////////////////////////////////////////////
+// \brief The temporary files of one conversion, which are removed
+// again however the conversion ends.
+//
+////////////////////////////////////////////////////////////////
+struct ObjStreamFiles
+{
+    std::string positions;
+    std::string texCoords;
+    std::string normals;
+    std::string triangles;
+    std::string sortedTriangles;
+
+    ObjStreamFiles(const std::string & output)
+        : positions(output + ".positions.tmp"), texCoords(output + ".texcoords.tmp"), normals(output + ".normals.tmp"),
+          triangles(output + ".triangles.tmp"), sortedTriangles(output + ".sorted.tmp")
+    { }
+
+    ~ObjStreamFiles()
+    {
+        remove(positions.c_str());
+        remove(texCoords.c_str());
+        remove(normals.c_str());
+        remove(triangles.c_str());
+        remove(sortedTriangles.c_str());
+    }
+};
+
+////////////////////////////////////////////////////////////////
+// \brief What the first pass learns about the file.
+//
+////////////////////////////////////////////////////////////////
+struct ObjStreamSource
+{
+    size_t                   positionCount;
+    size_t                   texCoordCount;
+    size_t                   normalCount;
+    size_t                   triangleCount;
+    std::vector<std::string> materialNames;
+    std::string              materialLibrary;
+    glm::vec3                boundsMin;
+    glm::vec3                boundsMax;
+    uint64_t                 hash; // Of the whole file, to tell when the chunks are stale
+};
+
+////////////////////////////////////////////////////////////////
+// \brief The grid that the triangles are sorted into.
+//
+////////////////////////////////////////////////////////////////
+struct ObjStreamGrid
+{
+    glm::vec3           origin;
+    glm::vec3           cellSize;
+    size_t              size[3];
+    std::vector<size_t> cellStart; // First sorted triangle of every cell, plus the end
+};
+
+//////////////////////////////////////////////////////////////
+static bool seekFile(FILE * file, const uint64_t offset)
+{
+#ifdef _WIN32
+    return _fseeki64(file, (__int64) offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, (off_t) offset, SEEK_SET) == 0;
+#endif
+}
+
+//////////////////////////////////////////////////////////////
+template <typename T, typename Allocator>
+static bool writeElements(FILE * file, const std::vector<T, Allocator> & elements)
+{
+    return elements.empty() || fwrite(&elements[0], sizeof(T), elements.size(), file) == elements.size();
+}
+
+//////////////////////////////////////////////////////////////
+static bool writeAligned(FILE * file, uint64_t & position, const void * data, const size_t size, uint64_t & offset)
+{
+    static const unsigned char padding[CE_MESHCHUNKS_ALIGNMENT] = { 0 };
+    size_t paddingSize = (size_t)((CE_MESHCHUNKS_ALIGNMENT - position % CE_MESHCHUNKS_ALIGNMENT) % CE_MESHCHUNKS_ALIGNMENT);
+
+    if (fwrite(padding, 1, paddingSize, file) != paddingSize || (size > 0 && fwrite(data, 1, size, file) != size))
+        return false;
+
+    offset = position + paddingSize;
+    position = offset + size;
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////
+static inline int validIndex(const int index, const size_t count)
+{
+    return (index >= 0 && (size_t)index < count) ? index : -1;
+}
+
+//////////////////////////////////////////////////////////////
+// Pass 1: Reads the OBJ file a window at a time and appends
+// what it finds to the temporary files.
+//////////////////////////////////////////////////////////////
+static bool readSource(const std::string & filename, const ObjStreamFiles & files, ObjStreamSource & source)
+{
+    FILE * input     = fopen(filename.c_str(), "rb");
+    FILE * positions = fopen(files.positions.c_str(), "wb");
+    FILE * texCoords = fopen(files.texCoords.c_str(), "wb");
+    FILE * normals   = fopen(files.normals.c_str(), "wb");
+    FILE * triangles = fopen(files.triangles.c_str(), "wb");
+
+    bool success = input != nullptr && positions != nullptr && texCoords != nullptr && normals != nullptr && triangles != nullptr;
+
+    source.positionCount = source.texCoordCount = source.normalCount = source.triangleCount = 0;
+    source.boundsMin = glm::vec3( FLT_MAX);
+    source.boundsMax = glm::vec3(-FLT_MAX);
+
+    std::vector<char> window(CE_OBJSTREAM_WINDOW_SIZE);
+    std::vector<size_t> relativeIndices;
+    std::vector<ObjStreamTriangle> windowTriangles;
+    size_t carried = 0;
+    int32_t material = -1;
+
+    ObjParser parser;
+    ObjData data;
+
+    while (success)
+    {
+        size_t read = fread(&window[carried], 1, window.size() - carried, input);
+        bool last = carried + read < window.size();
+
+        if (last && ferror(input))
+        {
+            success = false;
+            break;
+        }
+
+        //////////////////////////////////////////
+        // Only parse whole lines. The rest of the
+        // last line is carried over to the next
+        // window.
+        //////////////////////////////////////////
+        const char * begin = &window[0];
+        const char * end   = begin + carried + read;
+        const char * lineEnd = end;
+
+        if (!last)
+        {
+            while (lineEnd > begin && lineEnd[-1] != '\n')
+                --lineEnd;
+
+            // A line longer than the window needs a larger window.
+            if (lineEnd == begin)
+            {
+                carried = window.size();
+                window.resize(window.size() * 2);
+                continue;
+            }
+        }
+
+        data = ObjData();
+        relativeIndices.clear();
+        parser.parse(begin, lineEnd, data, &relativeIndices);
+
+        // Negative indices were resolved against this window only.
+        for (const size_t relativeIndex : relativeIndices)
+        {
+            ObjIndex & corner = data.corners[relativeIndex / 3];
+
+            switch (relativeIndex % 3)
+            {
+                case 0: corner.position += (int) source.positionCount; break;
+                case 1: corner.texCoord += (int) source.texCoordCount; break;
+                case 2: corner.normal   += (int) source.normalCount;   break;
+            }
+        }
+
+        //////////////////////////////////////////
+        // Tag every triangle with its material,
+        // which may have been picked in an earlier
+        // window.
+        //////////////////////////////////////////
+        windowTriangles.resize(data.corners.size() / 3);
+        size_t group = 0;
+
+        for (size_t triangle = 0; triangle < windowTriangles.size(); ++triangle)
+        {
+            for (; group < data.materialGroups.size() && data.materialGroups[group].firstTriangle <= triangle; ++group)
+            {
+                const std::string & name = data.materialGroups[group].name;
+                material = (int32_t)(std::find(source.materialNames.begin(), source.materialNames.end(), name) - source.materialNames.begin());
+
+                if ((size_t) material == source.materialNames.size())
+                    source.materialNames.push_back(name);
+            }
+
+            memcpy(windowTriangles[triangle].corners, &data.corners[triangle * 3], sizeof(ObjIndex) * 3);
+            windowTriangles[triangle].material = material;
+        }
+
+        // Groups after the last triangle still apply to the next window.
+        for (; group < data.materialGroups.size(); ++group)
+        {
+            const std::string & name = data.materialGroups[group].name;
+            material = (int32_t)(std::find(source.materialNames.begin(), source.materialNames.end(), name) - source.materialNames.begin());
+
+            if ((size_t) material == source.materialNames.size())
+                source.materialNames.push_back(name);
+        }
+
+        if (source.materialLibrary == "")
+            source.materialLibrary = data.materialLibrary;
+
+        for (const glm::vec3 & position : data.positions)
+        {
+            source.boundsMin = glm::min(source.boundsMin, position);
+            source.boundsMax = glm::max(source.boundsMax, position);
+        }
+
+        success = writeElements(positions, data.positions) && writeElements(texCoords, data.texCoords) &&
+                  writeElements(normals, data.normals) && writeElements(triangles, windowTriangles);
+
+        source.positionCount += data.positions.size();
+        source.texCoordCount += data.texCoords.size();
+        source.normalCount   += data.normals.size();
+        source.triangleCount += windowTriangles.size();
+
+        carried = end - lineEnd;
+        memmove(&window[0], lineEnd, carried);
+
+        if (last)
+            break;
+    }
+
+    if (input != nullptr)
+        fclose(input);
+
+    for (FILE * file : { positions, texCoords, normals, triangles })
+    {
+        if (file != nullptr)
+            success = (fclose(file) == 0) && success;
+    }
+
+    if (source.positionCount == 0)
+        source.boundsMin = source.boundsMax = glm::vec3(0.0f);
+
+    return success;
+}
+
+//////////////////////////////////////////////////////////////
+static size_t getCell(const ObjStreamGrid & grid, const ObjStreamTriangle & triangle, const glm::vec3 * positions, const size_t positionCount)
+{
+    glm::vec3 centroid(0.0f);
+
+    for (const ObjIndex & corner : triangle.corners)
+    {
+        int position = validIndex(corner.position, positionCount);
+
+        if (position >= 0)
+            centroid += positions[position];
+        else
+            centroid += grid.origin;
+    }
+
+    glm::vec3 cell = (centroid / 3.0f - grid.origin) / grid.cellSize;
+    size_t index[3];
+
+    for (int axis = 0; axis < 3; ++axis)
+        index[axis] = (size_t) glm::clamp(cell[axis], 0.0f, (float)(grid.size[axis] - 1));
+
+    return (index[2] * grid.size[1] + index[1]) * grid.size[0] + index[0];
+}
+
+//////////////////////////////////////////////////////////////
+// Pass 2: Sorts the triangles into the cells of a grid, by
+// counting them and then writing every cell's triangles to
+// their place in the sorted file a buffer at a time.
+//////////////////////////////////////////////////////////////
+static bool sortTriangles(const ObjStreamFiles & files, const ObjStreamSource & source, ObjStreamGrid & grid)
+{
+    //////////////////////////////////////////
+    // Make the cells about as deep as they're
+    // wide, with enough of them to hold about
+    // CE_OBJSTREAM_CHUNK_TRIANGLES each. Axes
+    // thinner than a cell get just one, so flat
+    // meshes are split up in two dimensions.
+    //////////////////////////////////////////
+    glm::vec3 extent = glm::max(source.boundsMax - source.boundsMin, glm::vec3(FLT_MIN));
+    double cellCount = std::max<double>(1.0, (double) source.triangleCount / CE_OBJSTREAM_CHUNK_TRIANGLES);
+
+    int axes[3] = { 0, 1, 2 };
+    std::sort(axes, axes + 3, [&](const int left, const int right) { return extent[left] < extent[right]; });
+
+    grid.origin = source.boundsMin;
+
+    for (int count = 0; count < 3; ++count)
+    {
+        double volume = 1.0;
+
+        for (int remaining = count; remaining < 3; ++remaining)
+            volume *= extent[axes[remaining]];
+
+        int axis = axes[count];
+        double cellEdge = pow(volume / cellCount, 1.0 / (3 - count));
+
+        grid.size[axis] = (size_t) std::min(1024.0, std::max(1.0, std::round(extent[axis] / cellEdge)));
+        grid.cellSize[axis] = extent[axis] / grid.size[axis];
+        cellCount = std::max(1.0, cellCount / grid.size[axis]);
+    }
+
+    const size_t cells = grid.size[0] * grid.size[1] * grid.size[2];
+
+    MappedFile positionFile(files.positions, MAPPED_FILE_RANDOM);
+    FILE * input  = fopen(files.triangles.c_str(), "rb");
+    FILE * output = fopen(files.sortedTriangles.c_str(), "wb");
+
+    if (!positionFile.isOpen() || input == nullptr || output == nullptr)
+    {
+        if (input != nullptr)
+            fclose(input);
+
+        if (output != nullptr)
+            fclose(output);
+
+        return false;
+    }
+
+    const glm::vec3 * positions = (const glm::vec3 *) positionFile.getData();
+
+    std::vector<ObjStreamTriangle> buffer(CE_OBJSTREAM_BUFFER_TRIANGLES);
+    std::vector<ObjStreamTriangle> sorted(CE_OBJSTREAM_BUFFER_TRIANGLES);
+    std::vector<uint32_t> bufferCells(CE_OBJSTREAM_BUFFER_TRIANGLES);
+    std::vector<size_t> cellCounts(cells + 1, 0);
+    bool success = true;
+
+    //////////////////////////////////////////
+    // Count the triangles of every cell.
+    //////////////////////////////////////////
+    for (size_t read; (read = fread(&buffer[0], sizeof(ObjStreamTriangle), buffer.size(), input)) > 0; )
+    {
+        for (size_t triangle = 0; triangle < read; ++triangle)
+            ++cellCounts[getCell(grid, buffer[triangle], positions, source.positionCount) + 1];
+    }
+
+    grid.cellStart.resize(cells + 1);
+    grid.cellStart[0] = 0;
+
+    for (size_t cell = 0; cell < cells; ++cell)
+        grid.cellStart[cell + 1] = grid.cellStart[cell] + cellCounts[cell + 1];
+
+    //////////////////////////////////////////
+    // Read the triangles again. Every buffer
+    // is sorted by cell in memory, then each
+    // cell's run is written after the ones of
+    // the earlier buffers.
+    //////////////////////////////////////////
+    std::vector<size_t> cellCursors(grid.cellStart.begin(), grid.cellStart.end() - 1);
+    rewind(input);
+
+    for (size_t read; success && (read = fread(&buffer[0], sizeof(ObjStreamTriangle), buffer.size(), input)) > 0; )
+    {
+        std::fill(cellCounts.begin(), cellCounts.end(), 0);
+
+        for (size_t triangle = 0; triangle < read; ++triangle)
+        {
+            bufferCells[triangle] = (uint32_t) getCell(grid, buffer[triangle], positions, source.positionCount);
+            ++cellCounts[bufferCells[triangle] + 1];
+        }
+
+        for (size_t cell = 0; cell < cells; ++cell)
+            cellCounts[cell + 1] += cellCounts[cell];
+
+        for (size_t triangle = 0; triangle < read; ++triangle)
+            sorted[cellCounts[bufferCells[triangle]]++] = buffer[triangle];
+
+        // After the scatter, cellCounts[cell] is where the cell ends.
+        size_t first = 0;
+
+        for (size_t cell = 0; cell < cells && success; ++cell)
+        {
+            size_t count = cellCounts[cell] - first;
+
+            if (count == 0)
+                continue;
+
+            success = seekFile(output, (uint64_t) cellCursors[cell] * sizeof(ObjStreamTriangle)) &&
+                      fwrite(&sorted[first], sizeof(ObjStreamTriangle), count, output) == count;
+
+            cellCursors[cell] += count;
+            first += count;
+        }
+    }
+
+    success = !ferror(input) && success;
+    fclose(input);
+    success = (fclose(output) == 0) && success;
+
+    return success;
+}
+
+//////////////////////////////////////////////////////////////
+static inline int remapIndex(const int index, const size_t count, std::unordered_map<int, int> & remap)
+{
+    if (validIndex(index, count) < 0)
+        return -1;
+
+    auto inserted = remap.insert(std::make_pair(index, (int) remap.size()));
+    return inserted.first->second;
+}
+
+//////////////////////////////////////////////////////////////
+// Pass 3: Welds the triangles of every cell into a chunk and
+// writes it out.
+//////////////////////////////////////////////////////////////
+static bool writeChunks(const std::string & filename, const ObjStreamFiles & files, const ObjStreamSource & source, const ObjStreamGrid & grid)
+{
+    std::vector<ObjMaterial> materials;
+
+    if (source.materialLibrary != "")
+    {
+        std::size_t endOfPath = filename.find_last_of("/") + 1;
+        ObjParser().parseMaterialFile(filename.substr(0, endOfPath) + source.materialLibrary, materials);
+    }
+
+    FILE * triangleFile = fopen(files.sortedTriangles.c_str(), "rb");
+    MappedFile positionFile(files.positions, MAPPED_FILE_RANDOM);
+    MappedFile texCoordFile(files.texCoords, MAPPED_FILE_RANDOM);
+    MappedFile normalFile(files.normals, MAPPED_FILE_RANDOM);
+
+    std::string chunkFilename = MeshChunkFile::getChunkFilename(filename);
+    std::string tempFilename  = chunkFilename + ".tmp";
+
+    FILE * output = fopen(tempFilename.c_str(), "wb");
+
+    if (triangleFile == nullptr || !positionFile.isOpen() || !texCoordFile.isOpen() || !normalFile.isOpen() || output == nullptr)
+    {
+        LOG("Could not write the chunked mesh: " + chunkFilename);
+
+        if (triangleFile != nullptr)
+            fclose(triangleFile);
+
+        if (output != nullptr)
+            fclose(output);
+
+        remove(tempFilename.c_str());
+        return false;
+    }
+
+    const glm::vec3 * positions = (const glm::vec3 *) positionFile.getData();
+    const glm::vec2 * texCoords = (const glm::vec2 *) texCoordFile.getData();
+    const glm::vec3 * normals   = (const glm::vec3 *) normalFile.getData();
+
+    // The header is written again once the offsets are known.
+    MeshChunkFileHeader header;
+    memset(&header, 0, sizeof(header));
+
+    uint64_t position = 0;
+    uint64_t headerOffset;
+    bool success = writeAligned(output, position, &header, sizeof(header), headerOffset);
+
+    std::vector<MeshChunkInfo> chunks;
+    std::vector<ObjStreamTriangle> piece;
+    std::vector<unsigned char> indexData;
+    std::unordered_map<int, int> positionRemap, texCoordRemap, normalRemap;
+
+    MeshBuilder builder;
+    LinearArena scratch;
+    ObjData obj;
+    MeshData mesh;
+
+    for (size_t cell = 0; cell + 1 < grid.cellStart.size() && success; ++cell)
+    {
+        for (size_t first = grid.cellStart[cell]; first < grid.cellStart[cell + 1] && success; first += CE_OBJSTREAM_MAX_CHUNK_TRIANGLES)
+        {
+            size_t last = std::min<size_t>(first + CE_OBJSTREAM_MAX_CHUNK_TRIANGLES, grid.cellStart[cell + 1]);
+
+            // The cells are stored in order, so the triangles are
+            // read front to back. Triangles without a material come
+            // first, then one group per material.
+            piece.resize(last - first);
+
+            if (fread(&piece[0], sizeof(ObjStreamTriangle), piece.size(), triangleFile) != piece.size())
+            {
+                success = false;
+                break;
+            }
+
+            std::stable_sort(piece.begin(), piece.end(),
+                [](const ObjStreamTriangle & left, const ObjStreamTriangle & right) { return left.material < right.material; });
+
+            //////////////////////////////////////////
+            // Copy the attributes the chunk uses into
+            // a small OBJ of its own and weld it.
+            //////////////////////////////////////////
+            obj = ObjData();
+            positionRemap.clear();
+            texCoordRemap.clear();
+            normalRemap.clear();
+
+            obj.corners.resize(piece.size() * 3);
+
+            for (size_t triangle = 0; triangle < piece.size(); ++triangle)
+            {
+                if (piece[triangle].material >= 0 && (triangle == 0 || piece[triangle - 1].material != piece[triangle].material))
+                {
+                    ObjMaterialGroup group;
+                    group.name = source.materialNames[piece[triangle].material];
+                    group.firstTriangle = triangle;
+                    obj.materialGroups.push_back(group);
+                }
+
+                for (int count = 0; count < 3; ++count)
+                {
+                    const ObjIndex & corner = piece[triangle].corners[count];
+                    ObjIndex & localCorner = obj.corners[triangle * 3 + count];
+
+                    localCorner.position = remapIndex(corner.position, source.positionCount, positionRemap);
+                    localCorner.texCoord = remapIndex(corner.texCoord, source.texCoordCount, texCoordRemap);
+                    localCorner.normal   = remapIndex(corner.normal,   source.normalCount,   normalRemap);
+                }
+            }
+
+            obj.positions.resize(positionRemap.size());
+            obj.texCoords.resize(texCoordRemap.size());
+            obj.normals.resize(normalRemap.size());
+
+            for (const auto & remap : positionRemap)
+                obj.positions[remap.second] = positions[remap.first];
+
+            for (const auto & remap : texCoordRemap)
+                obj.texCoords[remap.second] = texCoords[remap.first];
+
+            for (const auto & remap : normalRemap)
+                obj.normals[remap.second] = normals[remap.first];
+
+            builder.build(obj, materials, mesh, &scratch);
+            scratch.reset();
+
+            MeshBuilder::getIndexData(mesh, indexData);
+
+            std::vector<MeshChunkRange> ranges;
+
+            for (const MeshRange & range : mesh.ranges)
+                ranges.push_back({ range.firstIndex, range.indexCount, range.material });
+
+            MeshChunkInfo chunk;
+            memset(&chunk, 0, sizeof(chunk));
+
+            chunk.vertexCount = (uint32_t) mesh.getVertexCount();
+            chunk.indexCount  = (uint32_t) mesh.indices.size();
+            chunk.indexType   = mesh.getIndexType();
+            chunk.rangeCount  = (uint32_t) ranges.size();
+
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                chunk.boundsMin[axis] = mesh.boundsMin[axis];
+                chunk.boundsMax[axis] = mesh.boundsMax[axis];
+            }
+
+            success = writeAligned(output, position, mesh.getVertexData(), mesh.getVertexDataSize(), chunk.vertexOffset) &&
+                      writeAligned(output, position, indexData.empty() ? nullptr : &indexData[0], indexData.size(), chunk.indexOffset) &&
+                      writeAligned(output, position, ranges.empty() ? nullptr : &ranges[0], ranges.size() * sizeof(MeshChunkRange), chunk.rangeOffset);
+
+            chunks.push_back(chunk);
+        }
+    }
+
+    //////////////////////////////////////////
+    // Finish with the chunk table, the name
+    // of the material library and the header.
+    //////////////////////////////////////////
+    std::vector<unsigned char> materialData;
+    uint32_t length = (uint32_t) source.materialLibrary.size();
+
+    materialData.insert(materialData.end(), (const unsigned char *) &length, (const unsigned char *) &length + sizeof(length));
+    materialData.insert(materialData.end(), source.materialLibrary.begin(), source.materialLibrary.end());
+
+    success = success &&
+              writeAligned(output, position, chunks.empty() ? nullptr : &chunks[0], chunks.size() * sizeof(MeshChunkInfo), header.chunkOffset) &&
+              writeAligned(output, position, &materialData[0], materialData.size(), header.materialOffset);
+
+    header.magic         = CE_MESHCHUNKS_MAGIC;
+    header.version       = CE_MESHCHUNKS_VERSION;
+    header.fileSize      = position;
+    header.sourceHash    = source.hash;
+    header.chunkCount    = (uint32_t) chunks.size();
+    header.triangleCount = (uint32_t) source.triangleCount;
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        header.boundsMin[axis] = source.boundsMin[axis];
+        header.boundsMax[axis] = source.boundsMax[axis];
+    }
+
+    success = success && seekFile(output, headerOffset) && fwrite(&header, sizeof(header), 1, output) == 1;
+    success = (fclose(output) == 0) && success;
+    fclose(triangleFile);
+
+#ifdef _WIN32
+    // rename() won't replace an existing file on Windows.
+    if (success)
+        remove(chunkFilename.c_str());
+#endif
+
+    if (!success || rename(tempFilename.c_str(), chunkFilename.c_str()) != 0)
+    {
+        LOG("Could not write the chunked mesh: " + chunkFilename);
+        remove(tempFilename.c_str());
+        return false;
+    }
+
+    LOG("Wrote " + std::to_string(chunks.size()) + " chunks to " + chunkFilename);
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////
+bool ObjStreamConverter::convert(const std::string & filename)
+{
+    LOG("Converting mesh: " + filename);
+
+    std::string chunkFilename = MeshChunkFile::getChunkFilename(filename);
+    ObjStreamFiles files(chunkFilename);
+    ObjStreamSource source;
+    ObjStreamGrid grid;
+
+    // Hashed before it's read, so that changes made during the
+    // conversion leave the chunks stale rather than seeming current.
+    {
+        MappedFile sourceFile(filename);
+
+        if (!sourceFile.isOpen())
+        {
+            LOG("Could not read the mesh: " + filename);
+            return false;
+        }
+
+        source.hash = hashBytes(sourceFile.getData(), sourceFile.getSize());
+    }
+
+    if (!readSource(filename, files, source))
+    {
+        LOG("Could not read the mesh: " + filename);
+        return false;
+    }
+
+    if (!sortTriangles(files, source, grid))
+    {
+        LOG("Could not sort the triangles of the mesh: " + filename);
+        return false;
+    }
+
+    // The unsorted triangles aren't needed anymore.
+    remove(files.triangles.c_str());
+
+    return writeChunks(filename, files, source, grid);
+}
+
+} // namespace ce
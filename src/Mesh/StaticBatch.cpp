@@ -0,0 +1,306 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+#include "Mesh/StaticBatch.hpp"
+
+#define CE_STATIC_BATCH_UNUSED 0xFFFFFFFF
+
+namespace ce
+{
+
+//////////////////////////////////////////////////////////////
+static inline glm::vec3 transformNormal(const glm::mat4 & normalMatrix, const glm::vec3 & normal)
+{
+    glm::vec3 transformed = glm::vec3(normalMatrix * glm::vec4(normal, 0.0f));
+    float length = glm::length(transformed);
+
+    return length > 0.0f ? transformed / length : normal;
+}
+
+//////////////////////////////////////////////////////////////
+StaticBatchBuilder::StaticBatchBuilder(const float cellSize)
+    : m_cellSize(cellSize)
+{ }
+
+//////////////////////////////////////////////////////////////
+void StaticBatchBuilder::addVoxel(const glm::vec3 & tl, const glm::vec3 & size, const glm::vec3 & color, const glm::mat4 & model)
+{
+    //////////////////////////////////////////
+    // The corners of every side, picking the
+    // near (0) or far (1) edge of the voxel on
+    // each axis, as laid out by createVoxel.
+    //////////////////////////////////////////
+    static const int sides[6][4][3] = {
+        { { 0, 0, 1 }, { 0, 1, 1 }, { 1, 1, 1 }, { 1, 0, 1 } }, // Back
+        { { 0, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 }, { 1, 0, 0 } }, // Front
+        { { 0, 0, 0 }, { 0, 1, 0 }, { 0, 1, 1 }, { 0, 0, 1 } }, // Left
+        { { 1, 0, 0 }, { 1, 1, 0 }, { 1, 1, 1 }, { 1, 0, 1 } }, // Right
+        { { 0, 0, 0 }, { 0, 0, 1 }, { 1, 0, 1 }, { 1, 0, 0 } }, // Top
+        { { 0, 1, 0 }, { 0, 1, 1 }, { 1, 1, 1 }, { 1, 1, 0 } }  // Bottom
+    };
+
+    static const float normals[6][3] = {
+        { 0.0f, 0.0f, -1.0f }, { 0.0f, 0.0f, 1.0f }, { -1.0f, 0.0f, 0.0f },
+        { 1.0f, 0.0f, 0.0f },  { 0.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f }
+    };
+
+    const glm::vec3 edges[2] = { tl, glm::vec3(tl.x + size.x, tl.y - size.y, tl.z - size.z) };
+
+    GLfloat vertices[24 * CE_STATIC_BATCH_COLORED_SIZE];
+    GLuint indices[36];
+
+    for (int side = 0; side < 6; ++side)
+    {
+        for (int corner = 0; corner < 4; ++corner)
+        {
+            GLfloat * vertex = &vertices[(side * 4 + corner) * CE_STATIC_BATCH_COLORED_SIZE];
+
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                vertex[axis]     = edges[sides[side][corner][axis]][axis];
+                vertex[axis + 3] = color[axis];
+                vertex[axis + 6] = normals[side][axis];
+            }
+        }
+
+        const GLuint corners[6] = { 0, 1, 2, 3, 0, 2 };
+
+        for (int index = 0; index < 6; ++index)
+            indices[side * 6 + index] = side * 4 + corners[index];
+    }
+
+    addColoredGeometry(vertices, 24, indices, 36, model);
+}
+
+//////////////////////////////////////////////////////////////
+void StaticBatchBuilder::addRect(const glm::vec2 & tl, const glm::vec2 & br, const glm::vec3 & color, const glm::mat4 & model)
+{
+    const GLfloat vertices[] = {
+        tl.x, br.y, 0.0f, color.r, color.g, color.b, 0.0f, 0.0f, 1.0f, // BL
+        br.x, br.y, 0.0f, color.r, color.g, color.b, 0.0f, 0.0f, 1.0f, // BR
+        br.x, tl.y, 0.0f, color.r, color.g, color.b, 0.0f, 0.0f, 1.0f, // TR
+        tl.x, tl.y, 0.0f, color.r, color.g, color.b, 0.0f, 0.0f, 1.0f  // TL
+    };
+
+    const GLuint indices[] = { 0, 1, 2, 0, 2, 3 };
+
+    addColoredGeometry(vertices, 4, indices, 6, model);
+}
+
+//////////////////////////////////////////////////////////////
+void StaticBatchBuilder::addColoredGeometry(const GLfloat * vertices, const size_t & vertexCount, const GLuint * indices, const size_t & indexCount, const glm::mat4 & model)
+{
+    glm::mat4 normalMatrix = glm::transpose(glm::inverse(model));
+    glm::vec3 boundsMin( FLT_MAX);
+    glm::vec3 boundsMax(-FLT_MAX);
+
+    std::vector<GLfloat> transformed(vertices, vertices + vertexCount * CE_STATIC_BATCH_COLORED_SIZE);
+
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        GLfloat * target = &transformed[vertex * CE_STATIC_BATCH_COLORED_SIZE];
+        glm::vec3 position = glm::vec3(model * glm::vec4(target[0], target[1], target[2], 1.0f));
+        glm::vec3 normal = transformNormal(normalMatrix, glm::vec3(target[6], target[7], target[8]));
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            target[axis]     = position[axis];
+            target[axis + 6] = normal[axis];
+        }
+
+        boundsMin = glm::min(boundsMin, position);
+        boundsMax = glm::max(boundsMax, position);
+    }
+
+    StaticBatchData & batch = getBatch(STATIC_BATCH_COLORED, -1, (boundsMin + boundsMax) * 0.5f);
+    GLuint firstVertex = (GLuint)(batch.vertices.size() / CE_STATIC_BATCH_COLORED_SIZE);
+
+    batch.vertices.insert(batch.vertices.end(), transformed.begin(), transformed.end());
+
+    for (size_t index = 0; index < indexCount; ++index)
+        batch.indices.push_back(firstVertex + indices[index]);
+
+    batch.boundsMin = glm::min(batch.boundsMin, boundsMin);
+    batch.boundsMax = glm::max(batch.boundsMax, boundsMax);
+}
+
+//////////////////////////////////////////////////////////////
+bool StaticBatchBuilder::addMesh(const std::string & filename, const glm::mat4 & model, const unsigned int flags)
+{
+    const SourceMesh * source = getSourceMesh(filename, flags);
+
+    if (source == nullptr)
+        return false;
+
+    const MeshLoadData & data = source->data;
+    const GLfloat * vertices = (const GLfloat *) data.vertexData;
+    size_t vertexCount = data.vertexDataSize / (CE_STATIC_BATCH_TEXTURED_SIZE * sizeof(GLfloat));
+
+    glm::mat4 normalMatrix = glm::transpose(glm::inverse(model));
+    glm::vec3 center = glm::vec3(model * glm::vec4((data.mesh.boundsMin + data.mesh.boundsMax) * 0.5f, 1.0f));
+
+    // Where the mesh's vertices ended up in each of the batches
+    // that its ranges went to.
+    std::map<size_t, std::vector<GLuint>> remaps;
+
+    for (const MeshRange & range : data.ranges)
+    {
+        int image = (range.material >= 0 && (size_t) range.material < source->materialImages.size()) ? source->materialImages[range.material] : -1;
+        StaticBatchData & batch = getBatch(STATIC_BATCH_TEXTURED, image, center);
+        std::vector<GLuint> & remap = remaps[&batch - &m_batches[0]];
+
+        if (remap.empty())
+            remap.assign(vertexCount, CE_STATIC_BATCH_UNUSED);
+
+        for (GLuint index = range.firstIndex; index < range.firstIndex + range.indexCount; ++index)
+        {
+            GLuint vertex = data.mesh.indexType == GL_UNSIGNED_SHORT ? ((const GLushort *) data.indexData)[index]
+                                                                     : ((const GLuint *) data.indexData)[index];
+
+            if (remap[vertex] == CE_STATIC_BATCH_UNUSED)
+            {
+                const GLfloat * original = &vertices[vertex * CE_STATIC_BATCH_TEXTURED_SIZE];
+                glm::vec3 position = glm::vec3(model * glm::vec4(original[0], original[1], original[2], 1.0f));
+                glm::vec3 normal = transformNormal(normalMatrix, glm::vec3(original[5], original[6], original[7]));
+
+                remap[vertex] = (GLuint)(batch.vertices.size() / CE_STATIC_BATCH_TEXTURED_SIZE);
+
+                const GLfloat transformed[CE_STATIC_BATCH_TEXTURED_SIZE] = {
+                    position.x, position.y, position.z, original[3], original[4], normal.x, normal.y, normal.z
+                };
+
+                batch.vertices.insert(batch.vertices.end(), transformed, transformed + CE_STATIC_BATCH_TEXTURED_SIZE);
+                batch.boundsMin = glm::min(batch.boundsMin, position);
+                batch.boundsMax = glm::max(batch.boundsMax, position);
+            }
+
+            batch.indices.push_back(remap[vertex]);
+        }
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////
+StaticBatchData & StaticBatchBuilder::getBatch(const StaticBatchLayout & layout, const int & image, const glm::vec3 & center)
+{
+    int cell[3] = { 0, 0, 0 };
+
+    if (m_cellSize > 0.0f)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+            cell[axis] = (int) std::floor(center[axis] / m_cellSize);
+    }
+
+    auto key = std::make_tuple((int) layout, image, cell[0], cell[1], cell[2]);
+    auto found = m_batchIndices.find(key);
+
+    if (found != m_batchIndices.end())
+        return m_batches[found->second];
+
+    m_batchIndices[key] = m_batches.size();
+    m_batches.push_back(StaticBatchData());
+
+    StaticBatchData & batch = m_batches.back();
+    batch.layout    = layout;
+    batch.image     = image;
+    batch.boundsMin = glm::vec3( FLT_MAX);
+    batch.boundsMax = glm::vec3(-FLT_MAX);
+
+    return batch;
+}
+
+//////////////////////////////////////////////////////////////
+const StaticBatchBuilder::SourceMesh * StaticBatchBuilder::getSourceMesh(const std::string & filename, const unsigned int flags)
+{
+    // Batches are pre-transformed, so the vertices have to stay
+    // full floats, and nothing else than reordering applies.
+    unsigned int sourceFlags = flags & MESH_LOAD_OPTIMIZE;
+
+    for (const std::unique_ptr<SourceMesh> & mesh : m_meshes)
+    {
+        if (mesh->filename == filename && mesh->flags == sourceFlags)
+            return mesh.get();
+    }
+
+    std::unique_ptr<SourceMesh> mesh(new SourceMesh());
+    mesh->filename = filename;
+    mesh->flags    = sourceFlags;
+
+    bool loaded = MeshLoader::load(filename, sourceFlags, mesh->data, &m_scratch);
+    m_scratch.reset();
+
+    if (!loaded || mesh->data.gltf || mesh->data.vertexData == nullptr)
+    {
+        LOG("Could not batch the mesh: " + filename);
+        return nullptr;
+    }
+
+    //////////////////////////////////////////
+    // Hand the mesh's images over to the
+    // builder, where meshes share the ones
+    // with the same content.
+    //////////////////////////////////////////
+    MeshLoadData & data = mesh->data;
+    std::vector<int> sharedImages(data.images.size(), -1);
+
+    for (size_t image = 0; image < data.images.size(); ++image)
+    {
+        if (data.images[image].getImageBuffer().empty())
+            continue;
+
+        size_t shared = std::find(m_imageHashes.begin(), m_imageHashes.end(), data.imageHashes[image]) - m_imageHashes.begin();
+
+        if (shared == m_imageHashes.size())
+        {
+            m_images.push_back(std::move(data.images[image]));
+            m_imageHashes.push_back(data.imageHashes[image]);
+        }
+
+        sharedImages[image] = (int) shared;
+    }
+
+    mesh->materialImages.assign(data.materialImages.size(), -1);
+
+    for (size_t material = 0; material < data.materialImages.size(); ++material)
+    {
+        if (data.materialImages[material] >= 0)
+            mesh->materialImages[material] = sharedImages[data.materialImages[material]];
+    }
+
+    data.images.clear();
+
+    m_meshes.push_back(std::move(mesh));
+
+    return m_meshes.back().get();
+}
+
+} // namespace ce
@@ -0,0 +1,204 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+
+#include "Mesh/TextureConverter.hpp"
+#include "Mesh/ObjParser.hpp"
+#include "MappedFile.hpp"
+#include "Hash.hpp"
+#include "picoPNG.hpp"
+#include "Qoi.hpp"
+
+namespace ce
+{
+
+//////////////////////////////////////////////////////////////
+bool TextureConverter::convert(const std::string & filename)
+{
+    ObjParser parser;
+    ObjData obj;
+
+    if (!parser.parseFile(filename, obj))
+        return false;
+
+    if (obj.materialLibrary == "")
+        return true;
+
+    std::size_t endOfPath = filename.find_last_of("/") + 1;
+    std::string pathToModel = filename.substr(0, endOfPath);
+    std::vector<ObjMaterial> materials;
+
+    if (!parser.parseMaterialFile(pathToModel + obj.materialLibrary, materials))
+        return false;
+
+    // Materials that share a diffuse map only convert it once.
+    std::vector<std::string> imageFiles;
+    bool success = true;
+
+    for (const ObjMaterial & material : materials)
+    {
+        if (material.diffuseMap == "")
+            continue;
+
+        std::string imageFile = pathToModel + material.diffuseMap;
+
+        if (std::find(imageFiles.begin(), imageFiles.end(), imageFile) != imageFiles.end())
+            continue;
+
+        imageFiles.push_back(imageFile);
+        success = convertImage(imageFile) && success;
+    }
+
+    return success;
+}
+
+//////////////////////////////////////////////////////////////
+bool TextureConverter::hasCurrentQoi(const std::string & filename)
+{
+    std::string qoiFilename = getQoiFilename(filename);
+
+    // Most textures are never converted, so look for the QOI file
+    // quietly. Without its PNG, it's the only copy left to use.
+    if (!std::ifstream(qoiFilename).good())
+        return false;
+
+    if (!std::ifstream(filename).good())
+        return true;
+
+    uint64_t sourceHash = 0;
+    std::ifstream hashFile(qoiFilename + CE_TEXTURE_HASH_EXTENSION, std::ios::binary);
+
+    MappedFile source(filename);
+
+    if (!hashFile.read((char *) &sourceHash, sizeof(sourceHash)) || !source.isOpen() ||
+        hashBytes(source.getData(), source.getSize()) != sourceHash)
+    {
+        LOG("The PNG changed since it was converted, convert the model again: " + qoiFilename);
+        return false;
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////
+std::string TextureConverter::getQoiFilename(const std::string & filename)
+{
+    // The extension is kept, so that "foo.png" and "foo.jpg" next
+    // to each other don't share a QOI file.
+    return filename + ".qoi";
+}
+
+//////////////////////////////////////////////////////////////
+bool TextureConverter::convertImage(const std::string & filename)
+{
+    LOG("Converting image: " + filename);
+    MappedFile file(filename);
+
+    if (!file.isOpen())
+        return false;
+
+    const unsigned char * data = (const unsigned char *) file.getData();
+
+    // Materials that already point at a QOI file are left alone.
+    if (isQoi(data, file.getSize()))
+        return true;
+
+    std::vector<unsigned char> pixels;
+    unsigned long width = 0;
+    unsigned long height = 0;
+
+    int error = decodePNG(pixels, width, height, data, file.getSize());
+
+    if (error != 0)
+    {
+        LOG("Error occurred while decoding the PNG. (error: " + std::to_string(error) + ")");
+        return false;
+    }
+
+    std::vector<unsigned char> qoi;
+    encodeQoi(&pixels[0], width, height, qoi);
+
+    //////////////////////////////////////////
+    // The hash of the PNG is written after
+    // the QOI file, so that a conversion
+    // that stops halfway leaves a hash that
+    // doesn't match, rather than a QOI file
+    // that seems current.
+    //////////////////////////////////////////
+    std::string qoiFilename = getQoiFilename(filename);
+    uint64_t sourceHash = hashBytes(data, file.getSize());
+
+    if (!writeFile(qoiFilename, &qoi[0], qoi.size()) ||
+        !writeFile(qoiFilename + CE_TEXTURE_HASH_EXTENSION, &sourceHash, sizeof(sourceHash)))
+        return false;
+
+    LOG("Wrote " + std::to_string(qoi.size()) + " bytes to " + qoiFilename + " ("
+                 + std::to_string(file.getSize()) + " as PNG)");
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////
+bool TextureConverter::writeFile(const std::string & filename, const void * data, const size_t size)
+{
+    // The file is written under a temporary name and renamed over
+    // the old one, so a loader never finds half of a file.
+    std::string tempFilename = filename + ".tmp";
+
+    FILE * output = fopen(tempFilename.c_str(), "wb");
+
+    if (output == nullptr)
+    {
+        LOG("Could not write the file: " + filename);
+        return false;
+    }
+
+    bool written = fwrite(data, 1, size, output) == size;
+    written = (fclose(output) == 0) && written;
+
+#ifdef _WIN32
+    // rename() won't replace an existing file on Windows.
+    if (written)
+        remove(filename.c_str());
+#endif
+
+    if (!written || rename(tempFilename.c_str(), filename.c_str()) != 0)
+    {
+        LOG("Could not write the file: " + filename);
+        remove(tempFilename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace ce
@@ -0,0 +1,259 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstring>
+
+#include "Qoi.hpp"
+
+#define CE_QOI_OP_INDEX 0x00 // 00xxxxxx
+#define CE_QOI_OP_DIFF  0x40 // 01xxxxxx
+#define CE_QOI_OP_LUMA  0x80 // 10xxxxxx
+#define CE_QOI_OP_RUN   0xC0 // 11xxxxxx
+#define CE_QOI_OP_RGB   0xFE // 11111110
+#define CE_QOI_OP_RGBA  0xFF // 11111111
+#define CE_QOI_MASK     0xC0
+
+namespace ce
+{
+
+//////////////////////////////////////////////////////////////
+static unsigned int readBigEndian(const unsigned char * data)
+{
+    return ((unsigned int) data[0] << 24) | ((unsigned int) data[1] << 16) | ((unsigned int) data[2] << 8) | data[3];
+}
+
+//////////////////////////////////////////////////////////////
+static void writeBigEndian(std::vector<unsigned char> & data, const unsigned int value)
+{
+    data.push_back((unsigned char)(value >> 24));
+    data.push_back((unsigned char)(value >> 16));
+    data.push_back((unsigned char)(value >> 8));
+    data.push_back((unsigned char) value);
+}
+
+//////////////////////////////////////////////////////////////
+// Where a pixel goes in the table of recently seen pixels.
+//////////////////////////////////////////////////////////////
+static unsigned int getIndexPosition(const unsigned char * pixel)
+{
+    return (pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) % 64;
+}
+
+//////////////////////////////////////////////////////////////
+bool isQoi(const unsigned char * data, const size_t & size)
+{
+    return size >= 4 && data[0] == 'q' && data[1] == 'o' && data[2] == 'i' && data[3] == 'f';
+}
+
+//////////////////////////////////////////////////////////////
+bool readQoiSize(const unsigned char * data, const size_t & size, unsigned long & width, unsigned long & height)
+{
+    if (size < CE_QOI_HEADER_SIZE + CE_QOI_END_SIZE || !isQoi(data, size))
+        return false;
+
+    width  = readBigEndian(data + 4);
+    height = readBigEndian(data + 8);
+
+    const unsigned char channels   = data[12];
+    const unsigned char colorspace = data[13];
+
+    return width > 0 && height > 0 && height < CE_QOI_MAX_PIXELS / width &&
+           (channels == 3 || channels == 4) && colorspace <= 1;
+}
+
+//////////////////////////////////////////////////////////////
+bool decodeQoi(const unsigned char * data, const size_t & size, unsigned char * pixels, const size_t & pixelsSize)
+{
+    unsigned long width  = 0;
+    unsigned long height = 0;
+
+    if (!readQoiSize(data, size, width, height) || pixelsSize < 4 * (size_t) width * height)
+        return false;
+
+    unsigned char index[64 * 4] = { 0 };
+    unsigned char pixel[4]      = { 0, 0, 0, 255 };
+
+    const size_t   pixelCount = (size_t) width * height;
+    const unsigned char * p   = data + CE_QOI_HEADER_SIZE;
+    const unsigned char * end = data + size - CE_QOI_END_SIZE;
+
+    // Every op but the run makes one pixel, and every pixel is
+    // remembered in the index as it is written out.
+    for (size_t written = 0; written < pixelCount; )
+    {
+        if (p >= end)
+            return false;
+
+        const unsigned char op = *p++;
+        size_t run = 1;
+
+        if (op == CE_QOI_OP_RGB || op == CE_QOI_OP_RGBA)
+        {
+            const size_t length = op == CE_QOI_OP_RGB ? 3 : 4;
+
+            if ((size_t)(end - p) < length)
+                return false;
+
+            memcpy(pixel, p, length);
+            p += length;
+        }
+        else if ((op & CE_QOI_MASK) == CE_QOI_OP_INDEX)
+            memcpy(pixel, index + 4 * op, 4);
+        else if ((op & CE_QOI_MASK) == CE_QOI_OP_DIFF)
+        {
+            pixel[0] += ((op >> 4) & 3) - 2;
+            pixel[1] += ((op >> 2) & 3) - 2;
+            pixel[2] += ( op       & 3) - 2;
+        }
+        else if ((op & CE_QOI_MASK) == CE_QOI_OP_LUMA)
+        {
+            if (p >= end)
+                return false;
+
+            const int greenDifference = (op & 0x3F) - 32;
+            const unsigned char redBlue = *p++;
+
+            pixel[0] += greenDifference - 8 + ((redBlue >> 4) & 0x0F);
+            pixel[1] += greenDifference;
+            pixel[2] += greenDifference - 8 + (redBlue & 0x0F);
+        }
+        else
+            run = std::min<size_t>((op & 0x3F) + 1, pixelCount - written);
+
+        memcpy(index + 4 * getIndexPosition(pixel), pixel, 4);
+
+        for (size_t i = 0; i < run; ++i)
+            memcpy(pixels + 4 * (written + i), pixel, 4);
+
+        written += run;
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////
+bool decodeQoi(const unsigned char * data, const size_t & size, std::vector<unsigned char> & pixels, unsigned long & width, unsigned long & height)
+{
+    if (!readQoiSize(data, size, width, height))
+        return false;
+
+    pixels.resize(4 * (size_t) width * height);
+
+    return decodeQoi(data, size, &pixels[0], pixels.size());
+}
+
+//////////////////////////////////////////////////////////////
+void encodeQoi(const unsigned char * pixels, const unsigned long & width, const unsigned long & height, std::vector<unsigned char> & data)
+{
+    const size_t pixelCount = (size_t) width * height;
+
+    data.clear();
+    data.reserve(CE_QOI_HEADER_SIZE + pixelCount + CE_QOI_END_SIZE);
+
+    data.push_back('q');
+    data.push_back('o');
+    data.push_back('i');
+    data.push_back('f');
+    writeBigEndian(data, (unsigned int) width);
+    writeBigEndian(data, (unsigned int) height);
+    data.push_back(4); // RGBA
+    data.push_back(0); // sRGB with linear alpha
+
+    unsigned char index[64 * 4]  = { 0 };
+    unsigned char previous[4]    = { 0, 0, 0, 255 };
+    unsigned int run = 0;
+
+    for (size_t i = 0; i < pixelCount; ++i)
+    {
+        const unsigned char * pixel = pixels + 4 * i;
+
+        if (memcmp(pixel, previous, 4) == 0)
+        {
+            ++run;
+
+            if (run == 62 || i + 1 == pixelCount)
+            {
+                data.push_back((unsigned char)(CE_QOI_OP_RUN | (run - 1)));
+                run = 0;
+            }
+
+            continue;
+        }
+
+        if (run > 0)
+        {
+            data.push_back((unsigned char)(CE_QOI_OP_RUN | (run - 1)));
+            run = 0;
+        }
+
+        const unsigned int position = getIndexPosition(pixel);
+
+        if (memcmp(index + 4 * position, pixel, 4) == 0)
+            data.push_back((unsigned char)(CE_QOI_OP_INDEX | position));
+        else
+        {
+            memcpy(index + 4 * position, pixel, 4);
+
+            if (pixel[3] == previous[3])
+            {
+                // The differences wrap around like the decoder's sums do.
+                const signed char red   = (signed char)(pixel[0] - previous[0]);
+                const signed char green = (signed char)(pixel[1] - previous[1]);
+                const signed char blue  = (signed char)(pixel[2] - previous[2]);
+
+                const int redGreen  = red  - green;
+                const int blueGreen = blue - green;
+
+                if (red >= -2 && red <= 1 && green >= -2 && green <= 1 && blue >= -2 && blue <= 1)
+                    data.push_back((unsigned char)(CE_QOI_OP_DIFF | ((red + 2) << 4) | ((green + 2) << 2) | (blue + 2)));
+                else if (green >= -32 && green <= 31 && redGreen >= -8 && redGreen <= 7 && blueGreen >= -8 && blueGreen <= 7)
+                {
+                    data.push_back((unsigned char)(CE_QOI_OP_LUMA | (green + 32)));
+                    data.push_back((unsigned char)(((redGreen + 8) << 4) | (blueGreen + 8)));
+                }
+                else
+                {
+                    data.push_back(CE_QOI_OP_RGB);
+                    data.insert(data.end(), pixel, pixel + 3);
+                }
+            }
+            else
+            {
+                data.push_back(CE_QOI_OP_RGBA);
+                data.insert(data.end(), pixel, pixel + 4);
+            }
+        }
+
+        memcpy(previous, pixel, 4);
+    }
+
+    data.insert(data.end(), 7, 0);
+    data.push_back(1);
+}
+
+} // namespace ce
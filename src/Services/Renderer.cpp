@@ -25,6 +25,10 @@
 //
 ////////////////////////////////////////////////////////////////
 
+#include <cfloat>
+#include <algorithm>
+#include <utility>
+
 #include "Services/Renderer.hpp"
 
 ce::IRenderer *  ce::RendererLocator::m_service = nullptr;
@@ -34,8 +38,10 @@ namespace ce
 {
 
 //////////////////////////////////////////////////////////////
-Renderer::Renderer() : m_vertexAttributeCount(0)
-{ }
+Renderer::Renderer() : m_assets(std::make_shared<Assets>()), m_impostorVAO(0), m_impostorVBO(0), m_vertexAttributeCount(0)
+{
+    m_assets->renderer = this;
+}
 
 //////////////////////////////////////////////////////////////
 Renderer::~Renderer()
@@ -55,11 +61,15 @@ Renderer::~Renderer()
     for (GLuint & renderBuffer : m_renderBufferList)
         glDeleteRenderbuffers(1, &renderBuffer);
 
+    for (GLuint & program : m_programList)
+        glDeleteProgram(program);
+
     m_vaoList.clear();
     m_vboList.clear();
     m_textureList.clear();
     m_frameBufferList.clear();
     m_renderBufferList.clear();
+    m_programList.clear();
 }
 
 //////////////////////////////////////////////////////////////
@@ -82,6 +92,18 @@ GLuint Renderer::generateVBO()
     return vbo;
 }
 
+//////////////////////////////////////////////////////////////
+GLuint Renderer::generateEBO()
+{
+    // Element buffers are plain buffer objects, so they are
+    // tracked (and deleted) along with the vertex buffers.
+    GLuint ebo;
+    glGenBuffers(1, &ebo);
+    m_vboList.push_back(ebo);
+
+    return ebo;
+}
+
 //////////////////////////////////////////////////////////////
 GLuint Renderer::generateTexture()
 {
@@ -127,6 +149,15 @@ void Renderer::bindArrayBuffer(const GLuint & vbo, const unsigned int & vertexDa
     m_vertexAttributeCount = 0;
 }
 
+//////////////////////////////////////////////////////////////
+void Renderer::bindElementBuffer(const GLuint & ebo, const unsigned int & indexDataSize, const GLvoid * data, const bool & staticDraw)
+{
+    // The element buffer binding is part of the VAO state, so the
+    // VAO that should use it must be bound before calling this.
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexDataSize, data, staticDraw ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
+}
+
 //////////////////////////////////////////////////////////////
 void Renderer::bindTexture(const GLuint & texture)
 {
@@ -146,9 +177,17 @@ void Renderer::bindRenderBuffer(const GLuint & renderBuffer)
 }
 
 //////////////////////////////////////////////////////////////
-void Renderer::addVertexAttribute(const GLint & size, const bool & normalize, const int & stride, const int & offset)
+void Renderer::addVertexAttribute(const GLint & size, const bool & normalize, const int & stride, const int & offset, const GLenum & type)
 {
-    glVertexAttribPointer(m_vertexAttributeCount, size, GL_FLOAT, normalize ? GL_TRUE : GL_FALSE, stride, (GLvoid *)offset);
+    glVertexAttribPointer(m_vertexAttributeCount, size, type, normalize ? GL_TRUE : GL_FALSE, stride, (GLvoid *)(uintptr_t) offset);
+    glEnableVertexAttribArray(m_vertexAttributeCount);
+    ++m_vertexAttributeCount;
+}
+
+//////////////////////////////////////////////////////////////
+void Renderer::addIntegerVertexAttribute(const GLint & size, const GLenum & type, const int & stride, const int & offset)
+{
+    glVertexAttribIPointer(m_vertexAttributeCount, size, type, stride, (GLvoid *)(uintptr_t) offset);
     glEnableVertexAttribArray(m_vertexAttributeCount);
     ++m_vertexAttributeCount;
 }
@@ -197,10 +236,10 @@ void Renderer::setActiveTexture(const GLuint & textureHandle, const GLenum & tex
 }
 
 //////////////////////////////////////////////////////////////
-void Renderer::setTextureSampler(const GLuint & shaderProgram, const char * uniformName)
+void Renderer::setTextureSampler(const GLuint & shaderProgram, const char * uniformName, const GLint & textureUnit)
 {
     GLint uniformLocation = glGetUniformLocation(shaderProgram, uniformName);
-    glUniform1i(uniformLocation, 0);
+    glUniform1i(uniformLocation, textureUnit);
 }
 
 //////////////////////////////////////////////////////////////
@@ -231,6 +270,231 @@ void Renderer::drawArraysTriangleFan(const GLuint & vao, const int & first, cons
     glBindVertexArray(0);
 }
 
+//////////////////////////////////////////////////////////////
+void Renderer::drawElements(const GLuint & vao, const int & count, const GLenum & indexType, const size_t & offset)
+{
+    glBindVertexArray(vao);
+    glDrawElements(GL_TRIANGLES, count, indexType, (GLvoid *)offset);
+    glBindVertexArray(0);
+}
+
+//////////////////////////////////////////////////////////////
+void Renderer::drawMesh(const Mesh & mesh, const size_t & lod)
+{
+    if (mesh.vao == 0)
+        return;
+
+    // The submeshes are sorted by texture, so each texture is only
+    // bound when it changes.
+    GLuint boundTexture = 0;
+    GLuint boundVAO = mesh.vao;
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, boundTexture);
+    glBindVertexArray(boundVAO);
+
+    for (const Submesh & submesh : mesh.getSubmeshes(lod))
+    {
+        if (submesh.texture != boundTexture)
+        {
+            boundTexture = submesh.texture;
+            glBindTexture(GL_TEXTURE_2D, boundTexture);
+        }
+
+        if (submesh.vao != boundVAO)
+        {
+            boundVAO = submesh.vao;
+            glBindVertexArray(boundVAO);
+        }
+
+        glDrawElements(GL_TRIANGLES, submesh.indexCount, submesh.indexType, (GLvoid *)(submesh.firstIndex * submesh.getIndexSize()));
+    }
+
+    glBindVertexArray(0);
+}
+
+//////////////////////////////////////////////////////////////
+void Renderer::drawMeshList(const Mesh & mesh, const MeshDrawList & drawList)
+{
+    if (mesh.vao == 0)
+        return;
+
+    glActiveTexture(GL_TEXTURE0);
+
+    for (const MeshDrawBatch & batch : drawList.batches)
+    {
+        glBindVertexArray(batch.vao);
+        glBindTexture(GL_TEXTURE_2D, batch.texture);
+        glMultiDrawElements(GL_TRIANGLES, &drawList.counts[batch.first], batch.indexType, &drawList.offsets[batch.first], (GLsizei) batch.count);
+    }
+
+    glBindVertexArray(0);
+}
+
+//////////////////////////////////////////////////////////////
+void Renderer::drawMeshDepth(const Mesh & mesh, const size_t & lod)
+{
+    if (mesh.vao == 0)
+        return;
+
+    const std::vector<Submesh> & submeshes = mesh.getSubmeshes(lod);
+
+    // Without a position stream, the submeshes' own vertex arrays
+    // are used. Their positions are at the same location.
+    if (mesh.depthVao == 0)
+    {
+        for (const Submesh & submesh : submeshes)
+            drawElements(submesh.vao, submesh.indexCount, submesh.indexType, submesh.firstIndex * submesh.getIndexSize());
+
+        return;
+    }
+
+    //////////////////////////////////////////
+    // Textures don't matter for depth, so the
+    // submeshes are drawn in index order, with
+    // neighbouring ones merged.
+    //////////////////////////////////////////
+    std::vector<std::pair<GLuint, GLuint>> runs;
+    runs.reserve(submeshes.size());
+
+    for (const Submesh & submesh : submeshes)
+        runs.push_back(std::make_pair(submesh.firstIndex, submesh.indexCount));
+
+    std::sort(runs.begin(), runs.end());
+
+    glBindVertexArray(mesh.depthVao);
+
+    for (size_t run = 0; run < runs.size();)
+    {
+        GLuint first = runs[run].first;
+        GLuint last  = first + runs[run].second;
+
+        for (++run; run < runs.size() && runs[run].first == last; ++run)
+            last += runs[run].second;
+
+        glDrawElements(GL_TRIANGLES, last - first, mesh.indexType, (GLvoid *)(first * mesh.getIndexSize()));
+    }
+
+    glBindVertexArray(0);
+}
+
+//////////////////////////////////////////////////////////////
+void Renderer::drawMeshListDepth(const Mesh & mesh, const MeshDrawList & drawList)
+{
+    if (mesh.vao == 0)
+        return;
+
+    if (mesh.depthVao == 0)
+    {
+        for (const MeshDrawBatch & batch : drawList.batches)
+        {
+            glBindVertexArray(batch.vao);
+            glMultiDrawElements(GL_TRIANGLES, &drawList.counts[batch.first], batch.indexType, &drawList.offsets[batch.first], (GLsizei) batch.count);
+        }
+    }
+    else if (!drawList.counts.empty())
+    {
+        // All of the batches share the position stream.
+        glBindVertexArray(mesh.depthVao);
+        glMultiDrawElements(GL_TRIANGLES, &drawList.counts[0], mesh.indexType, &drawList.offsets[0], (GLsizei) drawList.counts.size());
+    }
+
+    glBindVertexArray(0);
+}
+
+//////////////////////////////////////////////////////////////
+void Renderer::drawStaticBatches(const std::vector<StaticBatch> & batches, const StaticBatchLayout & layout, const glm::mat4 & view, const glm::mat4 & projection)
+{
+    // The batches are in world space, so their bounds are tested
+    // against the view frustum as they are.
+    glm::vec4 planes[6];
+    MeshletCuller::getFrustumPlanes(projection * view, planes);
+
+    // Lightmaps go on the second texture unit.
+    GLuint boundTexture = 0;
+    GLuint boundLightmap = 0;
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, boundLightmap);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, boundTexture);
+
+    for (const StaticBatch & batch : batches)
+    {
+        if (batch.layout != layout)
+            continue;
+
+        bool visible = true;
+
+        // The corner of the bounds furthest along each plane's
+        // normal has to be inside of it.
+        for (int plane = 0; plane < 6 && visible; ++plane)
+        {
+            glm::vec3 normal = glm::vec3(planes[plane]);
+            glm::vec3 corner(normal.x >= 0.0f ? batch.boundsMax.x : batch.boundsMin.x,
+                             normal.y >= 0.0f ? batch.boundsMax.y : batch.boundsMin.y,
+                             normal.z >= 0.0f ? batch.boundsMax.z : batch.boundsMin.z);
+
+            visible = glm::dot(normal, corner) + planes[plane].w >= 0.0f;
+        }
+
+        if (!visible)
+            continue;
+
+        if (batch.texture != boundTexture)
+        {
+            boundTexture = batch.texture;
+            glBindTexture(GL_TEXTURE_2D, boundTexture);
+        }
+
+        if (batch.lightmap != boundLightmap)
+        {
+            boundLightmap = batch.lightmap;
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, boundLightmap);
+            glActiveTexture(GL_TEXTURE0);
+        }
+
+        glBindVertexArray(batch.vao);
+        glDrawElements(GL_TRIANGLES, batch.indexCount, batch.indexType, (GLvoid *) 0);
+    }
+
+    glBindVertexArray(0);
+}
+
+//////////////////////////////////////////////////////////////
+void Renderer::drawImpostors(const MeshImpostor & impostor, const ImpostorBatch & batch)
+{
+    if (impostor.texture == 0 || batch.getVertexCount() == 0)
+        return;
+
+    GLuint stride = CE_IMPOSTOR_VERTEX_SIZE * sizeof(GLfloat);
+
+    if (m_impostorVAO == 0)
+    {
+        m_impostorVAO = generateVAO();
+        m_impostorVBO = generateVBO();
+
+        bindVAO(m_impostorVAO);
+        bindArrayBuffer(m_impostorVBO, 0, nullptr, false);
+
+        addVertexAttribute(3, false, stride, 0);
+        addVertexAttribute(2, false, stride, 3 * sizeof(GLfloat));
+    }
+    else
+        bindVAO(m_impostorVAO);
+
+    // The quads change every frame, so the buffer is respecified
+    // rather than waiting on the draws that still read it.
+    bindArrayBuffer(m_impostorVBO, batch.getVertices().size() * sizeof(GLfloat), &batch.getVertices()[0], false);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, impostor.texture);
+
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei) batch.getVertexCount());
+
+    unbindArrayBuffer();
+    unbindVAO();
+}
+
 //////////////////////////////////////////////////////////////
 void Renderer::setColorDrawBuffer()
 {
@@ -274,6 +538,20 @@ void Renderer::passUniformMatrix(const GLuint & shaderProgram, const char * unif
     glUniformMatrix4fv(uniformLocation, 1, normalize ? GL_TRUE : GL_FALSE, glm::value_ptr(uniformMatrix));
 }
 
+//////////////////////////////////////////////////////////////
+void Renderer::passUniformVector(const GLuint & shaderProgram, const char * uniformName, const glm::vec2 & uniformVector)
+{
+    GLint uniformLocation = glGetUniformLocation(shaderProgram, uniformName);
+    glUniform2fv(uniformLocation, 1, glm::value_ptr(uniformVector));
+}
+
+//////////////////////////////////////////////////////////////
+void Renderer::passUniformVector(const GLuint & shaderProgram, const char * uniformName, const glm::vec3 & uniformVector)
+{
+    GLint uniformLocation = glGetUniformLocation(shaderProgram, uniformName);
+    glUniform3fv(uniformLocation, 1, glm::value_ptr(uniformVector));
+}
+
 //////////////////////////////////////////////////////////////
 GLuint Renderer::createShaderProgram(const char * vertexShaderSource, const char * fragmentShaderSource)
 {
@@ -314,6 +592,8 @@ GLuint Renderer::createShaderProgram(const char * vertexShaderSource, const char
         LOG("Compiled fragment shader...");
 
     program = glCreateProgram();
+    m_programList.push_back(program);
+
     glAttachShader(program, vertexShader);
     glAttachShader(program, fragmentShader);
     glLinkProgram(program);
@@ -461,6 +741,18 @@ GLuint Renderer::createOctagon(const glm::vec2 & tl, const glm::vec2 & br, const
 
 //////////////////////////////////////////////////////////////
 GLuint Renderer::createVoxel(const glm::vec3 & tl, const glm::vec3 & size, const glm::vec3 & color)
+{
+    return createVoxelBuffers(tl, size, color, nullptr);
+}
+
+//////////////////////////////////////////////////////////////
+GLuint Renderer::createVoxel(const glm::vec3 & tl, const glm::vec3 & size, const glm::vec3 & color, GLuint & depthVAO)
+{
+    return createVoxelBuffers(tl, size, color, &depthVAO);
+}
+
+//////////////////////////////////////////////////////////////
+GLuint Renderer::createVoxelBuffers(const glm::vec3 & tl, const glm::vec3 & size, const glm::vec3 & color, GLuint * depthVAO)
 {
     // Voxel vertex data size:
     //
@@ -515,180 +807,846 @@ GLuint Renderer::createVoxel(const glm::vec3 & tl, const glm::vec3 & size, const
         tl.x + size.x, tl.y - size.y, tl.z - size.z, color.r, color.g, color.b, 0.0f, -1.0f, 0.0f,
     };
 
+    const size_t vertexCount = sizeof(voxelData) / (9 * sizeof(GLfloat));
+
+    //////////////////////////////////////////
+    // For depth passes the positions are also
+    // stored tightly packed after the
+    // interleaved vertices.
+    //////////////////////////////////////////
+    std::vector<GLfloat> bufferData(voxelData, voxelData + vertexCount * 9);
+
+    if (depthVAO != nullptr)
+    {
+        for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+            bufferData.insert(bufferData.end(), &voxelData[vertex * 9], &voxelData[vertex * 9 + 3]);
+    }
+
     GLuint vao = generateVAO();
     GLuint vbo = generateVBO();
 
     bindVAO(vao);
-    bindArrayBuffer(vbo, sizeof(voxelData), &voxelData[0]);
+    bindArrayBuffer(vbo, bufferData.size() * sizeof(GLfloat), &bufferData[0]);
 
     addVertexAttribute(3, false, 9 * sizeof(GLfloat), 0);
     addVertexAttribute(3, false, 9 * sizeof(GLfloat), 3 * sizeof(GLfloat));
     addVertexAttribute(3, false, 9 * sizeof(GLfloat), 6 * sizeof(GLfloat));
 
-    unbindVAO();
+    if (depthVAO != nullptr)
+    {
+        *depthVAO = generateVAO();
 
-    m_vaoList.push_back(vao);
-    m_vboList.push_back(vbo);
+        bindVAO(*depthVAO);
+        addVertexAttribute(3, false, 3 * sizeof(GLfloat), sizeof(voxelData));
+    }
+
+    unbindArrayBuffer();
+    unbindVAO();
 
     return vao;
 }
 
 //////////////////////////////////////////////////////////////
-GLuint Renderer::createMesh(const std::string & filename, GLuint & texture, size_t & numVertices)
+Mesh Renderer::createMesh(const std::string & filename, const unsigned int & flags)
+{
+    MeshLoadData data;
+
+    bool loaded = MeshLoader::load(filename, flags, data, &m_loadScratch);
+    m_loadScratch.reset();
+
+    if (!loaded)
+        return Mesh();
+
+    return uploadLoadedMesh(data);
+}
+
+//////////////////////////////////////////////////////////////
+MeshHandle Renderer::createMeshAsync(const std::string & filename, const unsigned int & flags)
+{
+    return MeshHandle(m_meshLoader.request(filename, flags));
+}
+
+//////////////////////////////////////////////////////////////
+void Renderer::processMeshUploads(const size_t & maxUploads)
+{
+    std::shared_ptr<MeshLoadRequest> request;
+
+    for (size_t upload = 0; upload < maxUploads && m_meshLoader.popLoaded(request); ++upload)
+    {
+        if (request->loaded)
+            request->mesh = uploadLoadedMesh(request->data);
+
+        // Unmaps the files and frees what was uploaded.
+        request->data  = MeshLoadData();
+        request->ready = true;
+    }
+}
+
+//////////////////////////////////////////////////////////////
+Mesh Renderer::uploadLoadedMesh(MeshLoadData & data)
 {
-    FileReader<char> fileReader;
-    char * meshData;
-    size_t meshSize;
+    if (data.gltf)
+        return uploadGltfMesh(data);
+
+    Mesh result = data.mesh;
 
-    std::vector<glm::vec3> vertexCoordinates;
-    std::vector<glm::vec3> normalCoordinates;
-    std::vector<glm::vec3> textureCoordinates;
-    std::string materialFilename = "";
-    std::string textureFilename = "";
-    std::vector<GLfloat> vertexData;
+    if (result.indexCount > 0)
+        uploadMesh(result, data.vertexData, data.vertexDataSize, data.indexData, data.indexDataSize);
 
-    GLuint vao, vbo;
+    if (result.vao != 0 && !data.positionData.empty())
+        uploadPositions(result, data.positionData);
 
-    if (fileReader.read(filename.c_str(), &meshData, &meshSize))
+    if (result.vao != 0)
+        loadMeshTextures(result, data.ranges, data.lods, data.images, data.imageHashes, data.materialImages);
+
+    return result;
+}
+
+//////////////////////////////////////////////////////////////
+Mesh Renderer::uploadGltfMesh(MeshLoadData & loaded)
+{
+    Mesh result;
+    const GltfData & data = loaded.gltfData;
+
+    //////////////////////////////////////////
+    // Upload the part of the binary chunk that
+    // holds the geometry straight from the
+    // mapped file, as one buffer that is used
+    // for both the vertices and the indices.
+    // Images stored around it aren't uploaded.
+    //////////////////////////////////////////
+    size_t geometryBegin = data.binarySize;
+    size_t geometryEnd = 0;
+
+    for (const GltfPrimitive & primitive : data.primitives)
     {
-        char * buffer = strtok(meshData, " ,/\n\0");
-        while (buffer != NULL)
+        for (int accessor : { primitive.position, primitive.texCoord, primitive.normal, primitive.indices })
         {
-            glm::vec3 coord;
-            if (strcmp("v", buffer) == 0)
-            {
-                buffer = strtok(NULL, " ,/\n\0");
-                coord.x = atof(buffer);
+            if (accessor < 0)
+                continue;
 
-                buffer = strtok(NULL, " ,/\n\0");
-                coord.y = atof(buffer);
+            const GltfBufferView & view = data.bufferViews[data.accessors[accessor].bufferView];
+            geometryBegin = std::min(geometryBegin, view.byteOffset);
+            geometryEnd   = std::max(geometryEnd, view.byteOffset + view.byteLength);
+        }
+    }
 
-                buffer = strtok(NULL, " ,/\n\0");
-                coord.z = atof(buffer);
+    // Keep every offset aligned the way it is in the file.
+    geometryBegin &= ~(size_t) 3;
 
-                vertexCoordinates.push_back(coord);
-            }
-            else if (strcmp("vt", buffer) == 0)
-            {
-                buffer = strtok(NULL, " ,/\n\0");
-                coord.x = atof(buffer);
+    result.vbo = generateVBO();
+    result.ebo = result.vbo;
 
-                buffer = strtok(NULL, " ,/\n\0");
-                coord.y = atof(buffer);
+    bindArrayBuffer(result.vbo, (unsigned int)(geometryEnd - geometryBegin), data.binary + geometryBegin);
+    unbindArrayBuffer();
 
-                textureCoordinates.push_back(coord);
-            }
-            else if (strcmp("vn", buffer) == 0)
-            {
-                buffer = strtok(NULL, " ,/\n\0");
-                coord.x = atof(buffer);
+    //////////////////////////////////////////
+    // Every primitive gets a vertex array of
+    // its own, as their layouts can differ.
+    //////////////////////////////////////////
+    std::vector<GLuint> materialTextures;
+    createMaterialTextures(result, loaded.images, loaded.imageHashes, loaded.materialImages, materialTextures);
 
-                buffer = strtok(NULL, " ,/\n\0");
-                coord.y = atof(buffer);
+    result.materials = data.materials;
+    result.boundsMin = glm::vec3( FLT_MAX);
+    result.boundsMax = glm::vec3(-FLT_MAX);
 
-                buffer = strtok(NULL, " ,/\n\0");
-                coord.z = atof(buffer);
+    for (const GltfPrimitive & primitive : data.primitives)
+    {
+        GLuint vao = generateVAO();
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, result.vbo);
 
-                normalCoordinates.push_back(coord);
-            }
-            else if (strcmp("f", buffer) == 0)
+        // Attribute locations match the OBJ meshes, so the same
+        // shaders draw both.
+        const int attributes[] = { primitive.position, primitive.texCoord, primitive.normal };
+
+        for (GLuint location = 0; location < 3; ++location)
+        {
+            if (attributes[location] < 0)
+                continue;
+
+            const GltfAccessor & accessor = data.accessors[attributes[location]];
+            size_t offset = data.bufferViews[accessor.bufferView].byteOffset + accessor.byteOffset - geometryBegin;
+
+            glVertexAttribPointer(location, accessor.componentCount, accessor.componentType, accessor.normalized ? GL_TRUE : GL_FALSE,
+                                  (GLsizei) GltfParser::getStride(data, accessor), (GLvoid *) offset);
+            glEnableVertexAttribArray(location);
+        }
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, result.vbo);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        const GltfAccessor & indices = data.accessors[primitive.indices];
+        const GltfAccessor & positions = data.accessors[primitive.position];
+
+        Submesh submesh;
+        submesh.vao          = vao;
+        submesh.indexType    = indices.componentType;
+        submesh.firstIndex   = (GLuint)((data.bufferViews[indices.bufferView].byteOffset + indices.byteOffset - geometryBegin) / submesh.getIndexSize());
+        submesh.indexCount   = (GLuint) indices.count;
+        submesh.material     = primitive.material;
+        submesh.texture      = primitive.material >= 0 ? materialTextures[primitive.material] : 0;
+        submesh.firstMeshlet = 0;
+        submesh.meshletCount = 0;
+
+        result.submeshes.push_back(submesh);
+        result.indexCount += indices.count;
+        result.boundsMin = glm::min(result.boundsMin, positions.min);
+        result.boundsMax = glm::max(result.boundsMax, positions.max);
+    }
+
+    std::stable_sort(result.submeshes.begin(), result.submeshes.end(),
+        [](const Submesh & left, const Submesh & right) { return left.texture < right.texture; });
+
+    result.vao       = result.submeshes[0].vao;
+    result.indexType = result.submeshes[0].indexType;
+    result.bvh       = loaded.mesh.bvh;
+
+    return result;
+}
+
+//////////////////////////////////////////////////////////////
+Mesh Renderer::createMeshChunk(const MeshChunkFile & chunks, const size_t & chunk)
+{
+    Mesh result;
+
+    if (chunk >= chunks.getChunkCount())
+        return result;
+
+    //////////////////////////////////////////
+    // Chunks are uploaded straight from the
+    // mapped file, like cooked meshes.
+    //////////////////////////////////////////
+    const MeshChunkInfo & info = chunks.getChunk(chunk);
+    std::vector<MeshRange> ranges;
+
+    chunks.getRanges(chunk, ranges);
+
+    result.materials  = chunks.getMaterials();
+    result.indexCount = info.indexCount;
+    result.indexType  = info.indexType;
+    result.boundsMin  = glm::vec3(info.boundsMin[0], info.boundsMin[1], info.boundsMin[2]);
+    result.boundsMax  = glm::vec3(info.boundsMax[0], info.boundsMax[1], info.boundsMax[2]);
+
+    if (result.indexCount > 0)
+        uploadMesh(result, chunks.getVertexData(chunk), chunks.getVertexDataSize(chunk), chunks.getIndexData(chunk), chunks.getIndexDataSize(chunk));
+
+    //////////////////////////////////////////
+    // The images of the file were hashed when
+    // it was opened. Only the ones without a
+    // texture yet are decoded, so every chunk
+    // after the first shares its textures.
+    //////////////////////////////////////////
+    if (result.vao != 0)
+    {
+        const std::vector<std::string> & imageFiles = chunks.getImageFiles();
+        std::vector<uint64_t> imageHashes = chunks.getImageHashes();
+        std::vector<Image> images(imageFiles.size());
+
+        std::vector<std::string> decodeFiles;
+        std::vector<size_t> decodeImages;
+
+        for (size_t image = 0; image < imageFiles.size(); ++image)
+        {
+            if (!m_assets->textures.find(std::to_string(imageHashes[image]), imageHashes[image]))
             {
-                for (unsigned int vertexCount = 0; vertexCount < 3; ++vertexCount)
-                {
-                    buffer = strtok(NULL, " ,/\n\0");
-                    int vertexIndex  = atoi(buffer) - 1;
-
-                    buffer = strtok(NULL, " ,/\n\0");
-                    int textureIndex = atoi(buffer) - 1;
-
-                    buffer = strtok(NULL, " ,/\n\0");
-                    int normalIndex  = atoi(buffer) - 1;
-
-                    vertexData.push_back(vertexCoordinates[vertexIndex].x);
-                    vertexData.push_back(vertexCoordinates[vertexIndex].y);
-                    vertexData.push_back(vertexCoordinates[vertexIndex].z);
-                    
-                    vertexData.push_back(textureCoordinates[textureIndex].x);
-                    vertexData.push_back(textureCoordinates[textureIndex].y);
-                    
-                    vertexData.push_back(normalCoordinates[normalIndex].x);
-                    vertexData.push_back(normalCoordinates[normalIndex].y);
-                    vertexData.push_back(normalCoordinates[normalIndex].z);
-                }
+                decodeFiles.push_back(imageFiles[image]);
+                decodeImages.push_back(image);
             }
-            else if (strcmp("mtllib", buffer) == 0)
+        }
+
+        if (!decodeFiles.empty())
+        {
+            std::vector<Image> decoded;
+            std::vector<uint64_t> decodedHashes;
+
+            MeshLoader::loadImageFiles(decodeFiles, decoded, decodedHashes);
+
+            for (size_t image = 0; image < decodeImages.size(); ++image)
             {
-                buffer = strtok(NULL, " ,/\n\0");
-                materialFilename = std::string(buffer);
+                images[decodeImages[image]] = std::move(decoded[image]);
+                imageHashes[decodeImages[image]] = decodedHashes[image];
             }
-            buffer = strtok(NULL, " ,/\n\0");
         }
 
-        delete [] meshData;
+        loadMeshTextures(result, ranges, std::vector<MeshLodData>(), images, imageHashes, chunks.getMaterialImages());
     }
 
-    if (materialFilename != "")
+    return result;
+}
+
+//////////////////////////////////////////////////////////////
+std::vector<StaticBatch> Renderer::createStaticBatches(StaticBatchBuilder & builder)
+{
+    std::vector<StaticBatch> batches;
+    std::vector<TextureRef> textures(builder.getImages().size());
+
+    for (StaticBatchData & data : builder.getBatches())
     {
-        char * materialData;
-        size_t materialDataSize;
-        std::size_t endOfPath = filename.find_last_of("/") + 1;
-        std::string pathToModel = filename.substr(0, endOfPath);
-        materialFilename = pathToModel + materialFilename;
+        if (data.indices.empty())
+            continue;
+
+        StaticBatch batch;
+        batch.layout     = data.layout;
+        batch.indexCount = (GLsizei) data.indices.size();
+        batch.boundsMin  = data.boundsMin;
+        batch.boundsMax  = data.boundsMax;
+        batch.texture    = 0;
+        batch.lightmap   = 0;
+
+        //////////////////////////////////////////
+        // Batches with few enough vertices use
+        // 16 bit indices.
+        //////////////////////////////////////////
+        size_t vertexSize = data.getVertexSize();
+        size_t vertexCount = data.vertices.size() / vertexSize;
+        std::vector<GLushort> shortIndices;
+
+        if (vertexCount <= 0xFFFF)
+            shortIndices.assign(data.indices.begin(), data.indices.end());
+
+        batch.indexType = shortIndices.empty() ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+        batch.vao = generateVAO();
+        batch.vbo = generateVBO();
+        batch.ebo = generateEBO();
+
+        bindVAO(batch.vao);
+        bindArrayBuffer(batch.vbo, data.vertices.size() * sizeof(GLfloat), &data.vertices[0]);
+
+        if (shortIndices.empty())
+            bindElementBuffer(batch.ebo, data.indices.size() * sizeof(GLuint), &data.indices[0]);
+        else
+            bindElementBuffer(batch.ebo, shortIndices.size() * sizeof(GLushort), &shortIndices[0]);
+
+        GLuint stride = vertexSize * sizeof(GLfloat);
+
+        if (data.layout == STATIC_BATCH_COLORED)
+        {
+            addVertexAttribute(3, false, stride, 0);
+            addVertexAttribute(3, false, stride, 3 * sizeof(GLfloat));
+            addVertexAttribute(3, false, stride, 6 * sizeof(GLfloat));
+        }
+        else
+        {
+            addVertexAttribute(3, false, stride, 0);
+            addVertexAttribute(2, false, stride, 3 * sizeof(GLfloat));
+            addVertexAttribute(3, false, stride, 5 * sizeof(GLfloat));
+        }
 
-        if (fileReader.read(materialFilename.c_str(), &materialData, &materialDataSize))
+        // The lightmap coordinate comes after everything else.
+        if (data.lightmapped)
+            addVertexAttribute(2, false, stride, (vertexSize - CE_STATIC_BATCH_LIGHTMAP_SIZE) * sizeof(GLfloat));
+
+        unbindArrayBuffer();
+        unbindVAO();
+
+        if (data.image >= 0)
         {
-            char * buffer = strtok(materialData, " ,/\n\0");
-            while (buffer != NULL)
-            {
-                if (strcmp("map_Kd", buffer) == 0)
-                {
-                    buffer = strtok(NULL, " ,/\n\0");
-                    std::string textureFilename(buffer);
+            if (!textures[data.image])
+                textures[data.image] = acquireTexture(builder.getImages()[data.image], builder.getImageHashes()[data.image]);
 
-                    //////////////////////////////////////////
-                    // Load the texture PNG file
-                    //////////////////////////////////////////
-                    ce::Image image(pathToModel + textureFilename);
+            batch.textureRef = textures[data.image];
+            batch.texture    = batch.textureRef ? *batch.textureRef : 0;
+        }
 
-                    texture = generateTexture();
+        if (data.lightmapped)
+            batch.lightmap = createLightmapTexture(data.lightmap);
 
-                    bindTexture(texture);
-                    loadTextureImage(&image.getImageBuffer()[0], image.getWidth(), image.getHeight());
+        batches.push_back(batch);
+    }
 
-                    setTextureWrapping(GL_REPEAT);
-                    setMinTextureFiltering(GL_NEAREST);
-                    setMagTextureFiltering(GL_NEAREST);
+    // Drawing the batches in texture order binds every texture once.
+    std::stable_sort(batches.begin(), batches.end(),
+        [](const StaticBatch & left, const StaticBatch & right) { return left.texture < right.texture; });
 
-                    unbindTexture();
-                }
+    LOG("Created " + std::to_string(batches.size()) + " static batches.");
 
-                buffer = strtok(NULL, " ,/\n\0");
-            }
+    return batches;
+}
+
+//////////////////////////////////////////////////////////////
+void Renderer::uploadMesh(Mesh & mesh, const GLvoid * vertexData, const size_t & vertexDataSize, const GLvoid * indexData, const size_t & indexDataSize)
+{
+    mesh.vao = generateVAO();
+    mesh.vbo = generateVBO();
+    mesh.ebo = generateEBO();
+
+    bindVAO(mesh.vao);
+    bindArrayBuffer(mesh.vbo, vertexDataSize, vertexData);
+    bindElementBuffer(mesh.ebo, indexDataSize, indexData);
+
+    GLuint stride = mesh.format.getStride();
+
+    if (mesh.format.quantized)
+    {
+        // Decoded by the entity_quantized shaders.
+        addVertexAttribute(3, true, stride, 0, GL_UNSIGNED_SHORT);
+        addVertexAttribute(2, true, stride, 8, GL_UNSIGNED_SHORT);
+        addIntegerVertexAttribute(2, GL_BYTE, stride, 12);
+    }
+    else
+    {
+        addVertexAttribute(3, false, stride, 0);
+        addVertexAttribute(2, false, stride, 3 * sizeof(GLfloat));
+        addVertexAttribute(3, false, stride, 5 * sizeof(GLfloat));
+    }
+
+    unbindArrayBuffer();
+    unbindVAO();
+}
+
+//////////////////////////////////////////////////////////////
+void Renderer::uploadPositions(Mesh & mesh, const std::vector<unsigned char> & positionData)
+{
+    mesh.depthVao    = generateVAO();
+    mesh.positionVbo = generateVBO();
+
+    bindVAO(mesh.depthVao);
+    bindArrayBuffer(mesh.positionVbo, positionData.size(), &positionData[0]);
+
+    // The element buffer was filled by uploadMesh, it only needs
+    // to be bound to this vertex array as well.
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo);
 
-            delete [] materialData;
+    if (mesh.format.quantized)
+        addVertexAttribute(3, true, 4 * sizeof(GLushort), 0, GL_UNSIGNED_SHORT);
+    else
+        addVertexAttribute(3, false, 3 * sizeof(GLfloat), 0);
+
+    unbindArrayBuffer();
+    unbindVAO();
+}
+
+//////////////////////////////////////////////////////////////
+static void createSubmeshes(const Mesh & mesh, const std::vector<MeshRange> & ranges, const std::vector<GLuint> & materialTextures, std::vector<Submesh> & submeshes)
+{
+    for (const MeshRange & range : ranges)
+    {
+        if (range.firstIndex + (size_t) range.indexCount > mesh.indexCount)
+            continue;
+
+        Submesh submesh;
+        submesh.firstIndex = range.firstIndex;
+        submesh.indexCount = range.indexCount;
+        submesh.material   = (range.material >= 0 && (size_t) range.material < mesh.materials.size()) ? range.material : -1;
+        submesh.texture    = submesh.material >= 0 ? materialTextures[submesh.material] : 0;
+        submesh.vao        = mesh.vao;
+        submesh.indexType  = mesh.indexType;
+
+        // Meshlets never straddle ranges, so the range's meshlets
+        // are the ones that start inside of it.
+        auto firstIndexLess = [](const Meshlet & meshlet, const GLuint & index) { return meshlet.firstIndex < index; };
+        auto first = std::lower_bound(mesh.meshlets.begin(), mesh.meshlets.end(), range.firstIndex, firstIndexLess);
+        auto last  = std::lower_bound(first, mesh.meshlets.end(), range.firstIndex + range.indexCount, firstIndexLess);
+
+        submesh.firstMeshlet = (GLuint)(first - mesh.meshlets.begin());
+        submesh.meshletCount = (GLuint)(last - first);
+
+        submeshes.push_back(submesh);
+    }
+
+    std::stable_sort(submeshes.begin(), submeshes.end(),
+        [](const Submesh & left, const Submesh & right) { return left.texture < right.texture; });
+}
+
+//////////////////////////////////////////////////////////////
+GLuint Renderer::createMeshTexture(Image & image)
+{
+    // Images that couldn't be decoded leave the mesh untextured.
+    if (image.getImageBuffer().empty())
+        return 0;
+
+    GLuint texture = generateTexture();
+
+    bindTexture(texture);
+    loadTextureImage(&image.getImageBuffer()[0], image.getWidth(), image.getHeight());
+
+    setTextureWrapping(GL_REPEAT);
+    setMinTextureFiltering(GL_NEAREST);
+    setMagTextureFiltering(GL_NEAREST);
+
+    unbindTexture();
+
+    return texture;
+}
+
+//////////////////////////////////////////////////////////////
+GLuint Renderer::createMeshTexture(const unsigned char * data, const size_t & size)
+{
+    unsigned long width = 0;
+    unsigned long height = 0;
+
+    // QOI copies of textures (see TextureConverter) are decoded
+    // instead of PNGs when a model has them.
+    const bool qoi = isQoi(data, size);
+
+    if (qoi ? !readQoiSize(data, size, width, height) : getPNGSize(width, height, data, size) != 0)
+    {
+        LOG("Could not read the size of the image.");
+        return 0;
+    }
+
+    // The image is decoded straight into a pixel unpack buffer, so
+    // its pixels are never held anywhere else on their way to the
+    // texture.
+    GLsizeiptr pixelsSize = 4 * (GLsizeiptr) width * height;
+    GLuint pixelBuffer = 0;
+
+    glGenBuffers(1, &pixelBuffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, pixelsSize, nullptr, GL_STREAM_DRAW);
+
+    unsigned char * pixels = (unsigned char *) glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, pixelsSize,
+                                                                 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    GLuint texture = 0;
+
+    if (pixels != nullptr)
+    {
+        bool decoded = true;
+
+        if (qoi)
+        {
+            decoded = decodeQoi(data, size, pixels, pixelsSize);
+
+            if (!decoded)
+                LOG("Error occurred while decoding the QOI image.");
+        }
+        else
+        {
+            int error = decodePNGInto(pixels, pixelsSize, width, height, data, size, &m_loadScratch);
+            m_loadScratch.reset();
+
+            decoded = error == 0;
+
+            if (!decoded)
+                LOG("Error occurred while decoding the PNG. (error: " + std::to_string(error) + ")");
+        }
+
+        // The buffer's contents can be lost while it's mapped.
+        if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE)
+            decoded = false;
+
+        if (decoded)
+        {
+            LOG("Image size: " + std::to_string(width) + ", " + std::to_string(height));
+
+            texture = generateTexture();
+
+            bindTexture(texture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+
+            setTextureWrapping(GL_REPEAT);
+            setMinTextureFiltering(GL_NEAREST);
+            setMagTextureFiltering(GL_NEAREST);
+
+            unbindTexture();
+        }
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glDeleteBuffers(1, &pixelBuffer);
+
+    return texture;
+}
+
+//////////////////////////////////////////////////////////////
+GLuint Renderer::createLightmapTexture(Image & image)
+{
+    if (image.getImageBuffer().empty())
+        return 0;
+
+    GLuint texture = generateTexture();
+
+    bindTexture(texture);
+    loadTextureImage(&image.getImageBuffer()[0], image.getWidth(), image.getHeight());
+
+    // Lightmaps are smooth, and their charts are padded against
+    // bleeding into each other when filtered.
+    setTextureWrapping(GL_CLAMP_TO_EDGE);
+    setMinTextureFiltering(GL_LINEAR);
+    setMagTextureFiltering(GL_LINEAR);
+
+    unbindTexture();
+
+    return texture;
+}
+
+//////////////////////////////////////////////////////////////
+void Renderer::createMaterialTextures(Mesh & mesh, std::vector<Image> & images, const std::vector<uint64_t> & imageHashes, const std::vector<int> & materialImages, std::vector<GLuint> & materialTextures)
+{
+    // Materials that share an image share its texture, and so do
+    // meshes whose images have the same content.
+    std::vector<TextureRef> textures(images.size());
+    std::vector<bool> acquired(images.size(), false);
+
+    materialTextures.assign(materialImages.size(), 0);
+
+    for (size_t material = 0; material < materialImages.size(); ++material)
+    {
+        int image = materialImages[material];
+
+        if (image < 0 || (size_t) image >= images.size() || (size_t) image >= imageHashes.size())
+            continue;
+
+        if (!acquired[image])
+        {
+            textures[image] = acquireTexture(images[image], imageHashes[image]);
+            acquired[image] = true;
+
+            if (textures[image])
+                mesh.textures.push_back(textures[image]);
         }
+
+        materialTextures[material] = textures[image] ? *textures[image] : 0;
     }
+}
+
+//////////////////////////////////////////////////////////////
+void Renderer::loadMeshTextures(Mesh & mesh, const std::vector<MeshRange> & ranges, const std::vector<MeshLodData> & lods, std::vector<Image> & images, const std::vector<uint64_t> & imageHashes, const std::vector<int> & materialImages)
+{
+    std::vector<GLuint> materialTextures;
+    createMaterialTextures(mesh, images, imageHashes, materialImages, materialTextures);
 
-    size_t vertexDataSize = vertexData.size();
-    if (vertexDataSize > 0)
+    createSubmeshes(mesh, ranges, materialTextures, mesh.submeshes);
+
+    mesh.lods.resize(lods.size());
+
+    for (size_t lod = 0; lod < lods.size(); ++lod)
     {
-        numVertices = vertexDataSize / 8;
-        vao = generateVAO();
-        vbo = generateVBO();
+        mesh.lods[lod].error = lods[lod].error;
+        createSubmeshes(mesh, lods[lod].ranges, materialTextures, mesh.lods[lod].submeshes);
+    }
+}
 
-        bindVAO(vao);
-        bindArrayBuffer(vbo, vertexDataSize * sizeof(GLfloat), &vertexData[0]);
+//////////////////////////////////////////////////////////////
+TextureRef Renderer::acquireTexture(Image & image, const uint64_t & hash)
+{
+    // The image is only needed when there's no texture of it yet.
+    std::string key = std::to_string(hash);
+    TextureRef texture = m_assets->textures.find(key, hash);
 
-        GLuint stride = 8 * sizeof(GLfloat);
-        addVertexAttribute(3, false, stride, 0);
-        addVertexAttribute(3, false, stride, 3 * sizeof(GLfloat));
-        addVertexAttribute(3, false, stride, 5 * sizeof(GLfloat));
+    if (texture)
+        return texture;
 
-        unbindArrayBuffer();
-        unbindVAO();
+    if (image.getImageBuffer().empty())
+        return TextureRef();
+
+    return shareTexture(createMeshTexture(image), hash);
+}
+
+//////////////////////////////////////////////////////////////
+TextureRef Renderer::shareTexture(const GLuint & name, const uint64_t & hash)
+{
+    std::string key = std::to_string(hash);
+    std::weak_ptr<Assets> assets = m_assets;
+
+    TextureRef texture = TextureRef(new GLuint(name), [assets, key](const GLuint * texture)
+    {
+        std::shared_ptr<Assets> owner = assets.lock();
+
+        if (owner)
+        {
+            owner->renderer->deleteTexture(*texture);
+            owner->textures.release(key);
+        }
+
+        delete texture;
+    });
+
+    m_assets->textures.insert(key, hash, texture);
+
+    return texture;
+}
+
+//////////////////////////////////////////////////////////////
+TextureRef Renderer::loadTexture(const std::string & filename)
+{
+    MappedFile file(filename);
+
+    if (!file.isOpen())
+    {
+        LOG("Could not read the texture: " + filename);
+        return std::make_shared<const GLuint>(0);
     }
 
-    return vao;
+    uint64_t hash = hashBytes(file.getData(), file.getSize());
+    TextureRef texture = m_assets->textures.find(std::to_string(hash), hash);
+
+    if (!texture)
+    {
+        LOG("Reading image: " + filename);
+
+        GLuint name = createMeshTexture((const unsigned char *) file.getData(), file.getSize());
+
+        if (name != 0)
+            texture = shareTexture(name, hash);
+    }
+
+    return texture ? texture : std::make_shared<const GLuint>(0);
+}
+
+//////////////////////////////////////////////////////////////
+ShaderRef Renderer::loadShaderProgram(const std::string & vertexShaderFilename, const std::string & fragmentShaderFilename)
+{
+    MappedFile vertexFile(vertexShaderFilename);
+    MappedFile fragmentFile(fragmentShaderFilename);
+
+    if (!vertexFile.isOpen() || !fragmentFile.isOpen())
+    {
+        LOG("Could not read the shaders: " + vertexShaderFilename + ", " + fragmentShaderFilename);
+        return std::make_shared<const GLuint>(0);
+    }
+
+    uint64_t hash = hashBytes(fragmentFile.getData(), fragmentFile.getSize(),
+                              hashBytes(vertexFile.getData(), vertexFile.getSize()));
+
+    std::string key = getCanonicalPath(vertexShaderFilename) + "|" + getCanonicalPath(fragmentShaderFilename);
+    ShaderRef program = m_assets->shaders.find(key, hash);
+
+    if (program)
+        return program;
+
+    // The mapped sources aren't null terminated.
+    std::string vertexShaderSource(vertexFile.getData(), vertexFile.getSize());
+    std::string fragmentShaderSource(fragmentFile.getData(), fragmentFile.getSize());
+    std::weak_ptr<Assets> assets = m_assets;
+
+    program = ShaderRef(new GLuint(createShaderProgram(vertexShaderSource.c_str(), fragmentShaderSource.c_str())), [assets, key](const GLuint * program)
+    {
+        std::shared_ptr<Assets> owner = assets.lock();
+
+        if (owner)
+        {
+            owner->renderer->deleteShaderProgram(*program);
+            owner->shaders.release(key);
+        }
+
+        delete program;
+    });
+
+    m_assets->shaders.insert(key, hash, program);
+
+    return program;
+}
+
+//////////////////////////////////////////////////////////////
+MeshRef Renderer::loadMesh(const std::string & filename, const unsigned int & flags)
+{
+    uint64_t hash;
+
+    if (!hashFile(filename, hash))
+    {
+        LOG("Could not read the mesh: " + filename);
+        return std::make_shared<const Mesh>();
+    }
+
+    std::string key = getCanonicalPath(filename) + "|" + std::to_string(flags);
+    MeshRef mesh = m_assets->meshes.find(key, hash);
+
+    if (mesh)
+        return mesh;
+
+    Mesh created = createMesh(filename, flags);
+
+    // A mesh that failed to load isn't cached, so it's tried again
+    // the next time it's asked for.
+    if (created.vao == 0)
+        return std::make_shared<const Mesh>();
+
+    std::weak_ptr<Assets> assets = m_assets;
+
+    mesh = MeshRef(new Mesh(std::move(created)), [assets, key](const Mesh * mesh)
+    {
+        std::shared_ptr<Assets> owner = assets.lock();
+
+        if (owner)
+        {
+            owner->renderer->deleteMesh(*const_cast<Mesh *>(mesh));
+            owner->meshes.release(key);
+        }
+
+        delete mesh;
+    });
+
+    m_assets->meshes.insert(key, hash, mesh);
+
+    return mesh;
+}
+
+//////////////////////////////////////////////////////////////
+static void removeName(std::vector<GLuint> & names, const GLuint & name)
+{
+    auto found = std::find(names.begin(), names.end(), name);
+
+    if (found != names.end())
+    {
+        *found = names.back();
+        names.pop_back();
+    }
+}
+
+//////////////////////////////////////////////////////////////
+void Renderer::deleteTexture(const GLuint & texture)
+{
+    if (texture == 0)
+        return;
+
+    glDeleteTextures(1, &texture);
+    removeName(m_textureList, texture);
+}
+
+//////////////////////////////////////////////////////////////
+void Renderer::deleteShaderProgram(const GLuint & program)
+{
+    if (program == 0)
+        return;
+
+    glDeleteProgram(program);
+    removeName(m_programList, program);
+}
+
+//////////////////////////////////////////////////////////////
+void Renderer::deleteMesh(Mesh & mesh)
+{
+    // glTF primitives have vertex arrays of their own, and share
+    // one buffer for vertices and indices.
+    std::vector<GLuint> vaos(1, mesh.vao);
+    vaos.push_back(mesh.depthVao);
+
+    for (const Submesh & submesh : mesh.submeshes)
+        vaos.push_back(submesh.vao);
+
+    for (const MeshLod & lod : mesh.lods)
+    {
+        for (const Submesh & submesh : lod.submeshes)
+            vaos.push_back(submesh.vao);
+    }
+
+    std::sort(vaos.begin(), vaos.end());
+    vaos.erase(std::unique(vaos.begin(), vaos.end()), vaos.end());
+
+    for (const GLuint & vao : vaos)
+    {
+        if (vao == 0)
+            continue;
+
+        glDeleteVertexArrays(1, &vao);
+        removeName(m_vaoList, vao);
+    }
+
+    for (const GLuint & buffer : { mesh.vbo, mesh.ebo != mesh.vbo ? mesh.ebo : 0, mesh.positionVbo })
+    {
+        if (buffer == 0)
+            continue;
+
+        glDeleteBuffers(1, &buffer);
+        removeName(m_vboList, buffer);
+    }
+
+    // Drops the mesh's references to its textures.
+    mesh = Mesh();
 }
 
 //////////////////////////////////////////////////////////////
@@ -738,4 +1696,141 @@ GLuint Renderer::createFrameBuffer(const GLsizei & width, const GLsizei & height
     return frameBuffer;
 }
 
+//////////////////////////////////////////////////////////////
+MeshImpostor Renderer::createImpostor(const Mesh & mesh, const GLuint & shaderProgram, const ImpostorSettings & settings)
+{
+    MeshImpostor impostor;
+    impostor.settings = settings;
+    impostor.center   = (mesh.boundsMin + mesh.boundsMax) * 0.5f;
+    impostor.radius   = glm::length(mesh.boundsMax - mesh.boundsMin) * 0.5f;
+
+    if (mesh.vao == 0 || impostor.radius <= 0.0f || settings.views <= 0 || settings.viewSize <= 0)
+        return impostor;
+
+    GLsizei size = settings.views * settings.viewSize;
+
+    impostor.frameBuffer = generateFrameBuffer();
+    bindFrameBuffer(impostor.frameBuffer);
+
+    // With alpha, for the space around the mesh, and mip maps for
+    // the crowds that are further away still.
+    impostor.texture = generateTexture();
+    bindTexture(impostor.texture);
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+
+    setMagTextureFiltering(GL_LINEAR);
+    setMinTextureFiltering(GL_LINEAR_MIPMAP_LINEAR);
+    setTextureWrapping(GL_CLAMP_TO_EDGE);
+
+    impostor.depthBuffer = generateRenderBuffer();
+    bindRenderBuffer(impostor.depthBuffer);
+
+    setRenderBufferStorage(size, size);
+    attachRenderBufferToFrameBuffer(impostor.depthBuffer);
+
+    setFrameBufferTexture(impostor.texture);
+    setColorDrawBuffer();
+
+    unbindTexture();
+    bindFrameBuffer(0);
+
+    updateImpostor(impostor, mesh, shaderProgram);
+
+    LOG("Created an impostor with " + std::to_string(impostor.getViewCount()) + " views.");
+
+    return impostor;
+}
+
+//////////////////////////////////////////////////////////////
+void Renderer::updateImpostor(MeshImpostor & impostor, const Mesh & mesh, const GLuint & shaderProgram, const size_t & firstView, const size_t & viewCount)
+{
+    if (impostor.frameBuffer == 0 || firstView >= impostor.getViewCount())
+        return;
+
+    const size_t lastView = firstView + std::min(viewCount, impostor.getViewCount() - firstView);
+    const GLsizei viewSize = impostor.settings.viewSize;
+
+    // Leave the state as it was found.
+    GLint viewport[4];
+    GLint scissorBox[4];
+    GLfloat clearColor[4];
+    GLint boundFrameBuffer = 0;
+    GLint usedProgram = 0;
+    GLboolean scissorTest = glIsEnabled(GL_SCISSOR_TEST);
+
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetIntegerv(GL_SCISSOR_BOX, scissorBox);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &boundFrameBuffer);
+    glGetIntegerv(GL_CURRENT_PROGRAM, &usedProgram);
+
+    bindFrameBuffer(impostor.frameBuffer);
+    glUseProgram(shaderProgram);
+    glEnable(GL_SCISSOR_TEST);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+
+    glm::mat4 projection = impostor.getProjectionMatrix();
+
+    passUniformMatrix(shaderProgram, "model", glm::mat4(1.0f));
+    passUniformMatrix(shaderProgram, "projection", projection);
+
+    // Only used by the shaders of quantized meshes.
+    passUniformVector(shaderProgram, "positionScale", mesh.format.positionScale);
+    passUniformVector(shaderProgram, "positionOffset", mesh.format.positionOffset);
+    passUniformVector(shaderProgram, "texCoordScale", mesh.format.texCoordScale);
+    passUniformVector(shaderProgram, "texCoordOffset", mesh.format.texCoordOffset);
+
+    setTextureSampler(shaderProgram, "text");
+
+    for (size_t view = firstView; view < lastView; ++view)
+    {
+        int x = (int)(view % impostor.settings.views);
+        int y = (int)(view / impostor.settings.views);
+
+        glViewport(x * viewSize, y * viewSize, viewSize, viewSize);
+        glScissor(x * viewSize, y * viewSize, viewSize, viewSize);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        glm::mat4 viewMatrix = impostor.getViewMatrix(impostor.getViewDirection(x, y));
+        passUniformMatrix(shaderProgram, "view", viewMatrix);
+
+        // Views are small, so a coarser level of detail will do.
+        drawMesh(mesh, mesh.selectLod(viewMatrix, projection, (float) viewSize));
+    }
+
+    if (!scissorTest)
+        glDisable(GL_SCISSOR_TEST);
+
+    bindTexture(impostor.texture);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    unbindTexture();
+
+    bindFrameBuffer(boundFrameBuffer);
+    glUseProgram(usedProgram);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glScissor(scissorBox[0], scissorBox[1], scissorBox[2], scissorBox[3]);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+}
+
+//////////////////////////////////////////////////////////////
+void Renderer::deleteImpostor(MeshImpostor & impostor)
+{
+    deleteTexture(impostor.texture);
+
+    if (impostor.frameBuffer != 0)
+    {
+        glDeleteFramebuffers(1, &impostor.frameBuffer);
+        removeName(m_frameBufferList, impostor.frameBuffer);
+    }
+
+    if (impostor.depthBuffer != 0)
+    {
+        glDeleteRenderbuffers(1, &impostor.depthBuffer);
+        removeName(m_renderBufferList, impostor.depthBuffer);
+    }
+
+    impostor = MeshImpostor();
+}
+
 } // namespace ce
\ No newline at end of file
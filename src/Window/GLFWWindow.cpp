@@ -29,6 +29,7 @@
 // Headers
 //////////////////////////////////////////////////////////////
 #include "Window/GLFWWindow.hpp"
+#include "Services/Renderer.hpp"
 
 namespace ce
 {
@@ -141,6 +142,11 @@ GLfloat GLFWWindow::getElapsedTime()
 void GLFWWindow::begin()
 {
     glfwPollEvents();
+
+    // Meshes loaded in the background are uploaded a few at a time,
+    // so that a big one doesn't stall the frame.
+    RendererLocator::getRenderer()->processMeshUploads();
+
     glClearColor(0.5f, 0.5f, 0.5f, 0.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
@@ -42,4 +42,16 @@ Window::Window(const GLuint & width, const GLuint & height)
 Window::~Window()
 { }
 
+//////////////////////////////////////////////////////////////
+glm::vec2 Window::getMousePosition() const
+{
+    return m_mousePosition;
+}
+
+//////////////////////////////////////////////////////////////
+glm::vec2 Window::getSize() const
+{
+    return glm::vec2(m_width, m_height);
+}
+
 } // namespace ce
\ No newline at end of file
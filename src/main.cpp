@@ -1,5 +1,6 @@
 #include "Window/GLFWWindow.hpp"
 #include "Services/Renderer.hpp"
+#include "Mesh/ObjStreamConverter.hpp"
 
 LOGGER_DECL_LIVE
 
@@ -27,14 +28,36 @@ int main()
                                               glm::vec3(red, green, blue));               // Color
     }
 
-    size_t meshVertexCount = 0;
-    GLuint meshTexture = 0;
-    GLuint meshVAO = renderer->createMesh("../resources/models/blacksmith/blacksmith.obj", meshTexture, meshVertexCount);
+    // Loads in the background and shows up once it is uploaded.
+    ce::MeshHandle blacksmith = renderer->createMeshAsync("../resources/models/blacksmith/blacksmith.obj", ce::MESH_LOAD_OPTIMIZE);
     GLuint meshShader = renderer->createShaderProgramFromFiles("../resources/shaders/entity_textured/vertex.glsl", "../resources/shaders/entity_textured/fragment.glsl");
 
-    size_t nanosuitVertexCount = 0;
-    GLuint nanosuitTexture = 0;
-    GLuint nanosuitVAO = renderer->createMesh("../resources/models/nanosuit/nanosuit.obj", nanosuitTexture, nanosuitVertexCount);
+    // Meshes too large to load at once are converted into chunks
+    // that are uploaded one by one (see ObjStreamConverter). The
+    // blacksmith is converted the first time it is run, or again
+    // once it has changed.
+    std::string chunkedModel = "../resources/models/blacksmith/blacksmith.obj";
+    ce::MeshChunkFile blacksmithChunks;
+    std::vector<ce::Mesh> blacksmithChunkMeshes;
+
+    if (blacksmithChunks.open(chunkedModel) || (ce::ObjStreamConverter::convert(chunkedModel) && blacksmithChunks.open(chunkedModel)))
+    {
+        for (size_t chunk = 0; chunk < blacksmithChunks.getChunkCount(); ++chunk)
+            blacksmithChunkMeshes.push_back(renderer->createMeshChunk(blacksmithChunks, chunk));
+    }
+
+    ce::Mesh nanosuit = renderer->createMesh("../resources/models/nanosuit/nanosuit.obj", ce::MESH_LOAD_OPTIMIZE | ce::MESH_LOAD_LODS | ce::MESH_LOAD_MESHLETS | ce::MESH_LOAD_QUANTIZE | ce::MESH_LOAD_POSITIONS | ce::MESH_LOAD_BVH);
+    ce::MeshDrawList nanosuitDrawList;
+    GLuint quantizedShader = renderer->createShaderProgramFromFiles("../resources/shaders/entity_quantized/vertex.glsl", "../resources/shaders/entity_textured/fragment.glsl");
+    GLuint depthShader = renderer->createShaderProgramFromFiles("../resources/shaders/depth/vertex.glsl", "../resources/shaders/depth/fragment.glsl");
+    GLuint pickShader = renderer->createShaderProgramFromFiles("../resources/shaders/depth/vertex.glsl", "../resources/shaders/pick/fragment.glsl");
+
+    // A crowd of nanosuits, too small on screen to be worth drawing
+    // whole, drawn as quads that show prerendered views instead.
+    GLuint captureShader = renderer->createShaderProgramFromFiles("../resources/shaders/entity_quantized/vertex.glsl", "../resources/shaders/impostor_capture/fragment.glsl");
+    GLuint impostorShader = renderer->createShaderProgramFromFiles("../resources/shaders/impostor/vertex.glsl", "../resources/shaders/impostor/fragment.glsl");
+    ce::MeshImpostor nanosuitImpostor = renderer->createImpostor(nanosuit, captureShader);
+    ce::ImpostorBatch crowd;
 
     GLuint quadVAO = 0;
     GLuint renderedTexture = 0;
@@ -78,18 +101,102 @@ int main()
         renderer->passUniformMatrix(meshShader, "view", view);
         renderer->passUniformMatrix(meshShader, "projection", projection);
 
-        renderer->setActiveTexture(meshTexture);
         renderer->setTextureSampler(meshShader, "text");
+        renderer->drawMesh(blacksmith.get());
+
+        model = glm::mat4(1.0f);
+        model = glm::translate(model, glm::vec3(80.0f, 240.0f, 0.0f));
+        model = glm::rotate(model, (float)glm::radians(glfwGetTime() * 60), glm::vec3(1.0f, 1.0f, 1.0f));
 
-        renderer->drawArrays(meshVAO, 0, meshVertexCount);
+        renderer->passUniformMatrix(meshShader, "model", model);
+
+        for (const ce::Mesh & chunk : blacksmithChunkMeshes)
+            renderer->drawMesh(chunk);
 
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(200.0f, 40.0f, 0.0f));
         model = glm::rotate(model, (float)glm::radians(glfwGetTime() * 60), glm::vec3(1.0f, 1.0f, 1.0f));
         model = glm::scale(model, glm::vec3(4.0f, 4.0f, 4.0f));
 
-        renderer->passUniformMatrix(meshShader, "model", model);
-        renderer->drawArrays(nanosuitVAO, 0, nanosuitVertexCount);
+        ce::MeshletCuller::cull(nanosuit, nanosuit.selectLod(view * model, projection, 640.0f), model, view, projection, nanosuitDrawList);
+
+        // Pick the triangle under the cursor. The framebuffer covers
+        // the whole window, so its viewport is the window's.
+        glm::vec3 rayOrigin, rayDirection;
+        ce::MeshBvh::getPickRay(window.getMousePosition(), window.getSize(), view, projection, rayOrigin, rayDirection);
+
+        ce::MeshRayHit hit;
+        bool picked = ce::MeshBvh::raycast(nanosuit, model, rayOrigin, rayDirection, hit);
+
+        // Depth prepass from the position stream, so that the
+        // textured pass only shades the fragments that are visible.
+        glUseProgram(depthShader);
+
+        renderer->passUniformMatrix(depthShader, "model", model);
+        renderer->passUniformMatrix(depthShader, "view", view);
+        renderer->passUniformMatrix(depthShader, "projection", projection);
+        renderer->passUniformVector(depthShader, "positionScale", nanosuit.format.positionScale);
+        renderer->passUniformVector(depthShader, "positionOffset", nanosuit.format.positionOffset);
+
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        renderer->drawMeshListDepth(nanosuit, nanosuitDrawList);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthFunc(GL_LEQUAL);
+
+        glUseProgram(quantizedShader);
+
+        renderer->passUniformMatrix(quantizedShader, "model", model);
+        renderer->passUniformMatrix(quantizedShader, "view", view);
+        renderer->passUniformMatrix(quantizedShader, "projection", projection);
+
+        renderer->passUniformVector(quantizedShader, "positionScale", nanosuit.format.positionScale);
+        renderer->passUniformVector(quantizedShader, "positionOffset", nanosuit.format.positionOffset);
+        renderer->passUniformVector(quantizedShader, "texCoordScale", nanosuit.format.texCoordScale);
+        renderer->passUniformVector(quantizedShader, "texCoordOffset", nanosuit.format.texCoordOffset);
+
+        renderer->setTextureSampler(quantizedShader, "text");
+        renderer->drawMeshList(nanosuit, nanosuitDrawList);
+
+        // Highlight the picked triangle. It's drawn from the same
+        // position stream as the prepass, so it passes the depth test
+        // where the full mesh is drawn.
+        if (picked && nanosuit.depthVao != 0)
+        {
+            glUseProgram(pickShader);
+
+            renderer->passUniformMatrix(pickShader, "model", model);
+            renderer->passUniformMatrix(pickShader, "view", view);
+            renderer->passUniformMatrix(pickShader, "projection", projection);
+            renderer->passUniformVector(pickShader, "positionScale", nanosuit.format.positionScale);
+            renderer->passUniformVector(pickShader, "positionOffset", nanosuit.format.positionOffset);
+            renderer->passUniformVector(pickShader, "highlightColor", glm::vec3(1.0f, 0.0f, 1.0f));
+
+            glBindVertexArray(nanosuit.depthVao);
+            glDrawElements(GL_TRIANGLES, 3, nanosuit.indexType, (GLvoid *)(uintptr_t)(hit.triangle * 3 * nanosuit.getIndexSize()));
+            glBindVertexArray(0);
+        }
+
+        glDepthFunc(GL_LESS);
+
+        crowd.clear();
+
+        for (unsigned int count = 0; count < 40; ++count)
+        {
+            glm::mat4 instance(1.0f);
+            instance = glm::translate(instance, glm::vec3(10.0f + count * 10.0f, 290.0f, 0.0f));
+            instance = glm::rotate(instance, (float)glm::radians(glfwGetTime() * 60 + count * 9), glm::vec3(0.0f, 1.0f, 0.0f));
+
+            // The orthographic camera looks down -z from everywhere.
+            crowd.addInstance(nanosuitImpostor, instance, glm::vec3(instance[3]) + glm::vec3(0.0f, 0.0f, 100.0f));
+        }
+
+        glUseProgram(impostorShader);
+
+        renderer->passUniformMatrix(impostorShader, "view", view);
+        renderer->passUniformMatrix(impostorShader, "projection", projection);
+
+        renderer->setTextureSampler(impostorShader, "text");
+        renderer->drawImpostors(nanosuitImpostor, crowd);
 
         // Render to the screen
         renderer->bindFrameBuffer(0);
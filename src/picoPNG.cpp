@@ -1,14 +1,226 @@
+#include <cstring>
+#include <cstdint>
 #include "picoPNG.hpp"
+#include "LinearArena.hpp"
+
+//////////////////////////////////////////////////////////////////////////////////
+// SIMD kernels for the loops of picoPNG that run for every byte of an image after
+// inflating it: unfiltering scanlines of 8 bit RGB and RGBA images, and expanding
+// 8 bit RGB and palette images to RGBA. SSE2 is used whenever the compiler
+// targets it (any x86-64 does), AVX2 where the CPU has it, checked at runtime.
+//
+// Every kernel handles what it can from the start of the row and returns how far
+// it got. picoPNG's own loops do the rest, and everything on other CPUs.
+//////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PICOPNG_SSE2
+#include <emmintrin.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PICOPNG_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define PICOPNG_AVX2
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+#endif
+
+namespace pngsimd
+{
+
+#ifdef PICOPNG_AVX2
+static bool hasAvx2()
+{
+#ifdef _MSC_VER
+  static const bool supported = []()
+  {
+    int info[4];
+    __cpuid(info, 1);
+    if(!(info[2] & (1 << 27)) || !(info[2] & (1 << 28))) return false; //no AVX, or the OS doesn't save its registers
+    if((_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+  }();
+#else
+  static const bool supported = __builtin_cpu_supports("avx2") != 0;
+#endif
+  return supported;
+}
+
+PICOPNG_AVX2 static size_t unfilterUpAvx2(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon, size_t length)
+{
+  size_t i = 0;
+  for(; i + 32 <= length; i += 32)
+    _mm256_storeu_si256((__m256i*)(recon + i), _mm256_add_epi8(_mm256_loadu_si256((const __m256i*)(scanline + i)), _mm256_loadu_si256((const __m256i*)(precon + i))));
+  return i;
+}
+
+PICOPNG_AVX2 static size_t convertRGBAvx2(unsigned char* out, const unsigned char* in, size_t numpixels)
+{
+  //8 pixels at a time: 4 from each half of the register, which has to load 4 bytes past the last of them
+  const __m256i shuffle = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const __m256i alpha = _mm256_set1_epi32((int)0xFF000000);
+  size_t i = 0;
+  for(; (i + 8) * 3 + 4 <= numpixels * 3; i += 8)
+  {
+    __m256i pixels = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(in + 3 * i))), _mm_loadu_si128((const __m128i*)(in + 3 * i + 12)), 1);
+    _mm256_storeu_si256((__m256i*)(out + 4 * i), _mm256_or_si256(_mm256_shuffle_epi8(pixels, shuffle), alpha));
+  }
+  return i;
+}
+
+PICOPNG_AVX2 static size_t convertPaletteAvx2(unsigned char* out, const unsigned char* in, size_t numpixels, const unsigned int* colors)
+{
+  size_t i = 0;
+  for(; i + 8 <= numpixels; i += 8)
+  {
+    __m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(in + i)));
+    _mm256_storeu_si256((__m256i*)(out + 4 * i), _mm256_i32gather_epi32((const int*)colors, indices, 4));
+  }
+  return i;
+}
+#endif
+
+#ifdef PICOPNG_SSE2
+template<int BPP> static __m128i loadPixel(const unsigned char* p) { int value = 0; std::memcpy(&value, p, BPP); return _mm_cvtsi32_si128(value); }
+template<int BPP> static void storePixel(unsigned char* p, __m128i pixel) { int value = _mm_cvtsi128_si32(pixel); std::memcpy(p, &value, BPP); }
+
+//Sub, Average and Paeth depend on the pixel to the left, so they go a pixel at a time (as libpng does), doing all of its bytes at once. A missing previous line reads as zeros
+template<int BPP> static size_t unfilterSub(unsigned char* recon, const unsigned char* scanline, size_t length)
+{
+  __m128i left = _mm_setzero_si128();
+  size_t i = 0;
+  for(; i + BPP <= length; i += BPP) { left = _mm_add_epi8(loadPixel<BPP>(scanline + i), left); storePixel<BPP>(recon + i, left); }
+  return i;
+}
+
+template<int BPP> static size_t unfilterAverage(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon, size_t length)
+{
+  const __m128i one = _mm_set1_epi8(1);
+  __m128i left = _mm_setzero_si128(), up = _mm_setzero_si128();
+  size_t i = 0;
+  for(; i + BPP <= length; i += BPP)
+  {
+    if(precon) up = loadPixel<BPP>(precon + i);
+    __m128i average = _mm_sub_epi8(_mm_avg_epu8(left, up), _mm_and_si128(_mm_xor_si128(left, up), one)); //_mm_avg_epu8 rounds up, PNG rounds down
+    left = _mm_add_epi8(loadPixel<BPP>(scanline + i), average);
+    storePixel<BPP>(recon + i, left);
+  }
+  return i;
+}
+
+static __m128i abs16(__m128i value) { __m128i negative = _mm_srai_epi16(value, 15); return _mm_sub_epi16(_mm_xor_si128(value, negative), negative); }
+static __m128i select(__m128i mask, __m128i yes, __m128i no) { return _mm_or_si128(_mm_and_si128(mask, yes), _mm_andnot_si128(mask, no)); }
+
+template<int BPP> static size_t unfilterPaeth(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon, size_t length)
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i a = zero, b = zero, c, d = zero; //left, up, up left and the current pixel, widened to 16 bits
+  size_t i = 0;
+  for(; i + BPP <= length; i += BPP)
+  {
+    c = b; b = precon ? _mm_unpacklo_epi8(loadPixel<BPP>(precon + i), zero) : zero;
+    a = d; d = _mm_unpacklo_epi8(loadPixel<BPP>(scanline + i), zero);
+    __m128i pa = _mm_sub_epi16(b, c), pb = _mm_sub_epi16(a, c), pc = _mm_add_epi16(pa, pb); //p - a, p - b and p - c, for p = a + b - c
+    pa = abs16(pa); pb = abs16(pb); pc = abs16(pc);
+    __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+    __m128i nearest = select(_mm_cmpeq_epi16(smallest, pa), a, select(_mm_cmpeq_epi16(smallest, pb), b, c)); //ties go to a, then b, like paethPredictor
+    d = _mm_and_si128(_mm_add_epi16(d, nearest), _mm_set1_epi16(0xFF));
+    storePixel<BPP>(recon + i, _mm_packus_epi16(d, d));
+  }
+  return i;
+}
+
+static size_t unfilterUpSse2(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon, size_t length)
+{
+  size_t i = 0;
+  for(; i + 16 <= length; i += 16)
+    _mm_storeu_si128((__m128i*)(recon + i), _mm_add_epi8(_mm_loadu_si128((const __m128i*)(scanline + i)), _mm_loadu_si128((const __m128i*)(precon + i))));
+  return i;
+}
+#endif
+
+static size_t unfilter(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon, size_t bytewidth, unsigned long filterType, size_t length)
+{ //returns how many bytes of the line were unfiltered
+#ifdef PICOPNG_SSE2
+  if(filterType == 2 && precon)
+  {
+#ifdef PICOPNG_AVX2
+    if(hasAvx2()) { size_t done = unfilterUpAvx2(recon, scanline, precon, length); return done + unfilterUpSse2(recon + done, scanline + done, precon + done, length - done); }
+#endif
+    return unfilterUpSse2(recon, scanline, precon, length);
+  }
+  if(bytewidth == 3)
+  {
+    if(filterType == 1) return unfilterSub<3>(recon, scanline, length);
+    if(filterType == 3) return unfilterAverage<3>(recon, scanline, precon, length);
+    if(filterType == 4) return unfilterPaeth<3>(recon, scanline, precon, length);
+  }
+  else if(bytewidth == 4)
+  {
+    if(filterType == 1) return unfilterSub<4>(recon, scanline, length);
+    if(filterType == 3) return unfilterAverage<4>(recon, scanline, precon, length);
+    if(filterType == 4) return unfilterPaeth<4>(recon, scanline, precon, length);
+  }
+#endif
+  return 0;
+}
+
+static size_t convertRGB(unsigned char* out, const unsigned char* in, size_t numpixels)
+{ //returns how many pixels were converted, always opaque
+  size_t i = 0;
+#ifdef PICOPNG_AVX2
+  if(hasAvx2()) i = convertRGBAvx2(out, in, numpixels);
+#endif
+#ifdef PICOPNG_SSE2
+  const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+  for(; i + 5 <= numpixels; i += 4) //4 pixels at a time, each loaded with the byte after it, then made opaque
+  {
+    int p[4];
+    for(int j = 0; j < 4; j++) std::memcpy(&p[j], in + 3 * (i + j), 4);
+    _mm_storeu_si128((__m128i*)(out + 4 * i), _mm_or_si128(_mm_setr_epi32(p[0], p[1], p[2], p[3]), alpha));
+  }
+#endif
+  return i;
+}
+
+static size_t convertPalette(unsigned char* out, const unsigned char* in, size_t numpixels, const std::vector<unsigned char>& palette)
+{ //returns how many pixels were converted, none if any index is outside of the palette
+  size_t i = 0;
+#ifdef PICOPNG_SSE2
+  __m128i largest = _mm_setzero_si128();
+  for(; i + 16 <= numpixels; i += 16) largest = _mm_max_epu8(largest, _mm_loadu_si128((const __m128i*)(in + i)));
+  unsigned char lanes[16]; _mm_storeu_si128((__m128i*)lanes, largest);
+  size_t maxindex = 0;
+  for(size_t j = 0; j < 16; j++) maxindex = lanes[j] > maxindex ? lanes[j] : maxindex;
+  for(; i < numpixels; i++) maxindex = in[i] > maxindex ? in[i] : maxindex;
+  if(4 * maxindex >= palette.size()) return 0;
+  unsigned int colors[256] = {0}; //the palette as RGBA words
+  std::memcpy(colors, &palette[0], palette.size());
+  i = 0;
+#ifdef PICOPNG_AVX2
+  if(hasAvx2()) i = convertPaletteAvx2(out, in, numpixels, colors);
+#endif
+  for(; i < numpixels; i++) std::memcpy(out + 4 * i, &colors[in[i]], 4);
+#else
+  (void)out; (void)in; (void)numpixels; (void)palette;
+#endif
+  return i;
+}
+
+} //namespace pngsimd
 
 //////////////////////////////////////////////////////////////////////////////////
 // The following code comes from picoPNG, a decoder for PNGs
 // written by Lode Vandevenne. This was obtained from http://lodev.org/lodepng/
-// The declaration for the below function is in picoPNG.hpp and comes from this source
-// as well.
+// The declarations for the below functions are in picoPNG.hpp, the decoder itself
+// comes from this source as well.
 //
 //////////////////////////////////////////////////////////////////////////////////
 
-int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width, unsigned long& image_height, const unsigned char* in_png, size_t in_size, bool convert_to_rgba32)
+static int picoPNG(std::vector<unsigned char>* out_image, unsigned char* out_pixels, size_t out_size, unsigned long& image_width, unsigned long& image_height, const unsigned char* in_png, size_t in_size, bool convert_to_rgba32, ce::LinearArena* scratch)
 {
   // picoPNG version 20101224
   // Copyright (c) 2005-2010 Lode Vandevenne
@@ -41,195 +253,226 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
   static const unsigned long DISTBASE[30] =  {1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577};
   static const unsigned long DISTEXTRA[30] = {0,0,0,0,1,1,2, 2, 3, 3, 4, 4, 5, 5,  6,  6,  7,  7,  8,  8,   9,   9,  10,  10,  11,  11,  12,   12,   13,   13};
   static const unsigned long CLCL[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15}; //code length code lengths
+  typedef ce::ArenaVector<unsigned char> Bytes; //image sized temporaries, taken from the scratch arena when one is given
   struct Zlib //nested functions for zlib decompression
   {
-    static unsigned long readBitFromStream(size_t& bitp, const unsigned char* bits) { unsigned long result = (bits[bitp >> 3] >> (bitp & 0x7)) & 1; bitp++; return result;}
-    static unsigned long readBitsFromStream(size_t& bitp, const unsigned char* bits, size_t nbits)
+    struct Piece { const unsigned char* data; size_t start, size; }; //an IDAT chunk's data, at start in the zlib stream made of all of them
+    struct BitReader //keeps up to 64 bits of the stream in a buffer, so codes are looked up and consumed many bits at a time instead of bit by bit. The stream is read straight from its pieces, as if they were one
     {
-      unsigned long result = 0;
-      for(size_t i = 0; i < nbits; i++) result += (readBitFromStream(bitp, bits)) << i;
-      return result;
+      const Piece* pieces; size_t numpieces, piece; const unsigned char* in; size_t start, end; //the piece the stream is being read from, and where it starts and ends in the stream
+      size_t size, pos; uint64_t buffer; unsigned long count; //pos is the first byte not in the buffer yet
+      BitReader(const Piece* parts, size_t numparts, size_t length) : pieces(parts), numpieces(numparts), piece(0), in(0), start(0), end(0), size(length), pos(0), buffer(0), count(0) { if(numpieces) setPiece(0); }
+      void setPiece(size_t p) { piece = p; in = pieces[p].data; start = pieces[p].start; end = start + pieces[p].size; }
+      void seek(size_t p) { while(p < start && piece > 0) setPiece(piece - 1); while(p >= end && piece + 1 < numpieces) setPiece(piece + 1); }
+      unsigned char byteAt(size_t p) { if(p < start || p >= end) seek(p); return (p >= start && p < end) ? in[p - start] : 0; }
+      void copy(unsigned char* out, size_t p, size_t length) { while(length) { seek(p); size_t n = end - p < length ? end - p : length; std::memcpy(out, &in[p - start], n); out += n; p += n; length -= n; } } //only for bytes inside the stream
+      void refill() //tops the buffer up to at least 56 bits, which is enough for a length and a distance with their extra bits. Past the end of the stream, zeros come in
+      {
+        if(count >= 56) return;
+        if(pos >= start && pos + 8 <= end)
+        {
+          uint64_t word = 0;
+          for(int i = 7; i >= 0; i--) word = (word << 8) | in[pos - start + i]; //little endian load, a single move for most compilers
+          buffer |= word << count; pos += (63 - count) >> 3; count |= 56; //the partial byte left above count is loaded again (to the same bits) next time
+        }
+        else while(count <= 56) { buffer |= (uint64_t)byteAt(pos) << count; pos++; count += 8; } //near the end of a piece, byte by byte
+      }
+      unsigned long get(unsigned long nbits) { unsigned long result = (unsigned long)(buffer & ((1ull << nbits) - 1)); buffer >>= nbits; count -= nbits; return result; } //only after a refill
+      void consume(unsigned long nbits) { buffer >>= nbits; count -= nbits; }
+      size_t bitPosition() const { return pos * 8 - count; }
+      bool pastEnd() const { return bitPosition() > size * 8; }
+    };
+    static unsigned long reverseBits(unsigned long value, unsigned long nbits) //Huffman codes are packed starting from their most significant bit
+    {
+      value = ((value & 0xAAAA) >> 1) | ((value & 0x5555) << 1);
+      value = ((value & 0xCCCC) >> 2) | ((value & 0x3333) << 2);
+      value = ((value & 0xF0F0) >> 4) | ((value & 0x0F0F) << 4);
+      value = ((value & 0xFF00) >> 8) | ((value & 0x00FF) << 8);
+      return value >> (16 - nbits);
     }
-    struct HuffmanTree
+    struct HuffmanTree //canonical Huffman code: codes of up to FASTBITS bits are decoded with one table lookup, longer ones by comparing against the first code of every length
     {
-      int makeFromLengths(const std::vector<unsigned long>& bitlen, unsigned long maxbitlen)
-      { //make tree given the lengths
-        unsigned long numcodes = (unsigned long)(bitlen.size()), treepos = 0, nodefilled = 0;
-        std::vector<unsigned long> tree1d(numcodes), blcount(maxbitlen + 1, 0), nextcode(maxbitlen + 1, 0);
-        for(unsigned long bits = 0; bits < numcodes; bits++) blcount[bitlen[bits]]++; //count number of instances of each code length
-        for(unsigned long bits = 1; bits <= maxbitlen; bits++) nextcode[bits] = (nextcode[bits - 1] + blcount[bits - 1]) << 1;
-        for(unsigned long n = 0; n < numcodes; n++) if(bitlen[n] != 0) tree1d[n] = nextcode[bitlen[n]]++; //generate all the codes
-        tree2d.clear(); tree2d.resize(numcodes * 2, 32767); //32767 here means the tree2d isn't filled there yet
-        for(unsigned long n = 0; n < numcodes; n++) //the codes
-        for(unsigned long i = 0; i < bitlen[n]; i++) //the bits for this code
+      enum { FASTBITS = 10, MAXCODES = 288 };
+      int makeFromLengths(const unsigned long* bitlen, size_t numcodes)
+      { //make the tables given the lengths
+        unsigned long blcount[16] = {0}, nextcode[16] = {0}, code = 0, symbols = 0;
+        for(size_t n = 0; n < numcodes; n++) blcount[bitlen[n]]++; //count number of instances of each code length
+        std::memset(fast, 0, sizeof(fast)); std::memset(sizes, 0, sizeof(sizes));
+        for(unsigned long bits = 1; bits < 16; bits++)
         {
-          unsigned long bit = (tree1d[n] >> (bitlen[n] - i - 1)) & 1;
-          if(treepos > numcodes - 2) return 55;
-          if(tree2d[2 * treepos + bit] == 32767) //not yet filled in
-          {
-            if(i + 1 == bitlen[n]) { tree2d[2 * treepos + bit] = n; treepos = 0; } //last bit
-            else { tree2d[2 * treepos + bit] = ++nodefilled + numcodes; treepos = nodefilled; } //addresses are encoded as values > numcodes
-          }
-          else treepos = tree2d[2 * treepos + bit] - numcodes; //subtract numcodes from address to get address value
+          nextcode[bits] = code; firstcode[bits] = code; firstsymbol[bits] = symbols;
+          code += blcount[bits];
+          if(blcount[bits] && code > (1ul << bits)) return 55; //more codes of this length than there are bits for
+          maxcode[bits] = code << (16 - bits); //codes of this length are below this, when read 16 bits at a time
+          code <<= 1; symbols += blcount[bits];
+        }
+        maxcode[16] = 0x10000;
+        for(size_t n = 0; n < numcodes; n++) if(bitlen[n] != 0)
+        {
+          unsigned long length = bitlen[n], index = nextcode[length] - firstcode[length] + firstsymbol[length];
+          sizes[index] = (unsigned char)length; symbolsByCode[index] = (unsigned short)n;
+          if(length <= FASTBITS) //the code fills every entry whose low bits are the code, read from the stream
+            for(unsigned long j = reverseBits(nextcode[length], length); j < (1ul << FASTBITS); j += (1ul << length)) fast[j] = (unsigned short)((n << 4) | length);
+          nextcode[length]++;
         }
         return 0;
       }
-      int decode(bool& decoded, unsigned long& result, size_t& treepos, unsigned long bit) const
-      { //Decodes a symbol from the tree
-        unsigned long numcodes = (unsigned long)tree2d.size() / 2;
-        if(treepos >= numcodes) return 11; //error: you appeared outside the codetree
-        result = tree2d[2 * treepos + bit];
-        decoded = (result < numcodes);
-        treepos = decoded ? 0 : result - numcodes;
-        return 0;
+      int decode(BitReader& reader) const
+      { //Decodes a symbol from at least 15 bits in the buffer, returns -1 for codes that aren't in the tree
+        unsigned long entry = fast[reader.buffer & ((1u << FASTBITS) - 1)];
+        if(entry) { reader.consume(entry & 15); return (int)(entry >> 4); }
+        unsigned long code = reverseBits((unsigned long)(reader.buffer & 0xFFFF), 16), length = FASTBITS + 1;
+        while(code >= maxcode[length]) length++;
+        if(length >= 16) return -1;
+        unsigned long index = (code >> (16 - length)) - firstcode[length] + firstsymbol[length];
+        if(index >= MAXCODES || sizes[index] != length) return -1;
+        reader.consume(length);
+        return symbolsByCode[index];
       }
-      std::vector<unsigned long> tree2d; //2D representation of a huffman tree: The one dimension is "0" or "1", the other contains all nodes and leaves of the tree.
+      unsigned short fast[1 << FASTBITS]; //symbol << 4 | code length, 0 for codes longer than FASTBITS
+      unsigned long firstcode[17], firstsymbol[17], maxcode[17]; //by code length
+      unsigned char sizes[MAXCODES]; unsigned short symbolsByCode[MAXCODES]; //code lengths and symbols, sorted by code
     };
-    struct Inflator
+    struct Inflator //inflates into a window that the caller empties whenever it runs full, so the whole inflated stream never has to be held at once
     {
-      int error;
-      void inflate(std::vector<unsigned char>& out, const std::vector<unsigned char>& in, size_t inpos = 0)
+      int error; BitReader reader;
+      unsigned long BFINAL; int block; size_t storedleft; //what's being inflated: 0 between blocks, 1 a Huffman block, 2 a stored block with storedleft bytes still to copy
+      Inflator(const Piece* pieces, size_t numpieces, size_t size) : error(0), reader(pieces, numpieces, size), BFINAL(0), block(0), storedleft(0) {}
+      int start() //reads the zlib header, returns error value
       {
-        size_t bp = 0, pos = 0; //bit pointer and byte pointer
-        error = 0;
-        unsigned long BFINAL = 0;
-        while(!BFINAL && !error)
+        if(reader.size < 2) { return 53; } //error, size of zlib data too small
+        unsigned long in0 = reader.byteAt(0), in1 = reader.byteAt(1);
+        if((in0 * 256 + in1) % 31 != 0) { return 24; } //error: 256 * in[0] + in[1] must be a multiple of 31, the FCHECK value is supposed to be made that way
+        unsigned long CM = in0 & 15, CINFO = (in0 >> 4) & 15, FDICT = (in1 >> 5) & 1;
+        if(CM != 8 || CINFO > 7) { return 25; } //error: only compression method 8: inflate with sliding window of 32k is supported by the PNG spec
+        if(FDICT != 0) { return 26; } //error: the specification of PNG says about the zlib stream: "The additional flags shall not specify a preset dictionary."
+        reader.pos = 2; //note: adler32 checksum is skipped and ignored
+        return 0;
+      }
+      bool inflate(unsigned char* out, size_t& pos, size_t outsize)
+      { //inflates into out from pos on. Returns true once the stream has ended (or on an error), false when out is too full for the longest run: then it continues where it stopped once room is made, with the last 32K of it left in front of pos
+        while(!error)
         {
-          if(bp >> 3 >= in.size()) { error = 52; return; } //error, bit pointer will jump past memory
-          BFINAL = readBitFromStream(bp, &in[inpos]);
-          unsigned long BTYPE = readBitFromStream(bp, &in[inpos]); BTYPE += 2 * readBitFromStream(bp, &in[inpos]);
-          if(BTYPE == 3) { error = 20; return; } //error: invalid BTYPE
-          else if(BTYPE == 0) inflateNoCompression(out, &in[inpos], bp, pos, in.size());
-          else inflateHuffmanBlock(out, &in[inpos], bp, pos, in.size(), BTYPE);
+          if(block == 1 && !inflateHuffmanBlock(out, pos, outsize)) return false;
+          if(block == 2 && !inflateNoCompression(out, pos, outsize)) return false;
+          block = 0;
+          if(error || BFINAL) break;
+          if(reader.bitPosition() >> 3 >= reader.size) { error = 52; break; } //error, bit pointer will jump past memory
+          reader.refill();
+          BFINAL = reader.get(1);
+          unsigned long BTYPE = reader.get(2);
+          if(BTYPE == 3) { error = 20; break; } //error: invalid BTYPE
+          else if(BTYPE == 0) startNoCompression();
+          else if(BTYPE == 1) { generateFixedTrees(codetree, codetreeD); block = 1; }
+          else { getTreeInflateDynamic(codetree, codetreeD, reader); block = 1; }
         }
-        if(!error) out.resize(pos); //Only now we know the true size of out, resize it to that
+        return true;
       }
       void generateFixedTrees(HuffmanTree& tree, HuffmanTree& treeD) //get the tree of a deflated block with fixed tree
       {
-        std::vector<unsigned long> bitlen(288, 8), bitlenD(32, 5);;
-        for(size_t i = 144; i <= 255; i++) bitlen[i] = 9;
-        for(size_t i = 256; i <= 279; i++) bitlen[i] = 7;
-        tree.makeFromLengths(bitlen, 15);
-        treeD.makeFromLengths(bitlenD, 15);
+        unsigned long bitlen[288], bitlenD[32];
+        for(size_t i = 0; i < 288; i++) bitlen[i] = (i >= 144 && i <= 255) ? 9 : (i >= 256 && i <= 279) ? 7 : 8;
+        for(size_t i = 0; i < 32; i++) bitlenD[i] = 5;
+        tree.makeFromLengths(bitlen, 288);
+        treeD.makeFromLengths(bitlenD, 32);
       }
       HuffmanTree codetree, codetreeD, codelengthcodetree; //the code tree for Huffman codes, dist codes, and code length codes
-      unsigned long huffmanDecodeSymbol(const unsigned char* in, size_t& bp, const HuffmanTree& codetree, size_t inlength)
-      { //decode a single symbol from given list of bits with given code tree. return value is the symbol
-        bool decoded; unsigned long ct;
-        for(size_t treepos = 0;;)
-        {
-          if((bp & 0x07) == 0 && (bp >> 3) > inlength) { error = 10; return 0; } //error: end reached without endcode
-          error = codetree.decode(decoded, ct, treepos, readBitFromStream(bp, in)); if(error) return 0; //stop, an error happened
-          if(decoded) return ct;
-        }
-      }
-      void getTreeInflateDynamic(HuffmanTree& tree, HuffmanTree& treeD, const unsigned char* in, size_t& bp, size_t inlength)
+      void getTreeInflateDynamic(HuffmanTree& tree, HuffmanTree& treeD, BitReader& reader)
       { //get the tree of a deflated block with dynamic tree, the tree itself is also Huffman compressed with a known tree
-        std::vector<unsigned long> bitlen(288, 0), bitlenD(32, 0);
-        if(bp >> 3 >= inlength - 2) { error = 49; return; } //the bit pointer is or will go past the memory
-        size_t HLIT =  readBitsFromStream(bp, in, 5) + 257; //number of literal/length codes + 257
-        size_t HDIST = readBitsFromStream(bp, in, 5) + 1; //number of dist codes + 1
-        size_t HCLEN = readBitsFromStream(bp, in, 4) + 4; //number of code length codes + 4
-        std::vector<unsigned long> codelengthcode(19); //lengths of tree to decode the lengths of the dynamic tree
-        for(size_t i = 0; i < 19; i++) codelengthcode[CLCL[i]] = (i < HCLEN) ? readBitsFromStream(bp, in, 3) : 0;
-        error = codelengthcodetree.makeFromLengths(codelengthcode, 7); if(error) return;
+        unsigned long bitlen[288 + 32] = {0}; //the lengths of the literal/length codes, followed by those of the dist codes
+        if((reader.bitPosition() >> 3) + 2 >= reader.size) { error = 49; return; } //the bit pointer is or will go past the memory
+        reader.refill();
+        size_t HLIT =  reader.get(5) + 257; //number of literal/length codes + 257
+        size_t HDIST = reader.get(5) + 1; //number of dist codes + 1
+        size_t HCLEN = reader.get(4) + 4; //number of code length codes + 4
+        unsigned long codelengthcode[19] = {0}; //lengths of tree to decode the lengths of the dynamic tree
+        for(size_t i = 0; i < HCLEN; i++) { if(reader.count < 3) reader.refill(); codelengthcode[CLCL[i]] = reader.get(3); }
+        error = codelengthcodetree.makeFromLengths(codelengthcode, 19); if(error) return;
         size_t i = 0, replength;
         while(i < HLIT + HDIST)
         {
-          unsigned long code = huffmanDecodeSymbol(in, bp, codelengthcodetree, inlength); if(error) return;
-          if(code <= 15)  { if(i < HLIT) bitlen[i++] = code; else bitlenD[i++ - HLIT] = code; } //a length code
+          reader.refill();
+          int code = codelengthcodetree.decode(reader);
+          if(code < 0) { error = 11; return; } //error: the code isn't in the codetree
+          if(code <= 15) bitlen[i++] = code; //a length code
           else if(code == 16) //repeat previous
           {
-            if(bp >> 3 >= inlength) { error = 50; return; } //error, bit pointer jumps past memory
-            replength = 3 + readBitsFromStream(bp, in, 2);
-            unsigned long value; //set value to the previous code
-            if((i - 1) < HLIT) value = bitlen[i - 1];
-            else value = bitlenD[i - HLIT - 1];
-            for(size_t n = 0; n < replength; n++) //repeat this value in the next lengths
-            {
-              if(i >= HLIT + HDIST) { error = 13; return; } //error: i is larger than the amount of codes
-              if(i < HLIT) bitlen[i++] = value; else bitlenD[i++ - HLIT] = value;
-            }
+            if(i == 0) { error = 54; return; } //error: there is no previous length to repeat
+            replength = 3 + reader.get(2);
+            if(i + replength > HLIT + HDIST) { error = 13; return; } //error: i is larger than the amount of codes
+            for(size_t n = 0; n < replength; n++, i++) bitlen[i] = bitlen[i - 1]; //repeat this value in the next lengths
           }
           else if(code == 17) //repeat "0" 3-10 times
           {
-            if(bp >> 3 >= inlength) { error = 50; return; } //error, bit pointer jumps past memory
-            replength = 3 + readBitsFromStream(bp, in, 3);
-            for(size_t n = 0; n < replength; n++) //repeat this value in the next lengths
-            {
-              if(i >= HLIT + HDIST) { error = 14; return; } //error: i is larger than the amount of codes
-              if(i < HLIT) bitlen[i++] = 0; else bitlenD[i++ - HLIT] = 0;
-            }
+            replength = 3 + reader.get(3);
+            if(i + replength > HLIT + HDIST) { error = 14; return; } //error: i is larger than the amount of codes
+            i += replength; //the lengths are zero already
           }
           else if(code == 18) //repeat "0" 11-138 times
           {
-            if(bp >> 3 >= inlength) { error = 50; return; } //error, bit pointer jumps past memory
-            replength = 11 + readBitsFromStream(bp, in, 7);
-            for(size_t n = 0; n < replength; n++) //repeat this value in the next lengths
-            {
-              if(i >= HLIT + HDIST) { error = 15; return; } //error: i is larger than the amount of codes
-              if(i < HLIT) bitlen[i++] = 0; else bitlenD[i++ - HLIT] = 0;
-            }
+            replength = 11 + reader.get(7);
+            if(i + replength > HLIT + HDIST) { error = 15; return; } //error: i is larger than the amount of codes
+            i += replength;
           }
           else { error = 16; return; } //error: somehow an unexisting code appeared. This can never happen.
+          if(reader.pastEnd()) { error = 50; return; } //error, bit pointer jumps past memory
         }
         if(bitlen[256] == 0) { error = 64; return; } //the length of the end code 256 must be larger than 0
-        error = tree.makeFromLengths(bitlen, 15); if(error) return; //now we've finally got HLIT and HDIST, so generate the code trees, and the function is done
-        error = treeD.makeFromLengths(bitlenD, 15); if(error) return;
+        error = tree.makeFromLengths(bitlen, HLIT); if(error) return; //now we've finally got HLIT and HDIST, so generate the code trees, and the function is done
+        error = treeD.makeFromLengths(bitlen + HLIT, HDIST); if(error) return;
       }
-      void inflateHuffmanBlock(std::vector<unsigned char>& out, const unsigned char* in, size_t& bp, size_t& pos, size_t inlength, unsigned long btype) 
+      bool inflateHuffmanBlock(unsigned char* out, size_t& pos, size_t outsize) //returns false when out runs full before the end code
       {
-        if(btype == 1) { generateFixedTrees(codetree, codetreeD); }
-        else if(btype == 2) { getTreeInflateDynamic(codetree, codetreeD, in, bp, inlength); if(error) return; }
+        BitReader local = reader; //a local copy, which the compiler can keep in registers even though the output bytes could alias it
+        bool ended = true;
         for(;;)
         {
-          unsigned long code = huffmanDecodeSymbol(in, bp, codetree, inlength); if(error) return;
-          if(code == 256) return; //end code
-          else if(code <= 255) //literal symbol
-          {
-            if(pos >= out.size()) out.resize((pos + 1) * 2); //reserve more room
-            out[pos++] = (unsigned char)(code);
-          }
+          if(outsize - pos < 258) { ended = false; break; } //no room for the longest run
+          local.refill(); //enough for the longest length code, distance code and their extra bits
+          int code = codetree.decode(local);
+          if(code < 0) { error = 11; break; } //error: the code isn't in the codetree
+          if(local.pastEnd()) { error = 10; break; } //error: end reached without endcode
+          if(code == 256) break; //end code
+          else if(code <= 255) out[pos++] = (unsigned char)(code); //literal symbol
           else if(code >= 257 && code <= 285) //length code
           {
-            size_t length = LENBASE[code - 257], numextrabits = LENEXTRA[code - 257];
-            if((bp >> 3) >= inlength) { error = 51; return; } //error, bit pointer will jump past memory
-            length += readBitsFromStream(bp, in, numextrabits);
-            unsigned long codeD = huffmanDecodeSymbol(in, bp, codetreeD, inlength); if(error) return;
-            if(codeD > 29) { error = 18; return; } //error: invalid dist code (30-31 are never used)
-            unsigned long dist = DISTBASE[codeD], numextrabitsD = DISTEXTRA[codeD];
-            if((bp >> 3) >= inlength) { error = 51; return; } //error, bit pointer will jump past memory
-            dist += readBitsFromStream(bp, in, numextrabitsD);
-            size_t start = pos, back = start - dist; //backwards
-            if(pos + length >= out.size()) out.resize((pos + length) * 2); //reserve more room
-            for(size_t i = 0; i < length; i++) { out[pos++] = out[back++]; if(back >= start) back = start - dist; }
+            size_t length = LENBASE[code - 257] + local.get(LENEXTRA[code - 257]);
+            int codeD = codetreeD.decode(local);
+            if(codeD < 0) { error = 11; break; } //error: the code isn't in the codetree
+            if(codeD > 29) { error = 18; break; } //error: invalid dist code (30-31 are never used)
+            size_t dist = DISTBASE[codeD] + local.get(DISTEXTRA[codeD]);
+            if(local.pastEnd()) { error = 51; break; } //error, bit pointer will jump past memory
+            if(dist > pos) { error = 52; break; } //error: the distance reaches back before the start of the data
+            unsigned char* run = out + pos;
+            if(dist >= 8 && pos + length + 8 <= outsize) //8 bytes at a time. Runs that repeat themselves read what the previous copy wrote
+              for(size_t i = 0; i < length; i += 8) std::memcpy(run + i, run + i - dist, 8);
+            else if(dist == 1) std::memset(run, run[-1], length);
+            else for(size_t i = 0; i < length; i++) run[i] = run[i - dist];
+            pos += length;
           }
         }
+        reader = local;
+        return ended;
       }
-      void inflateNoCompression(std::vector<unsigned char>& out, const unsigned char* in, size_t& bp, size_t& pos, size_t inlength)
+      void startNoCompression()
       {
-        while((bp & 0x7) != 0) bp++; //go to first boundary of byte
-        size_t p = bp / 8;
-        if(p >= inlength - 4) { error = 52; return; } //error, bit pointer will jump past memory
-        unsigned long LEN = in[p] + 256 * in[p + 1], NLEN = in[p + 2] + 256 * in[p + 3]; p += 4;
+        reader.consume(reader.count & 7); //go to first boundary of byte
+        size_t p = reader.pos - reader.count / 8; //the whole bytes left in the buffer are read from the stream instead
+        if(p + 4 > reader.size) { error = 52; return; } //error, bit pointer will jump past memory
+        unsigned long LEN = reader.byteAt(p) + 256 * reader.byteAt(p + 1), NLEN = reader.byteAt(p + 2) + 256 * reader.byteAt(p + 3); p += 4;
         if(LEN + NLEN != 65535) { error = 21; return; } //error: NLEN is not one's complement of LEN
-        if(pos + LEN >= out.size()) out.resize(pos + LEN);
-        if(p + LEN > inlength) { error = 23; return; } //error: reading outside of in buffer
-        for(unsigned long n = 0; n < LEN; n++) out[pos++] = in[p++]; //read LEN bytes of literal data
-        bp = p * 8;
+        if(p + LEN > reader.size) { error = 23; return; } //error: reading outside of in buffer
+        reader.pos = p; reader.buffer = 0; reader.count = 0;
+        storedleft = LEN; block = 2;
+      }
+      bool inflateNoCompression(unsigned char* out, size_t& pos, size_t outsize) //returns false when out runs full before the block is copied
+      {
+        size_t length = outsize - pos < storedleft ? outsize - pos : storedleft;
+        if(length) reader.copy(&out[pos], reader.pos, length); //read the literal data
+        pos += length; reader.pos += length; storedleft -= length;
+        return storedleft == 0;
       }
     };
-    int decompress(std::vector<unsigned char>& out, const std::vector<unsigned char>& in) //returns error value
-    {
-      Inflator inflator;
-      if(in.size() < 2) { return 53; } //error, size of zlib data too small
-      if((in[0] * 256 + in[1]) % 31 != 0) { return 24; } //error: 256 * in[0] + in[1] must be a multiple of 31, the FCHECK value is supposed to be made that way
-      unsigned long CM = in[0] & 15, CINFO = (in[0] >> 4) & 15, FDICT = (in[1] >> 5) & 1;
-      if(CM != 8 || CINFO > 7) { return 25; } //error: only compression method 8: inflate with sliding window of 32k is supported by the PNG spec
-      if(FDICT != 0) { return 26; } //error: the specification of PNG says about the zlib stream: "The additional flags shall not specify a preset dictionary."
-      inflator.inflate(out, in, 2);
-      return inflator.error; //note: adler32 checksum was skipped and ignored
-    }
   };
   struct PNG //nested functions for PNG decoding
   {
@@ -240,24 +483,28 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
       std::vector<unsigned char> palette;
     } info;
     int error;
-    void decode(std::vector<unsigned char>& out, const unsigned char* in, size_t size, bool convert_to_rgba32)
-    {
+    ce::LinearArena* scratch;
+    void decode(std::vector<unsigned char>* out, unsigned char* pixels, size_t pixelsize, const unsigned char* in, size_t size, bool convert_to_rgba32)
+    { //decodes into out, or as RGBA into the pixels buffer when out is 0. With neither, only the header is read
       error = 0;
       if(size == 0 || in == 0) { error = 48; return; } //the given data is empty
       readPngHeader(&in[0], size); if(error) return;
+      if(!out && !pixels) return;
       size_t pos = 33; //first byte of the first chunk after the header
-      std::vector<unsigned char> idat; //the data from idat chunks
+      std::vector<Zlib::Piece> idat; //where the data of the idat chunks is, it's inflated from there without gathering it first
+      size_t idatsize = 0;
       bool IEND = false, known_type = true;
       info.key_defined = false;
-      while(!IEND) //loop through the chunks, ignoring unknown chunks and stopping at IEND chunk. IDAT data is put at the start of the in buffer
+      while(!IEND) //loop through the chunks, ignoring unknown chunks and stopping at IEND chunk
       {
         if(pos + 8 >= size) { error = 30; return; } //error: size of the in buffer too small to contain next chunk
         size_t chunkLength = read32bitInt(&in[pos]); pos += 4;
         if(chunkLength > 2147483647) { error = 63; return; }
-        if(pos + chunkLength >= size) { error = 35; return; } //error: size of the in buffer too small to contain next chunk
+        if(pos + chunkLength + 4 > size) { error = 35; return; } //error: size of the in buffer too small to contain next chunk
         if(in[pos + 0] == 'I' && in[pos + 1] == 'D' && in[pos + 2] == 'A' && in[pos + 3] == 'T') //IDAT chunk, containing compressed image data
         {
-          idat.insert(idat.end(), &in[pos + 4], &in[pos + 4 + chunkLength]);
+          Zlib::Piece piece = { &in[pos + 4], idatsize, chunkLength };
+          idat.push_back(piece); idatsize += chunkLength;
           pos += (4 + chunkLength);
         }
         else if(in[pos + 0] == 'I' && in[pos + 1] == 'E' && in[pos + 2] == 'N' && in[pos + 3] == 'D')  { pos += 4; IEND = true; }
@@ -304,51 +551,65 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
         pos += 4; //step over CRC (which is ignored)
       }
       unsigned long bpp = getBpp(info);
-      std::vector<unsigned char> scanlines(((info.width * (info.height * bpp + 7)) / 8) + info.height); //now the out buffer will be filled
-      Zlib zlib; //decompress with the Zlib decompressor
-      error = zlib.decompress(scanlines, idat); if(error) return; //stop if the zlib decompressor returned an error
-      size_t bytewidth = (bpp + 7) / 8, outlength = (info.height * info.width * bpp + 7) / 8;
-      out.resize(outlength); //time to fill the out buffer
-      unsigned char* out_ = outlength ? &out[0] : 0; //use a regular pointer to the std::vector for faster code if compiled without optimization
-      if(info.interlaceMethod == 0) //no interlace, just filter
+      size_t bytewidth = (bpp + 7) / 8, linelength = (info.width * bpp + 7) / 8; //length in bytes of a scanline, excluding the filtertype byte
+      bool converting = convert_to_rgba32 && (info.colorType != 6 || info.bitDepth != 8), interlaced = info.interlaceMethod == 1;
+      size_t outlength = converting ? 4 * info.width * info.height : (info.height * info.width * bpp + 7) / 8;
+      if(out) { out->resize(outlength); pixels = &(*out)[0]; } //time to fill the out buffer
+      else if(pixelsize < outlength) { error = 84; return; } //error: the buffer is too small for the image
+      bool direct = out && !converting && bpp >= 8; //unfiltered in place, against the line above. Other buffers are only ever written to, they could be slow to read like a mapped buffer
+      if(!converting && bpp < 8) std::memset(pixels, 0, outlength); //its bits are set one by one
+      size_t passstart[8] = {0}, passw[7] = { (info.width + 7) / 8, (info.width + 3) / 8, (info.width + 3) / 4, (info.width + 1) / 4, (info.width + 1) / 2, (info.width + 0) / 2, (info.width + 0) / 1 };
+      size_t passh[7] = { (info.height + 7) / 8, (info.height + 7) / 8, (info.height + 3) / 8, (info.height + 3) / 4, (info.height + 1) / 4, (info.height + 1) / 2, (info.height + 0) / 2 };
+      for(int i = 0; i < 7; i++) passstart[i + 1] = passstart[i] + passh[i] * ((passw[i] ? 1 : 0) + (passw[i] * bpp + 7) / 8);
+      Zlib::Inflator inflator(idat.empty() ? 0 : &idat[0], idat.size(), idatsize); //decompress with the Zlib decompressor
+      error = inflator.start(); if(error) return;
+      Bytes window((1 << 17) + 1 + linelength, 0, scratch); //the inflated data: scanlines are unfiltered as soon as they're complete, and the last 32K is kept for back references
+      Bytes scanlines(interlaced ? passstart[7] : 0, 0, scratch); //the passes of an interlaced image are gathered whole first
+      Bytes linen(linelength + 1, 0, scratch), lineo(linelength + 1, 0, scratch); //"new" and "old" unfiltered scanline, when they aren't unfiltered in place
+      unsigned char *recon = &linen[0], *precon = &lineo[0];
+      size_t filled = 0, used = 0, gathered = 0, obp = 0; //bytes in the window, how many of them are unfiltered or gathered, and the total gathered
+      unsigned long y = 0; //the next scanline
+      for(bool ended = false; !ended;)
       {
-        size_t linestart = 0, linelength = (info.width * bpp + 7) / 8; //length in bytes of a scanline, excluding the filtertype byte
-        if(bpp >= 8) //byte per byte
-        for(unsigned long y = 0; y < info.height; y++)
+        ended = inflator.inflate(&window[0], filled, window.size());
+        error = inflator.error; if(error) return; //stop if the zlib decompressor returned an error
+        if(interlaced)
         {
-          unsigned long filterType = scanlines[linestart];
-          const unsigned char* prevline = (y == 0) ? 0 : &out_[(y - 1) * info.width * bytewidth];
-          unFilterScanline(&out_[linestart - y], &scanlines[linestart + 1], prevline, bytewidth, filterType,  linelength); if(error) return;
-          linestart += (1 + linelength); //go to start of next scanline
+          size_t length = filled - used < scanlines.size() - gathered ? filled - used : scanlines.size() - gathered;
+          if(length) std::memcpy(&scanlines[gathered], &window[used], length);
+          gathered += length; used = filled;
         }
-        else //less than 8 bits per pixel, so fill it up bit per bit
+        else for(; y < info.height && used + 1 + linelength <= filled; y++, used += 1 + linelength)
         {
-          std::vector<unsigned char> templine((info.width * bpp + 7) >> 3); //only used if bpp < 8
-          for(size_t y = 0, obp = 0; y < info.height; y++)
+          unsigned long filterType = window[used];
+          if(direct)
           {
-            unsigned long filterType = scanlines[linestart];
-            const unsigned char* prevline = (y == 0) ? 0 : &out_[(y - 1) * info.width * bytewidth];
-            unFilterScanline(&templine[0], &scanlines[linestart + 1], prevline, bytewidth, filterType, linelength); if(error) return;
-            for(size_t bp = 0; bp < info.width * bpp;) setBitOfReversedStream(obp, out_, readBitFromReversedStream(bp, &templine[0]));
-            linestart += (1 + linelength); //go to start of next scanline
+            unsigned char* line = &pixels[y * linelength];
+            unFilterScanline(line, &window[used + 1], (y == 0) ? 0 : line - linelength, bytewidth, filterType, linelength); if(error) return;
+            continue;
           }
+          unFilterScanline(recon, &window[used + 1], (y == 0) ? 0 : precon, bytewidth, filterType, linelength); if(error) return;
+          if(converting) { error = convert(&pixels[4 * info.width * y], recon, info, info.width, 1); if(error) return; }
+          else if(bpp >= 8) std::memcpy(&pixels[y * linelength], recon, linelength);
+          else for(size_t bp = 0; bp < info.width * bpp;) setBitOfReversedStream(obp, pixels, readBitFromReversedStream(bp, recon)); //less than 8 bits per pixel, so fill it up bit per bit
+          unsigned char* temp = recon; recon = precon; precon = temp;
         }
+        size_t from = filled > 32768 ? (filled - 32768 < used ? filled - 32768 : used) : 0; //make room, keeping what's still to be unfiltered and the last 32K
+        if(!ended && from) { std::memmove(&window[0], &window[from], filled - from); filled -= from; used -= from; }
       }
-      else //interlaceMethod is 1 (Adam7)
+      if(interlaced ? gathered < scanlines.size() : y < info.height) { error = 91; return; } //error: the image data ends before the last scanline
+      if(interlaced) //interlaceMethod is 1 (Adam7)
       {
-        size_t passw[7] = { (info.width + 7) / 8, (info.width + 3) / 8, (info.width + 3) / 4, (info.width + 1) / 4, (info.width + 1) / 2, (info.width + 0) / 2, (info.width + 0) / 1 };
-        size_t passh[7] = { (info.height + 7) / 8, (info.height + 7) / 8, (info.height + 3) / 8, (info.height + 3) / 4, (info.height + 1) / 4, (info.height + 1) / 2, (info.height + 0) / 2 };
-        size_t passstart[7] = {0};
         size_t pattern[28] = {0,4,0,2,0,1,0,0,0,4,0,2,0,1,8,8,4,4,2,2,1,8,8,8,4,4,2,2}; //values for the adam7 passes
-        for(int i = 0; i < 6; i++) passstart[i + 1] = passstart[i] + passh[i] * ((passw[i] ? 1 : 0) + (passw[i] * bpp + 7) / 8);
-        std::vector<unsigned char> scanlineo((info.width * bpp + 7) / 8), scanlinen((info.width * bpp + 7) / 8); //"old" and "new" scanline
+        size_t rawlength = (info.height * info.width * bpp + 7) / 8;
+        Bytes raw(direct ? 0 : rawlength, 0, scratch); //the passes scatter their pixels, so they go straight in only when unfiltering in place
+        unsigned char* image = direct ? pixels : &raw[0];
+        Bytes scanlineo((info.width * bpp + 7) / 8, 0, scratch), scanlinen((info.width * bpp + 7) / 8, 0, scratch); //"old" and "new" scanline
         for(int i = 0; i < 7; i++)
-          adam7Pass(&out_[0], &scanlinen[0], &scanlineo[0], &scanlines[passstart[i]], info.width, pattern[i], pattern[i + 7], pattern[i + 14], pattern[i + 21], passw[i], passh[i], bpp);
-      }
-      if(convert_to_rgba32 && (info.colorType != 6 || info.bitDepth != 8)) //conversion needed
-      {
-        std::vector<unsigned char> data = out;
-        error = convert(out, &data[0], info, info.width, info.height);
+          adam7Pass(image, &scanlinen[0], &scanlineo[0], &scanlines[passstart[i]], info.width, pattern[i], pattern[i + 7], pattern[i + 14], pattern[i + 21], passw[i], passh[i], bpp);
+        if(error) return;
+        if(converting) error = convert(pixels, image, info, info.width, info.height); //conversion needed
+        else if(!direct) std::memcpy(pixels, image, rawlength);
       }
     }
     void readPngHeader(const unsigned char* in, size_t inlength) //read the information from the header and store it in the Info
@@ -357,6 +618,7 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
       if(in[0] != 137 || in[1] != 80 || in[2] != 78 || in[3] != 71 || in[4] != 13 || in[5] != 10 || in[6] != 26 || in[7] != 10) { error = 28; return; } //no PNG signature
       if(in[12] != 'I' || in[13] != 'H' || in[14] != 'D' || in[15] != 'R') { error = 29; return; } //error: it doesn't start with a IHDR chunk!
       info.width = read32bitInt(&in[16]); info.height = read32bitInt(&in[20]);
+      if(info.width == 0 || info.height == 0) { error = 93; return; } //error: the image has no pixels
       info.bitDepth = in[24]; info.colorType = in[25];
       info.compressionMethod = in[26]; if(in[26] != 0) { error = 32; return; } //error: only compression method 0 is allowed in the specification
       info.filterMethod = in[27]; if(in[27] != 0) { error = 33; return; } //error: only filter method 0 is allowed in the specification
@@ -365,39 +627,40 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
     }
     void unFilterScanline(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon, size_t bytewidth, unsigned long filterType, size_t length)
     {
+      size_t done = pngsimd::unfilter(recon, scanline, precon, bytewidth, filterType, length), first = done > bytewidth ? done : bytewidth; //bytes done by the SIMD kernels, and where the loops past the first pixel start
       switch(filterType)
       {
         case 0: for(size_t i = 0; i < length; i++) recon[i] = scanline[i]; break;
         case 1:
-          for(size_t i =         0; i < bytewidth; i++) recon[i] = scanline[i];
-          for(size_t i = bytewidth; i <    length; i++) recon[i] = scanline[i] + recon[i - bytewidth];
+          for(size_t i =      done; i < bytewidth; i++) recon[i] = scanline[i];
+          for(size_t i =     first; i <    length; i++) recon[i] = scanline[i] + recon[i - bytewidth];
           break;
         case 2:
-          if(precon) for(size_t i = 0; i < length; i++) recon[i] = scanline[i] + precon[i];
+          if(precon) for(size_t i = done; i < length; i++) recon[i] = scanline[i] + precon[i];
           else       for(size_t i = 0; i < length; i++) recon[i] = scanline[i];
           break;
         case 3:
           if(precon)
           {
-            for(size_t i =         0; i < bytewidth; i++) recon[i] = scanline[i] + precon[i] / 2;
-            for(size_t i = bytewidth; i <    length; i++) recon[i] = scanline[i] + ((recon[i - bytewidth] + precon[i]) / 2);
+            for(size_t i =      done; i < bytewidth; i++) recon[i] = scanline[i] + precon[i] / 2;
+            for(size_t i =     first; i <    length; i++) recon[i] = scanline[i] + ((recon[i - bytewidth] + precon[i]) / 2);
           }
           else
           {
-            for(size_t i =         0; i < bytewidth; i++) recon[i] = scanline[i];
-            for(size_t i = bytewidth; i <    length; i++) recon[i] = scanline[i] + recon[i - bytewidth] / 2;
+            for(size_t i =      done; i < bytewidth; i++) recon[i] = scanline[i];
+            for(size_t i =     first; i <    length; i++) recon[i] = scanline[i] + recon[i - bytewidth] / 2;
           }
           break;
         case 4:
           if(precon)
           {
-            for(size_t i =         0; i < bytewidth; i++) recon[i] = scanline[i] + paethPredictor(0, precon[i], 0);
-            for(size_t i = bytewidth; i <    length; i++) recon[i] = scanline[i] + paethPredictor(recon[i - bytewidth], precon[i], precon[i - bytewidth]);
+            for(size_t i =      done; i < bytewidth; i++) recon[i] = scanline[i] + paethPredictor(0, precon[i], 0);
+            for(size_t i =     first; i <    length; i++) recon[i] = scanline[i] + paethPredictor(recon[i - bytewidth], precon[i], precon[i - bytewidth]);
           }
           else
           {
-            for(size_t i =         0; i < bytewidth; i++) recon[i] = scanline[i];
-            for(size_t i = bytewidth; i <    length; i++) recon[i] = scanline[i] + paethPredictor(recon[i - bytewidth], 0, 0);
+            for(size_t i =      done; i < bytewidth; i++) recon[i] = scanline[i];
+            for(size_t i =     first; i <    length; i++) recon[i] = scanline[i] + paethPredictor(recon[i - bytewidth], 0, 0);
           }
           break;
         default: error = 36; return; //error: unexisting filter type given
@@ -410,7 +673,7 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
       for(unsigned long y = 0; y < passh; y++)
       {
         unsigned char filterType = in[y * linelength], *prevline = (y == 0) ? 0 : lineo;
-        unFilterScanline(linen, &in[y * linelength + 1], prevline, bytewidth, filterType, (w * bpp + 7) / 8); if(error) return;
+        unFilterScanline(linen, &in[y * linelength + 1], prevline, bytewidth, filterType, linelength - 1); if(error) return;
         if(bpp >= 8) for(size_t i = 0; i < passw; i++) for(size_t b = 0; b < bytewidth; b++) //b = current byte of this pixel
           out[bytewidth * w * (passtop + spacey * y) + bytewidth * (passleft + spacex * i) + b] = linen[bytewidth * i + b];
         else for(size_t i = 0; i < passw; i++)
@@ -443,11 +706,9 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
       else if(info.colorType >= 4) return (info.colorType - 2) * info.bitDepth;
       else return info.bitDepth;
     }
-    int convert(std::vector<unsigned char>& out, const unsigned char* in, Info& infoIn, unsigned long w, unsigned long h)
-    { //converts from any color type to 32-bit. return value = LodePNG error code
+    int convert(unsigned char* out_, const unsigned char* in, Info& infoIn, unsigned long w, unsigned long h)
+    { //converts from any color type to 32-bit, into out_ which must have room for it. Lines of less than 8 bits per pixel are packed without padding. return value = LodePNG error code
       size_t numpixels = w * h, bp = 0;
-      out.resize(numpixels * 4);
-      unsigned char* out_ = out.empty() ? 0 : &out[0]; //faster if compiled without optimization
       if(infoIn.bitDepth == 8 && infoIn.colorType == 0) //greyscale
       for(size_t i = 0; i < numpixels; i++)
       {
@@ -455,13 +716,13 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
         out_[4 * i + 3] = (infoIn.key_defined && in[i] == infoIn.key_r) ? 0 : 255;
       }
       else if(infoIn.bitDepth == 8 && infoIn.colorType == 2) //RGB color
-      for(size_t i = 0; i < numpixels; i++)
+      for(size_t i = infoIn.key_defined ? 0 : pngsimd::convertRGB(out_, in, numpixels); i < numpixels; i++)
       {
         for(size_t c = 0; c < 3; c++) out_[4 * i + c] = in[3 * i + c];
         out_[4 * i + 3] = (infoIn.key_defined == 1 && in[3 * i + 0] == infoIn.key_r && in[3 * i + 1] == infoIn.key_g && in[3 * i + 2] == infoIn.key_b) ? 0 : 255;
       }
       else if(infoIn.bitDepth == 8 && infoIn.colorType == 3) //indexed color (palette)
-      for(size_t i = 0; i < numpixels; i++)
+      for(size_t i = pngsimd::convertPalette(out_, in, numpixels, infoIn.palette); i < numpixels; i++)
       {
         if(4U * in[i] >= infoIn.palette.size()) return 46;
         for(size_t c = 0; c < 4; c++) out_[4 * i + c] = infoIn.palette[4 * in[i] + c]; //get rgb colors from the palette
@@ -477,7 +738,7 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
       for(size_t i = 0; i < numpixels; i++)
       {
         out_[4 * i + 0] = out_[4 * i + 1] = out_[4 * i + 2] = in[2 * i];
-        out_[4 * i + 3] = (infoIn.key_defined && 256U * in[i] + in[i + 1] == infoIn.key_r) ? 0 : 255;
+        out_[4 * i + 3] = (infoIn.key_defined && 256U * in[2 * i] + in[2 * i + 1] == infoIn.key_r) ? 0 : 255;
       }
       else if(infoIn.bitDepth == 16 && infoIn.colorType == 2) //RGB color
       for(size_t i = 0; i < numpixels; i++)
@@ -514,7 +775,23 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
       return (unsigned char)((pa <= pb && pa <= pc) ? a : pb <= pc ? b : c);
     }
   };
-  PNG decoder; decoder.decode(out_image, in_png, in_size, convert_to_rgba32);
+  PNG decoder; decoder.scratch = scratch; decoder.decode(out_image, out_pixels, out_size, in_png, in_size, convert_to_rgba32);
   image_width = decoder.info.width; image_height = decoder.info.height;
   return decoder.error;
 }
+
+int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width, unsigned long& image_height, const unsigned char* in_png, size_t in_size, bool convert_to_rgba32, ce::LinearArena* scratch)
+{
+  return picoPNG(&out_image, 0, 0, image_width, image_height, in_png, in_size, convert_to_rgba32, scratch);
+}
+
+int decodePNGInto(unsigned char* out_pixels, size_t out_size, unsigned long& image_width, unsigned long& image_height, const unsigned char* in_png, size_t in_size, ce::LinearArena* scratch)
+{
+  if(out_pixels == 0) return 84; //there is nowhere to put the pixels
+  return picoPNG(0, out_pixels, out_size, image_width, image_height, in_png, in_size, true, scratch);
+}
+
+int getPNGSize(unsigned long& image_width, unsigned long& image_height, const unsigned char* in_png, size_t in_size)
+{
+  return picoPNG(0, 0, 0, image_width, image_height, in_png, in_size, true, 0);
+}
@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////
+//
+// cyberEngine
+// The MIT License (MIT)
+// Copyright (c) 2018 Jacob Neal
+//
+// Permission is hereby granted, free of charge, to any person 
+// obtaining a copy of this software and associated documentation 
+// files (the "Software"), to deal in the Software without restriction, 
+// including without limitation the rights to use, copy, modify, merge, 
+// publish, distribute, sublicense, and/or sell copies of the Software, 
+// and to permit persons to whom the Software is furnished to do so, 
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be 
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////
+// Converts the assets of OBJ models ahead of time, so that
+// loading them is faster. The textures of every model given are
+// converted into QOI files next to them (see TextureConverter).
+// With --chunks, the models are also converted into chunked
+// meshes (see ObjStreamConverter), for models too large to load
+// at once.
+//
+// Build and run from the build directory:
+//     make convert && ./convert.exe ../resources/models/nanosuit/nanosuit.obj
+//////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////
+// Headers
+//////////////////////////////////////////////////////////////
+#include <iostream>
+
+#include "Logger.hpp"
+#include "Mesh/ObjStreamConverter.hpp"
+#include "Mesh/TextureConverter.hpp"
+
+LOGGER_DECL_LIVE
+
+int main(int argc, char ** argv)
+{
+    bool chunks = argc > 1 && std::string(argv[1]) == "--chunks";
+    int firstModel = chunks ? 2 : 1;
+
+    if (argc <= firstModel)
+    {
+        std::cout << "Usage: convert.exe [--chunks] model.obj [model.obj ...]" << std::endl;
+        return 1;
+    }
+
+    bool success = true;
+
+    for (int model = firstModel; model < argc; ++model)
+    {
+        if (!ce::TextureConverter::convert(argv[model]))
+        {
+            LOG("Could not convert the textures of: " + std::string(argv[model]));
+            success = false;
+        }
+
+        if (chunks && !ce::ObjStreamConverter::convert(argv[model]))
+            success = false;
+    }
+
+    return success ? 0 : 1;
+}